@@ -0,0 +1,200 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ContentStore.h"
+#include "FileHashCache.h"
+#include "FileSystem.h"
+#include "Env.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDirIterator>
+#include <QRegularExpression>
+#include <QtConcurrentRun>
+#include <QDebug>
+
+ContentStore::ContentStore(const QString &root) : m_root(root)
+{
+}
+
+QStringList ContentStore::sharedFolders()
+{
+	return {"mods", "resourcepacks", "texturepacks"};
+}
+
+bool ContentStore::isShared(const QString &relativePath)
+{
+	static const QRegularExpression sharedRegex(
+		"^[.]?minecraft/(" + sharedFolders().join('|') + ")/[^/]+[.](jar|zip|litemod)$",
+		QRegularExpression::CaseInsensitiveOption);
+	return sharedRegex.match(QDir::fromNativeSeparators(relativePath)).hasMatch();
+}
+
+QString ContentStore::blobPath(const QByteArray &sha1) const
+{
+	auto hex = QString::fromLatin1(sha1.toHex());
+	return FS::PathCombine(m_root, "objects", hex.left(2) + "/" + hex);
+}
+
+bool ContentStore::validBlob(const QString &blob, const QByteArray &sha1)
+{
+	if (!QFile::exists(blob))
+	{
+		return false;
+	}
+	// somebody could have changed the blob in place through one of the links
+	if (ENV.fileHashes()->hash(blob).sha1 != sha1)
+	{
+		qWarning() << "Removing modified blob" << blob << "from the store";
+		QFile::remove(blob);
+		return false;
+	}
+	return true;
+}
+
+bool ContentStore::contains(const QString &path)
+{
+	QFileInfo info(path);
+	if (!info.isFile() || info.isSymLink())
+	{
+		return false;
+	}
+	auto hashes = ENV.fileHashes()->hash(path);
+	return hashes.isValid() && FS::sameFile(path, blobPath(hashes.sha1));
+}
+
+bool ContentStore::add(const QString &path)
+{
+	QFileInfo info(path);
+	if (!info.isFile() || info.isSymLink())
+	{
+		return false;
+	}
+	auto hashes = ENV.fileHashes()->hash(path);
+	if (!hashes.isValid())
+	{
+		return false;
+	}
+	auto blob = blobPath(hashes.sha1);
+	if (FS::sameFile(path, blob))
+	{
+		return true;
+	}
+	if (!validBlob(blob, hashes.sha1))
+	{
+		// the file itself becomes the blob
+		return FS::ensureFilePathExists(blob) && FS::hardLink(path, blob);
+	}
+
+	// replace the file with a link to the blob. Link next to it first, so it's never missing.
+	auto linked = path + ".store";
+	QFile::remove(linked);
+	if (!FS::hardLink(blob, linked))
+	{
+		return false;
+	}
+	if (!QFile::remove(path))
+	{
+		QFile::remove(linked);
+		return false;
+	}
+	if (!QFile::rename(linked, path))
+	{
+		qWarning() << "Couldn't put" << path << "back from the store";
+		QFile::remove(linked);
+		QFile::copy(blob, path);
+		return false;
+	}
+	return true;
+}
+
+ContentStore::Stats ContentStore::addInstance(const QString &instanceRoot)
+{
+	Stats stats;
+	QDir root(instanceRoot);
+	for (auto minecraftFolder : {"minecraft", ".minecraft"})
+	{
+		for (auto &shared : sharedFolders())
+		{
+			// never into subfolders, that's where the private files are
+			QDirIterator iter(FS::PathCombine(instanceRoot, minecraftFolder, shared), QDir::Files | QDir::Hidden);
+			while (iter.hasNext())
+			{
+				auto path = iter.next();
+				if (isShared(root.relativeFilePath(path)) && add(path))
+				{
+					stats.files++;
+					stats.bytes += iter.fileInfo().size();
+				}
+			}
+		}
+	}
+	qDebug() << "Shared" << stats.files << "files," << stats.bytes << "bytes of" << instanceRoot << "through the store";
+	return stats;
+}
+
+bool ContentStore::install(const QString &source, const QString &target)
+{
+	auto hashes = ENV.fileHashes()->hash(source);
+	if (!hashes.isValid())
+	{
+		return false;
+	}
+	auto blob = blobPath(hashes.sha1);
+	if (!validBlob(blob, hashes.sha1))
+	{
+		// copy, the source is not ours to tie to the store
+		auto partial = blob + ".part";
+		QFile::remove(partial);
+		if (!FS::ensureFilePathExists(blob) || !QFile::copy(source, partial) || !QFile::rename(partial, blob))
+		{
+			QFile::remove(partial);
+			return QFile::copy(source, target);
+		}
+	}
+	return FS::hardLink(blob, target) || QFile::copy(source, target);
+}
+
+ContentStore::Stats ContentStore::collectGarbage()
+{
+	Stats stats;
+	QDirIterator iter(FS::PathCombine(m_root, "objects"), QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+	while (iter.hasNext())
+	{
+		auto path = iter.next();
+		// leftovers of interrupted installs, or blobs only the store knows about
+		if (path.endsWith(".part") || FS::linkCount(path) == 1)
+		{
+			auto size = iter.fileInfo().size();
+			if (QFile::remove(path))
+			{
+				stats.files++;
+				stats.bytes += size;
+			}
+		}
+	}
+	qDebug() << "Removed" << stats.files << "unused files," << stats.bytes << "bytes from the store";
+	return stats;
+}
+
+QFuture<ContentStore::Stats> ContentStore::collectGarbageAsync()
+{
+	// doesn't touch this object, so it's fine if the store goes away in the meantime
+	QString root = m_root;
+	return QtConcurrent::run([root]()
+	{
+		return ContentStore(root).collectGarbage();
+	});
+}
@@ -0,0 +1,80 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QFuture>
+
+#include "multimc_logic_export.h"
+
+/*
+ * A content addressed store that lets instances share identical mods and resource packs.
+ *
+ * Every distinct file is kept once, as a blob named by its SHA-1. Files in instances are hard
+ * links to the blobs, so they look and behave like normal files and the store doesn't need an
+ * index: the links are the references. A blob nothing links to anymore is garbage.
+ *
+ * Only archives right inside the shared folders are shared. Mods also keep configs and other loose
+ * files in there, and resource packs can be unpacked folders. Those get written in place, so a
+ * write through one instance would change every other instance too.
+ *
+ * Files that can't be linked (other volume, FAT, ...) are simply left alone.
+ */
+class MULTIMC_LOGIC_EXPORT ContentStore
+{
+public:
+	struct Stats
+	{
+		int files = 0;
+		qint64 bytes = 0;
+	};
+
+	explicit ContentStore(const QString &root);
+
+	/// folders inside the minecraft folder of an instance that are shared through the store
+	static QStringList sharedFolders();
+
+	/// true if the file, relative to the instance root, is one the store shares
+	static bool isShared(const QString &relativePath);
+
+	/// where the blob with the given (raw) SHA-1 lives
+	QString blobPath(const QByteArray &sha1) const;
+
+	/// true if the file is a link to a blob
+	bool contains(const QString &path);
+
+	/// turn the file into a link to its blob, adding the file as the blob if there isn't one yet
+	bool add(const QString &path);
+
+	/// add all shared files of an instance. Returns how much is now shared.
+	Stats addInstance(const QString &instanceRoot);
+
+	/// make target a file with the contents of source, sharing the data through the store
+	bool install(const QString &source, const QString &target);
+
+	/// delete blobs nothing links to anymore. Returns what was deleted.
+	Stats collectGarbage();
+
+	/// same as collectGarbage(), but runs on the global thread pool
+	QFuture<Stats> collectGarbageAsync();
+
+private:
+	bool validBlob(const QString &blob, const QByteArray &sha1);
+
+	QString m_root;
+};
@@ -0,0 +1,101 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include "TestUtil.h"
+
+#include "ContentStore.h"
+#include "FileSystem.h"
+
+class ContentStoreTest : public QObject
+{
+	Q_OBJECT
+
+private
+slots:
+	void test_Share()
+	{
+		QTemporaryDir dir;
+		ContentStore store(FS::PathCombine(dir.path(), "store"));
+		QByteArray content(100000, 'm');
+		auto first = FS::PathCombine(dir.path(), "first");
+		auto second = FS::PathCombine(dir.path(), "second");
+		auto firstMod = FS::PathCombine(first, "minecraft/mods/mod.jar");
+		auto secondMod = FS::PathCombine(second, ".minecraft/mods/renamed.jar");
+		auto config = FS::PathCombine(first, "minecraft/config/mod.cfg");
+		FS::write(firstMod, content);
+		FS::write(secondMod, content);
+		FS::write(config, content);
+
+		auto stats = store.addInstance(first);
+		if (stats.files == 0)
+		{
+			QSKIP("The file system doesn't do hard links");
+		}
+		QCOMPARE(stats.files, 1);
+		QCOMPARE(stats.bytes, qint64(content.size()));
+		QCOMPARE(store.addInstance(second).files, 1);
+
+		QVERIFY(store.contains(firstMod));
+		QVERIFY(store.contains(secondMod));
+		QVERIFY(!store.contains(config));
+		QVERIFY(FS::sameFile(firstMod, secondMod));
+		QCOMPARE(FS::linkCount(firstMod), 3);
+		QCOMPARE(FS::read(secondMod), content);
+
+		// installing copies from outside, but shares what's already there
+		auto installed = FS::PathCombine(dir.path(), "third/minecraft/resourcepacks/pack.zip");
+		FS::ensureFilePathExists(installed);
+		QVERIFY(store.install(config, installed));
+		QVERIFY(FS::sameFile(installed, firstMod));
+		QVERIFY(!FS::sameFile(config, firstMod));
+
+		// nothing goes away while something links to it
+		QCOMPARE(store.collectGarbage().files, 0);
+		QFile::remove(firstMod);
+		QFile::remove(secondMod);
+		QCOMPARE(store.collectGarbage().files, 0);
+		QFile::remove(installed);
+		auto garbage = store.collectGarbage();
+		QCOMPARE(garbage.files, 1);
+		QCOMPARE(garbage.bytes, qint64(content.size()));
+	}
+
+	void test_PrivateFiles()
+	{
+		QTemporaryDir dir;
+		ContentStore store(FS::PathCombine(dir.path(), "store"));
+		QByteArray content(1000, 'c');
+		auto first = FS::PathCombine(dir.path(), "first");
+		auto second = FS::PathCombine(dir.path(), "second");
+		// mods keep their configs in mods/, resource packs can be unpacked folders
+		QStringList privateFiles = {"minecraft/mods/VoxelMods/config.txt", "minecraft/resourcepacks/Pack/pack.mcmeta",
+									"minecraft/mods/notes.txt"};
+		for (auto &file : privateFiles)
+		{
+			FS::write(FS::PathCombine(first, file), content);
+			FS::write(FS::PathCombine(second, file), content);
+		}
+		auto mod = FS::PathCombine(first, "minecraft/mods/mod.JAR");
+		FS::write(mod, content);
+
+		if (store.addInstance(first).files == 0)
+		{
+			QSKIP("The file system doesn't do hard links");
+		}
+		QCOMPARE(store.addInstance(second).files, 0);
+		QVERIFY(store.contains(mod));
+		for (auto &file : privateFiles)
+		{
+			QVERIFY(!ContentStore::isShared(file));
+			QVERIFY(!store.contains(FS::PathCombine(first, file)));
+			QVERIFY(!FS::sameFile(FS::PathCombine(first, file), FS::PathCombine(second, file)));
+		}
+		QVERIFY(ContentStore::isShared("minecraft/mods/mod.JAR"));
+		QVERIFY(ContentStore::isShared(".minecraft/resourcepacks/pack.zip"));
+		QVERIFY(ContentStore::isShared("minecraft/mods/liteloader.litemod"));
+		QVERIFY(!ContentStore::isShared("minecraft/config/mod.jar"));
+	}
+};
+
+QTEST_GUILESS_MAIN(ContentStoreTest)
+
+#include "ContentStore_test.moc"
@@ -1,5 +1,10 @@
 #include "Env.h"
 #include "net/HttpMetaCache.h"
+#include "net/NetScheduler.h"
+#include "FileHashCache.h"
+#include "minecraft/ModMetadataCache.h"
+#include "minecraft/WorldSummaryCache.h"
+#include "ContentStore.h"
 #include "BaseVersion.h"
 #include "BaseVersionList.h"
 #include <QDir>
@@ -17,11 +22,21 @@
 Env::Env()
 {
 	m_qnam = std::make_shared<QNetworkAccessManager>();
+	m_netScheduler = std::make_shared<NetScheduler>();
+	// only kept in memory until initHttpMetaCache() replaces it with a persistent one
+	m_fileHashes = std::make_shared<FileHashCache>();
+	m_modMetadata = std::make_shared<ModMetadataCache>();
+	m_worldSummaries = std::make_shared<WorldSummaryCache>();
 }
 
 void Env::destroy()
 {
 	m_metacache.reset();
+	m_netScheduler.reset();
+	m_fileHashes.reset();
+	m_modMetadata.reset();
+	m_worldSummaries.reset();
+	m_contentStore.reset();
 	m_qnam.reset();
 	m_versionLists.clear();
 }
@@ -43,6 +58,36 @@ std::shared_ptr< QNetworkAccessManager > Env::qnam()
 	return m_qnam;
 }
 
+std::shared_ptr< NetScheduler > Env::netScheduler()
+{
+	return m_netScheduler;
+}
+
+std::shared_ptr< FileHashCache > Env::fileHashes()
+{
+	return m_fileHashes;
+}
+
+std::shared_ptr<ModMetadataCache> Env::modMetadata()
+{
+	return m_modMetadata;
+}
+
+std::shared_ptr<WorldSummaryCache> Env::worldSummaries()
+{
+	return m_worldSummaries;
+}
+
+std::shared_ptr<ContentStore> Env::contentStore()
+{
+	return m_contentStore;
+}
+
+void Env::initContentStore(const QString &root)
+{
+	m_contentStore = std::make_shared<ContentStore>(root);
+}
+
 std::shared_ptr<IIconList> Env::icons()
 {
 	return m_iconlist;
@@ -164,6 +209,21 @@ void Env::initHttpMetaCache()
 	m_metacache->addBase("icons", QDir("cache/icons").absolutePath());
 	m_metacache->addBase("wonko", QDir("cache/wonko").absolutePath());
 	m_metacache->Load();
+
+	m_fileHashes = std::make_shared<FileHashCache>(QDir("hashcache").absolutePath());
+	m_fileHashes->load();
+
+	m_modMetadata = std::make_shared<ModMetadataCache>(QDir("modcache").absolutePath());
+	m_modMetadata->load();
+
+	m_worldSummaries = std::make_shared<WorldSummaryCache>(QDir("worldcache").absolutePath());
+	m_worldSummaries->load();
+}
+
+void Env::updateNetworkLimits(int maxConnections, int maxConnectionsPerHost)
+{
+	if (m_netScheduler)
+		m_netScheduler->setLimits(maxConnections, maxConnectionsPerHost);
 }
 
 void Env::updateProxySettings(QString proxyTypeStr, QString addr, int port, QString user, QString password)
@@ -9,6 +9,11 @@
 
 class QNetworkAccessManager;
 class HttpMetaCache;
+class NetScheduler;
+class FileHashCache;
+class ModMetadataCache;
+class WorldSummaryCache;
+class ContentStore;
 class BaseVersionList;
 class BaseVersion;
 class WonkoIndex;
@@ -33,6 +38,24 @@ public:
 
 	std::shared_ptr<HttpMetaCache> metacache();
 
+	/// the process-wide download scheduler, shared by all NetJobs
+	std::shared_ptr<NetScheduler> netScheduler();
+
+	/// the process-wide file hash cache
+	std::shared_ptr<FileHashCache> fileHashes();
+
+	/// the process-wide cache of what's inside mod files
+	std::shared_ptr<ModMetadataCache> modMetadata();
+
+	/// the process-wide cache of what's in world level.dat files
+	std::shared_ptr<WorldSummaryCache> worldSummaries();
+
+	/// the store instances share mods and resource packs through, null if it's turned off
+	std::shared_ptr<ContentStore> contentStore();
+
+	/// turn on the content store, kept in the given folder
+	void initContentStore(const QString &root);
+
 	std::shared_ptr<IIconList> icons();
 
 	/// init the cache. FIXME: possible future hook point
@@ -41,6 +64,9 @@ public:
 	/// Updates the application proxy settings from the settings object.
 	void updateProxySettings(QString proxyTypeStr, QString addr, int port, QString user, QString password);
 
+	/// Updates the global and per-host download connection limits.
+	void updateNetworkLimits(int maxConnections, int maxConnectionsPerHost);
+
 	/// get a version list by name
 	std::shared_ptr<BaseVersionList> getVersionList(QString component);
 
@@ -59,6 +85,11 @@ public:
 protected:
 	std::shared_ptr<QNetworkAccessManager> m_qnam;
 	std::shared_ptr<HttpMetaCache> m_metacache;
+	std::shared_ptr<NetScheduler> m_netScheduler;
+	std::shared_ptr<FileHashCache> m_fileHashes;
+	std::shared_ptr<ModMetadataCache> m_modMetadata;
+	std::shared_ptr<WorldSummaryCache> m_worldSummaries;
+	std::shared_ptr<ContentStore> m_contentStore;
 	std::shared_ptr<IIconList> m_iconlist;
 	QMap<QString, std::shared_ptr<BaseVersionList>> m_versionLists;
 	std::shared_ptr<WonkoIndex> m_wonkoIndex;
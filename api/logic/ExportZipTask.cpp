@@ -0,0 +1,415 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ExportZipTask.h"
+#include "FileSystem.h"
+
+#include <quazip.h>
+#include <quazipfile.h>
+#include <zlib.h>
+
+#include <QDir>
+#include <QFileInfo>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QtConcurrentRun>
+#include <QDebug>
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+// files bigger than this are not loaded into memory, the writer compresses them while copying
+const qint64 bigFileSize = 16 * 1024 * 1024;
+// how many bytes of files can be compressed ahead of the writer
+const qint64 maxPendingSize = 64 * 1024 * 1024;
+// how much of a file is looked at to decide if it's worth compressing
+const int probeSize = 64 * 1024;
+
+struct Slot
+{
+	ExportZipTask::Compressed result;
+	bool done = false;
+};
+
+struct Pipeline
+{
+	QMutex mutex;
+	QWaitCondition finished;
+	std::vector<Slot> slots;
+};
+
+class CompressJob : public QRunnable
+{
+public:
+	CompressJob(Pipeline &pipeline, int index, const ExportZipTask::Entry &entry)
+		: m_pipeline(pipeline), m_index(index), m_entry(entry)
+	{
+	}
+	void run() override
+	{
+		auto result = ExportZipTask::compress(m_entry);
+		QMutexLocker locker(&m_pipeline.mutex);
+		auto &slot = m_pipeline.slots[m_index];
+		slot.result = std::move(result);
+		slot.done = true;
+		m_pipeline.finished.wakeAll();
+	}
+
+private:
+	Pipeline &m_pipeline;
+	int m_index;
+	ExportZipTask::Entry m_entry;
+};
+
+void collectFolder(QList<ExportZipTask::Entry> &out, const QString &dir, const QString &origDir,
+				   const QString &prefix, const SeparatorPrefixTree<'/'> &blacklist, const QString &skip)
+{
+	QDir directory(dir);
+	QDir origDirectory(origDir);
+	if (dir != origDir)
+	{
+		QString internalDirName = origDirectory.relativeFilePath(dir);
+		if (!blacklist.covers(internalDirName))
+		{
+			ExportZipTask::Entry entry;
+			entry.path = dir;
+			entry.name = FS::PathCombine(prefix, internalDirName) + "/";
+			entry.folder = true;
+			out.append(entry);
+		}
+	}
+
+	for (auto &file : directory.entryInfoList(QDir::AllDirs | QDir::NoDotAndDotDot | QDir::Hidden))
+	{
+		if (file.isDir())
+		{
+			collectFolder(out, file.absoluteFilePath(), origDir, prefix, blacklist, skip);
+		}
+	}
+
+	for (auto &file : directory.entryInfoList(QDir::Files))
+	{
+		if (!file.isFile() || file.absoluteFilePath() == skip)
+		{
+			continue;
+		}
+		QString filename = origDirectory.relativeFilePath(file.absoluteFilePath());
+		if (blacklist.covers(filename))
+		{
+			continue;
+		}
+		ExportZipTask::Entry entry;
+		entry.path = file.absoluteFilePath();
+		entry.name = prefix.size() ? FS::PathCombine(prefix, filename) : filename;
+		entry.size = file.size();
+		out.append(entry);
+	}
+}
+}
+
+ExportZipTask::ExportZipTask(QString zipFile, QString dir, QString prefix, SeparatorPrefixTree<'/'> blacklist, QObject *parent)
+	: Task(parent), m_zipFile(zipFile), m_dir(dir), m_prefix(prefix), m_blacklist(blacklist)
+{
+	connect(&m_collectWatcher, SIGNAL(finished()), SLOT(collectFinished()));
+	connect(&m_writeWatcher, SIGNAL(finished()), SLOT(writeFinished()));
+}
+
+QList<ExportZipTask::Entry> ExportZipTask::collect(QString dir, QString prefix, SeparatorPrefixTree<'/'> blacklist, QString skip)
+{
+	QList<Entry> entries;
+	if (QDir(dir).exists())
+	{
+		collectFolder(entries, dir, dir, prefix, blacklist, skip);
+	}
+	return entries;
+}
+
+bool ExportZipTask::shouldStore(const QString &path, const QByteArray &head)
+{
+	static const QStringList compressedSuffixes = {
+		"jar", "zip", "litemod", "png", "jpg", "jpeg", "gif", "ogg", "mp3",
+		"gz", "xz", "bz2", "7z", "rar", "lzma", "mca", "mcr"
+	};
+	if (compressedSuffixes.contains(QFileInfo(path).suffix(), Qt::CaseInsensitive))
+	{
+		return true;
+	}
+	// too small to tell
+	if (head.size() < 1024)
+	{
+		return false;
+	}
+	// compressed or encrypted data has close to 8 bits of entropy per byte
+	qint64 counts[256] = {0};
+	for (auto byte : head)
+	{
+		counts[(uchar)byte]++;
+	}
+	double entropy = 0;
+	for (auto count : counts)
+	{
+		if (count)
+		{
+			double p = double(count) / head.size();
+			entropy -= p * std::log2(p);
+		}
+	}
+	return entropy > 7.5;
+}
+
+ExportZipTask::Compressed ExportZipTask::compress(const Entry &entry)
+{
+	Compressed result;
+	QFile file(entry.path);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		return result;
+	}
+	auto data = file.readAll();
+	result.size = data.size();
+	result.crc = crc32(crc32(0, nullptr, 0), (const Bytef *)data.constData(), data.size());
+	result.ok = true;
+
+	if (data.isEmpty() || shouldStore(entry.path, data.left(probeSize)))
+	{
+		result.data = data;
+		return result;
+	}
+
+	z_stream stream = {};
+	if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		result.ok = false;
+		return result;
+	}
+	QByteArray deflated;
+	deflated.resize(deflateBound(&stream, data.size()));
+	stream.next_in = (Bytef *)data.data();
+	stream.avail_in = data.size();
+	stream.next_out = (Bytef *)deflated.data();
+	stream.avail_out = deflated.size();
+	int status = deflate(&stream, Z_FINISH);
+	deflated.resize(stream.total_out);
+	deflateEnd(&stream);
+	if (status != Z_STREAM_END)
+	{
+		result.ok = false;
+		return result;
+	}
+	// not every file that looks compressible is
+	if (deflated.size() >= data.size())
+	{
+		result.data = data;
+		return result;
+	}
+	result.data = deflated;
+	result.method = Z_DEFLATED;
+	return result;
+}
+
+void ExportZipTask::executeTask()
+{
+	setStatus(tr("Looking for files to export..."));
+	m_collectWatcher.setFuture(QtConcurrent::run(&ExportZipTask::collect, m_dir, m_prefix, m_blacklist,
+												 QFileInfo(m_zipFile).absoluteFilePath()));
+}
+
+void ExportZipTask::collectFinished()
+{
+	if (m_aborted.load())
+	{
+		emitFailed(tr("Aborted."));
+		return;
+	}
+	m_entries = m_collectWatcher.result();
+	m_totalBytes = 0;
+	for (auto &entry : m_entries)
+	{
+		m_totalBytes += entry.size;
+	}
+	qDebug() << "Exporting" << m_entries.size() << "files," << m_totalBytes / (1024 * 1024) << "MiB into" << m_zipFile;
+	setStatus(tr("Compressing %1 files...").arg(m_entries.size()));
+	m_writeWatcher.setFuture(QtConcurrent::run(this, &ExportZipTask::writeArchive));
+}
+
+bool ExportZipTask::writeArchive()
+{
+	QDir().mkpath(QFileInfo(m_zipFile).absolutePath());
+	QuaZip zip(m_zipFile);
+	if (!zip.open(QuaZip::mdCreate))
+	{
+		m_error = tr("Couldn't create %1").arg(m_zipFile);
+		return false;
+	}
+
+	int threads = m_threads > 0 ? m_threads : QThread::idealThreadCount();
+	QThreadPool pool;
+	pool.setMaxThreadCount(qMax(1, threads));
+
+	Pipeline pipeline;
+	pipeline.slots.resize(m_entries.size());
+	auto inMemory = [](const Entry &entry)
+	{
+		return !entry.folder && entry.size <= bigFileSize;
+	};
+	int submitted = 0;
+	qint64 pendingSize = 0;
+	qint64 doneSize = 0;
+
+	for (int i = 0; i < m_entries.size() && m_error.isEmpty(); i++)
+	{
+		if (m_aborted.load())
+		{
+			break;
+		}
+		// keep the workers busy, but don't read the whole instance into memory
+		if (submitted < i)
+		{
+			submitted = i;
+		}
+		while (submitted < m_entries.size() && submitted - i < threads * 4)
+		{
+			auto &next = m_entries[submitted];
+			if (inMemory(next))
+			{
+				if (submitted != i && pendingSize + next.size > maxPendingSize)
+				{
+					break;
+				}
+				pendingSize += next.size;
+				pool.start(new CompressJob(pipeline, submitted, next));
+			}
+			submitted++;
+		}
+
+		auto &entry = m_entries[i];
+		QuaZipFile out(&zip);
+		if (entry.folder)
+		{
+			if (!out.open(QIODevice::WriteOnly, QuaZipNewInfo(entry.name, entry.path), 0, 0, 0))
+			{
+				m_error = tr("Couldn't add %1 to the archive").arg(entry.name);
+			}
+			out.close();
+			continue;
+		}
+
+		if (inMemory(entry))
+		{
+			Compressed compressed;
+			{
+				QMutexLocker locker(&pipeline.mutex);
+				while (!pipeline.slots[i].done)
+				{
+					pipeline.finished.wait(&pipeline.mutex);
+				}
+				compressed = std::move(pipeline.slots[i].result);
+			}
+			pendingSize -= entry.size;
+			if (!compressed.ok)
+			{
+				m_error = tr("Couldn't read %1").arg(entry.path);
+				break;
+			}
+			QuaZipNewInfo info(entry.name, entry.path);
+			info.uncompressedSize = compressed.size;
+			int level = compressed.method ? Z_DEFAULT_COMPRESSION : 0;
+			if (!out.open(QIODevice::WriteOnly, info, nullptr, compressed.crc, compressed.method, level, true) ||
+				out.write(compressed.data) != compressed.data.size())
+			{
+				m_error = tr("Couldn't add %1 to the archive").arg(entry.name);
+			}
+		}
+		else
+		{
+			// big files are copied in pieces, by this thread
+			QFile in(entry.path);
+			if (!in.open(QIODevice::ReadOnly))
+			{
+				m_error = tr("Couldn't read %1").arg(entry.path);
+				break;
+			}
+			int method = shouldStore(entry.path, in.peek(probeSize)) ? 0 : Z_DEFLATED;
+			int level = method ? Z_DEFAULT_COMPRESSION : 0;
+			if (!out.open(QIODevice::WriteOnly, QuaZipNewInfo(entry.name, entry.path), nullptr, 0, method, level))
+			{
+				m_error = tr("Couldn't add %1 to the archive").arg(entry.name);
+				break;
+			}
+			qint64 copied = 0;
+			QByteArray buffer;
+			while (!in.atEnd() && !m_aborted.load())
+			{
+				buffer = in.read(1024 * 1024);
+				if (buffer.isEmpty() || out.write(buffer) != buffer.size())
+				{
+					m_error = tr("Couldn't add %1 to the archive").arg(entry.name);
+					break;
+				}
+				copied += buffer.size();
+				setProgressFromThread(doneSize + copied, m_totalBytes);
+			}
+		}
+		out.close();
+		if (out.getZipError() != UNZ_OK && m_error.isEmpty())
+		{
+			m_error = tr("Couldn't add %1 to the archive").arg(entry.name);
+		}
+		doneSize += entry.size;
+		setProgressFromThread(doneSize, m_totalBytes);
+	}
+
+	// the jobs write into the pipeline, which has to outlive them
+	pool.clear();
+	pool.waitForDone();
+
+	zip.close();
+	if (m_error.isEmpty() && zip.getZipError() != 0)
+	{
+		m_error = tr("Couldn't finish writing %1").arg(m_zipFile);
+	}
+	return m_error.isEmpty() && !m_aborted.load();
+}
+
+void ExportZipTask::writeFinished()
+{
+	if (!m_writeWatcher.result())
+	{
+		QFile::remove(m_zipFile);
+		if (m_aborted.load())
+		{
+			emitFailed(tr("Aborted."));
+		}
+		else
+		{
+			qWarning() << "Export failed:" << m_error;
+			emitFailed(m_error);
+		}
+		return;
+	}
+	emitSucceeded();
+}
+
+bool ExportZipTask::abort()
+{
+	m_aborted.store(1);
+	m_collectWatcher.cancel();
+	return true;
+}
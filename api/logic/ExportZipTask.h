@@ -0,0 +1,109 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QFutureWatcher>
+#include <QAtomicInt>
+#include <QByteArray>
+
+#include "tasks/Task.h"
+#include "SeparatorPrefixTree.h"
+
+#include "multimc_logic_export.h"
+
+/*
+ * Packs a folder into a zip file in the background. Same result as MMCZip::compressDir.
+ *
+ * Files are compressed on all available cores and written into the archive in order.
+ * Files that are already compressed (jars, zips, images, sounds, or anything that looks random)
+ * are stored as they are.
+ */
+class MULTIMC_LOGIC_EXPORT ExportZipTask : public Task
+{
+	Q_OBJECT
+public:
+	/// One entry of the archive
+	struct Entry
+	{
+		/// file on disk, the folder itself for folders
+		QString path;
+		/// name inside the archive
+		QString name;
+		qint64 size = 0;
+		bool folder = false;
+	};
+
+	/// How an entry ends up in the archive
+	struct Compressed
+	{
+		QByteArray data;
+		quint32 crc = 0;
+		qint64 size = 0;
+		/// 0 for stored, Z_DEFLATED for deflated
+		int method = 0;
+		bool ok = false;
+	};
+
+	ExportZipTask(QString zipFile, QString dir, QString prefix = QString(),
+				  SeparatorPrefixTree<'/'> blacklist = SeparatorPrefixTree<'/'>(), QObject *parent = 0);
+	virtual ~ExportZipTask() {};
+
+	bool canAbort() const override
+	{
+		return true;
+	}
+
+	/// walk the folder in the same order and with the same blacklist rules as MMCZip::compressSubDir
+	static QList<Entry> collect(QString dir, QString prefix, SeparatorPrefixTree<'/'> blacklist, QString skip);
+
+	/// true if compressing the file would be a waste of time
+	static bool shouldStore(const QString &path, const QByteArray &head);
+
+	/// read and compress a file, in memory
+	static Compressed compress(const Entry &entry);
+
+	/// set how many threads compress the files. 0 means one per core.
+	void setThreadCount(int threads)
+	{
+		m_threads = threads;
+	}
+
+public slots:
+	bool abort() override;
+
+protected:
+	void executeTask() override;
+
+private slots:
+	void collectFinished();
+	void writeFinished();
+
+private:
+	bool writeArchive();
+
+private:
+	QString m_zipFile;
+	QString m_dir;
+	QString m_prefix;
+	SeparatorPrefixTree<'/'> m_blacklist;
+	QList<Entry> m_entries;
+	qint64 m_totalBytes = 0;
+	int m_threads = 0;
+	QAtomicInt m_aborted;
+	QString m_error;
+	QFutureWatcher<QList<Entry>> m_collectWatcher;
+	QFutureWatcher<bool> m_writeWatcher;
+};
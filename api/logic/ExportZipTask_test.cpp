@@ -0,0 +1,89 @@
+#include <QTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include "TestUtil.h"
+
+#include "ExportZipTask.h"
+#include "MMCZip.h"
+#include <FileSystem.h>
+
+#include <quazip.h>
+#include <quazipfile.h>
+
+class ExportZipTaskTest : public QObject
+{
+	Q_OBJECT
+
+	QMap<QString, QByteArray> readZip(const QString &path)
+	{
+		QMap<QString, QByteArray> contents;
+		QuaZip zip(path);
+		if (!zip.open(QuaZip::mdUnzip))
+		{
+			return contents;
+		}
+		QuaZipFile file(&zip);
+		for (bool more = zip.goToFirstFile(); more; more = zip.goToNextFile())
+		{
+			file.open(QIODevice::ReadOnly);
+			contents.insert(zip.getCurrentFileName(), file.readAll());
+			file.close();
+		}
+		return contents;
+	}
+
+private
+slots:
+	void test_ShouldStore()
+	{
+		QVERIFY(ExportZipTask::shouldStore("mods/thing.jar", QByteArray()));
+		QVERIFY(ExportZipTask::shouldStore("screenshots/a.PNG", QByteArray()));
+		QVERIFY(!ExportZipTask::shouldStore("config/thing.cfg", QByteArray(4096, 'a')));
+
+		QByteArray noise(4096, 0);
+		quint32 seed = 1;
+		for (int i = 0; i < noise.size(); i++)
+		{
+			seed = seed * 1103515245 + 12345;
+			noise[i] = char(seed >> 24);
+		}
+		QVERIFY(ExportZipTask::shouldStore("data.bin", noise));
+	}
+
+	void test_SameAsCompressDir()
+	{
+		QTemporaryDir dir;
+		QString root = FS::PathCombine(dir.path(), "instance");
+		FS::write(FS::PathCombine(root, "options.txt"), "fov:70\n");
+		FS::write(FS::PathCombine(root, "config/a.cfg"), QByteArray(100000, 'x'));
+		FS::write(FS::PathCombine(root, "mods/mod.jar"), "not really a jar");
+		FS::write(FS::PathCombine(root, "saves/world/level.dat"), "level");
+		FS::write(FS::PathCombine(root, "logs/latest.log"), "log");
+
+		SeparatorPrefixTree<'/'> blacklist;
+		blacklist.insert("logs");
+		blacklist.insert("saves/world/level.dat");
+
+		QString expectedPath = FS::PathCombine(dir.path(), "expected.zip");
+		QVERIFY(MMCZip::compressDir(expectedPath, root, "Instance", &blacklist));
+
+		QString exportPath = FS::PathCombine(dir.path(), "export.zip");
+		ExportZipTask task(exportPath, root, "Instance", blacklist);
+		task.setThreadCount(3);
+		QSignalSpy spy(&task, SIGNAL(finished()));
+		task.start();
+		QVERIFY(spy.wait());
+		QVERIFY(task.successful());
+
+		auto expected = readZip(expectedPath);
+		auto exported = readZip(exportPath);
+		QVERIFY(!expected.isEmpty());
+		QCOMPARE(exported.keys(), expected.keys());
+		QCOMPARE(exported, expected);
+		QVERIFY(!exported.contains("Instance/logs/latest.log"));
+	}
+};
+
+QTEST_GUILESS_MAIN(ExportZipTaskTest)
+
+#include "ExportZipTask_test.moc"
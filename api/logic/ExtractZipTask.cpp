@@ -0,0 +1,310 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ExtractZipTask.h"
+
+#include <quazip.h>
+#include <quazipfile.h>
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+#include <QMutex>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QtConcurrentRun>
+#include <QDebug>
+
+#if defined(Q_OS_LINUX)
+#include <fcntl.h>
+#endif
+
+namespace
+{
+const qint64 bufferSize = 1024 * 1024;
+
+struct Item
+{
+	QString path;
+	unz64_file_pos position;
+	qint64 size = 0;
+	bool folder = false;
+	QFile::Permissions permissions;
+};
+
+struct Shared
+{
+	QString zipFile;
+	QList<Item> items;
+	qint64 total = 0;
+	ExtractZipTask::ProgressFn progress;
+	const QAtomicInt *aborted = nullptr;
+
+	QAtomicInt next;
+	QAtomicInt failed;
+	QMutex mutex;
+	qint64 done = 0;
+
+	void addProgress(qint64 bytes)
+	{
+		if (!progress)
+		{
+			return;
+		}
+		QMutexLocker locker(&mutex);
+		done += bytes;
+		progress(done, total);
+	}
+	bool stopped() const
+	{
+		return failed.load() || (aborted && aborted->load());
+	}
+};
+
+bool extractItem(QuaZip &zip, const Item &item, Shared &shared)
+{
+	if (item.folder)
+	{
+		if (item.permissions != 0)
+		{
+			QFile(item.path).setPermissions(item.permissions);
+		}
+		return true;
+	}
+
+	unz64_file_pos position = item.position;
+	if (unzGoToFilePos64(zip.getUnzFile(), &position) != UNZ_OK)
+	{
+		return false;
+	}
+	QuaZipFile inFile(&zip);
+	if (!inFile.open(QIODevice::ReadOnly))
+	{
+		return false;
+	}
+
+	QFile outFile(item.path);
+	if (!outFile.open(QIODevice::WriteOnly))
+	{
+		return false;
+	}
+#if defined(Q_OS_LINUX)
+	// reserve the space in one go. Only a hint, the writes below will fail if the disk is full.
+	if (item.size > 0)
+	{
+		posix_fallocate(outFile.handle(), 0, item.size);
+	}
+#endif
+
+	QByteArray buffer(bufferSize, Qt::Uninitialized);
+	while (!inFile.atEnd())
+	{
+		if (shared.stopped())
+		{
+			return false;
+		}
+		qint64 readLen = inFile.read(buffer.data(), bufferSize);
+		if (readLen <= 0 || outFile.write(buffer.constData(), readLen) != readLen)
+		{
+			return false;
+		}
+		shared.addProgress(readLen);
+	}
+	outFile.close();
+	// the CRC is checked here
+	inFile.close();
+	if (inFile.getZipError() != UNZ_OK || outFile.error() != QFileDevice::NoError)
+	{
+		return false;
+	}
+	if (item.permissions != 0)
+	{
+		outFile.setPermissions(item.permissions);
+	}
+	return true;
+}
+
+class ExtractWorker : public QRunnable
+{
+public:
+	explicit ExtractWorker(Shared &shared) : m_shared(shared)
+	{
+	}
+	void run() override
+	{
+		QuaZip zip(m_shared.zipFile);
+		// QuaZipFile only opens files after goToFirstFile() or similar, the position is set for each file below
+		if (!zip.open(QuaZip::mdUnzip) || !zip.goToFirstFile())
+		{
+			m_shared.failed.store(1);
+			return;
+		}
+		while (!m_shared.stopped())
+		{
+			int index = m_shared.next.fetchAndAddRelaxed(1);
+			if (index >= m_shared.items.size())
+			{
+				break;
+			}
+			auto &item = m_shared.items[index];
+			if (!extractItem(zip, item, m_shared))
+			{
+				qWarning() << "Failed to extract" << item.path << "from" << m_shared.zipFile;
+				m_shared.failed.store(1);
+				break;
+			}
+		}
+	}
+
+private:
+	Shared &m_shared;
+};
+}
+
+ExtractZipTask::ExtractZipTask(QString zipFile, QString target, QString subdir, QObject *parent)
+	: Task(parent), m_zipFile(zipFile), m_target(target), m_subdir(subdir)
+{
+	connect(&m_watcher, SIGNAL(finished()), SLOT(extractFinished()));
+}
+
+QStringList ExtractZipTask::extract(QString zipFile, QString target, QString subdir, int threads,
+									ProgressFn progress, const QAtomicInt *aborted)
+{
+	Shared shared;
+	shared.zipFile = zipFile;
+	shared.progress = progress;
+	shared.aborted = aborted;
+
+	// read the central directory once
+	{
+		QuaZip zip(zipFile);
+		if (!zip.open(QuaZip::mdUnzip))
+		{
+			return QStringList();
+		}
+		QDir directory(target);
+		for (bool more = zip.goToFirstFile(); more; more = zip.goToNextFile())
+		{
+			QuaZipFileInfo64 info;
+			if (!zip.getCurrentFileInfo(&info))
+			{
+				return QStringList();
+			}
+			QString name = info.name;
+			if (!name.startsWith(subdir))
+			{
+				continue;
+			}
+			name.remove(0, subdir.size());
+			Item item;
+			item.path = directory.absoluteFilePath(name);
+			if (name.isEmpty())
+			{
+				item.path += "/";
+			}
+			item.folder = item.path.endsWith('/');
+			item.size = info.uncompressedSize;
+			item.permissions = info.getPermissions();
+			unzGetFilePos64(zip.getUnzFile(), &item.position);
+			shared.items.append(item);
+			shared.total += item.size;
+		}
+	}
+	if (shared.items.isEmpty())
+	{
+		return QStringList();
+	}
+
+	// the workers only ever create files
+	QSet<QString> folders;
+	for (auto &item : shared.items)
+	{
+		folders.insert(item.folder ? item.path : QFileInfo(item.path).absolutePath());
+	}
+	for (auto &folder : folders)
+	{
+		if (!QDir().mkpath(folder))
+		{
+			qWarning() << "Failed to create" << folder;
+			return QStringList();
+		}
+	}
+
+	int threadCount = threads > 0 ? threads : QThread::idealThreadCount();
+	threadCount = qBound(1, threadCount, shared.items.size());
+	QThreadPool pool;
+	pool.setMaxThreadCount(threadCount);
+	for (int i = 0; i < threadCount; i++)
+	{
+		pool.start(new ExtractWorker(shared));
+	}
+	pool.waitForDone();
+
+	QStringList extracted;
+	for (auto &item : shared.items)
+	{
+		extracted.append(item.path);
+	}
+	if (shared.stopped())
+	{
+		for (auto &item : shared.items)
+		{
+			if (!item.folder)
+			{
+				QFile::remove(item.path);
+			}
+		}
+		return QStringList();
+	}
+	return extracted;
+}
+
+void ExtractZipTask::executeTask()
+{
+	setStatus(tr("Extracting %1...").arg(QFileInfo(m_zipFile).fileName()));
+	auto progress = [this](qint64 done, qint64 total)
+	{
+		setProgressFromThread(done, total);
+	};
+	auto zipFile = m_zipFile, target = m_target, subdir = m_subdir;
+	auto aborted = &m_aborted;
+	m_watcher.setFuture(QtConcurrent::run([=]()
+	{
+		return extract(zipFile, target, subdir, 0, progress, aborted);
+	}));
+}
+
+void ExtractZipTask::extractFinished()
+{
+	m_extracted = m_watcher.result();
+	if (m_aborted.load())
+	{
+		emitFailed(tr("Aborted."));
+		return;
+	}
+	if (m_extracted.isEmpty())
+	{
+		emitFailed(tr("Failed to extract %1").arg(m_zipFile));
+		return;
+	}
+	emitSucceeded();
+}
+
+bool ExtractZipTask::abort()
+{
+	m_aborted.store(1);
+	return true;
+}
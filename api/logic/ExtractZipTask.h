@@ -0,0 +1,80 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QFutureWatcher>
+#include <QAtomicInt>
+#include <QStringList>
+#include <functional>
+
+#include "tasks/Task.h"
+
+#include "multimc_logic_export.h"
+
+/*
+ * Extracts a zip file, or a folder inside of it, in the background.
+ *
+ * The central directory is read once, all the folders are created up front and the files are
+ * inflated on all available cores, each worker with its own handle to the archive.
+ */
+class MULTIMC_LOGIC_EXPORT ExtractZipTask : public Task
+{
+	Q_OBJECT
+public:
+	typedef std::function<void(qint64 done, qint64 total)> ProgressFn;
+
+	ExtractZipTask(QString zipFile, QString target, QString subdir = QString(), QObject *parent = 0);
+	virtual ~ExtractZipTask() {};
+
+	bool canAbort() const override
+	{
+		return true;
+	}
+
+	/// the full paths of the extracted files, once the task succeeded
+	QStringList extractedFiles() const
+	{
+		return m_extracted;
+	}
+
+	/**
+	 * Extract everything in zipFile that starts with subdir into target, with subdir removed from the names.
+	 *
+	 * \param threads how many threads inflate files, 0 means one per core
+	 * \param progress called from the worker threads with the number of bytes written so far
+	 * \param aborted stops the extraction when set
+	 * \return The list of the full paths of the files extracted, empty on failure.
+	 */
+	static QStringList extract(QString zipFile, QString target, QString subdir = QString(), int threads = 0,
+							   ProgressFn progress = ProgressFn(), const QAtomicInt *aborted = nullptr);
+
+public slots:
+	bool abort() override;
+
+protected:
+	void executeTask() override;
+
+private slots:
+	void extractFinished();
+
+private:
+	QString m_zipFile;
+	QString m_target;
+	QString m_subdir;
+	QStringList m_extracted;
+	QAtomicInt m_aborted;
+	QFutureWatcher<QStringList> m_watcher;
+};
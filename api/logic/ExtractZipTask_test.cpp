@@ -0,0 +1,73 @@
+#include <QTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include "TestUtil.h"
+
+#include "ExtractZipTask.h"
+#include "MMCZip.h"
+#include <FileSystem.h>
+
+class ExtractZipTaskTest : public QObject
+{
+	Q_OBJECT
+
+	QString makeZip(const QString &root)
+	{
+		QString folder = FS::PathCombine(root, "contents");
+		FS::write(FS::PathCombine(folder, "instance.cfg"), "name=test\n");
+		FS::write(FS::PathCombine(folder, "minecraft/config/a.cfg"), QByteArray(300000, 'a'));
+		FS::write(FS::PathCombine(folder, "minecraft/saves/world/level.dat"), "level");
+		QDir().mkpath(FS::PathCombine(folder, "minecraft/empty"));
+		QString zip = FS::PathCombine(root, "test.zip");
+		MMCZip::compressDir(zip, folder, "pack");
+		return zip;
+	}
+
+private
+slots:
+	void test_Extract()
+	{
+		QTemporaryDir dir;
+		auto zip = makeZip(dir.path());
+		QString target = FS::PathCombine(dir.path(), "out");
+		auto extracted = ExtractZipTask::extract(zip, target, QString(), 3);
+		QVERIFY(!extracted.isEmpty());
+		QCOMPARE(FS::read(FS::PathCombine(target, "pack/instance.cfg")), QByteArray("name=test\n"));
+		QCOMPARE(FS::read(FS::PathCombine(target, "pack/minecraft/config/a.cfg")), QByteArray(300000, 'a'));
+		QVERIFY(QFileInfo(FS::PathCombine(target, "pack/minecraft/empty")).isDir());
+		QVERIFY(extracted.contains(QDir(target).absoluteFilePath("pack/minecraft/saves/world/level.dat")));
+	}
+
+	void test_ExtractSubDir()
+	{
+		QTemporaryDir dir;
+		auto zip = makeZip(dir.path());
+		QString target = FS::PathCombine(dir.path(), "world");
+		auto extracted = ExtractZipTask::extract(zip, target, "pack/minecraft/saves/world/");
+		QVERIFY(!extracted.isEmpty());
+		QCOMPARE(FS::read(FS::PathCombine(target, "level.dat")), QByteArray("level"));
+		QVERIFY(!QFile::exists(FS::PathCombine(target, "instance.cfg")));
+	}
+
+	void test_Task()
+	{
+		QTemporaryDir dir;
+		auto zip = makeZip(dir.path());
+		ExtractZipTask task(zip, FS::PathCombine(dir.path(), "out"));
+		QSignalSpy spy(&task, SIGNAL(finished()));
+		task.start();
+		QVERIFY(spy.wait());
+		QVERIFY(task.successful());
+		QVERIFY(QFile::exists(FS::PathCombine(dir.path(), "out/pack/instance.cfg")));
+
+		ExtractZipTask broken(FS::PathCombine(dir.path(), "missing.zip"), FS::PathCombine(dir.path(), "out2"));
+		QSignalSpy brokenSpy(&broken, SIGNAL(finished()));
+		broken.start();
+		QVERIFY(brokenSpy.wait());
+		QVERIFY(!broken.successful());
+	}
+};
+
+QTEST_GUILESS_MAIN(ExtractZipTaskTest)
+
+#include "ExtractZipTask_test.moc"
@@ -0,0 +1,83 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FileHashCache.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QCryptographicHash>
+#include <QtConcurrentRun>
+#include <QDebug>
+
+namespace
+{
+// "MMCH"
+const quint32 indexMagic = 0x4d4d4348;
+const quint32 indexVersion = 1;
+// files are hashed in pieces of this size
+const int chunkSize = 256 * 1024;
+}
+
+FileHashCache::FileHashCache(const QString &indexPath) : m_cache(indexMagic, indexVersion, indexPath)
+{
+}
+
+FileHashes FileHashCache::hashFile(const QString &path)
+{
+	QFile input(path);
+	if (!input.open(QIODevice::ReadOnly))
+	{
+		return FileHashes();
+	}
+	QCryptographicHash md5(QCryptographicHash::Md5);
+	QCryptographicHash sha1(QCryptographicHash::Sha1);
+	QByteArray buffer(chunkSize, Qt::Uninitialized);
+	while (true)
+	{
+		qint64 read = input.read(buffer.data(), buffer.size());
+		if (read < 0)
+		{
+			qWarning() << "Failed to read" << path << "for hashing:" << input.errorString();
+			return FileHashes();
+		}
+		if (read == 0)
+		{
+			break;
+		}
+		md5.addData(buffer.constData(), read);
+		sha1.addData(buffer.constData(), read);
+	}
+	FileHashes out;
+	out.md5 = md5.result();
+	out.sha1 = sha1.result();
+	return out;
+}
+
+FileHashes FileHashCache::hash(const QString &path)
+{
+	FileHashes hashes;
+	QString key = QFileInfo(path).absoluteFilePath();
+	m_cache.get(key, hashes, [&key](FileHashes &out)
+	{
+		out = hashFile(key);
+		return out.isValid();
+	});
+	return hashes;
+}
+
+QFuture<FileHashes> FileHashCache::hashAsync(const QString &path)
+{
+	return QtConcurrent::run(this, &FileHashCache::hash, path);
+}
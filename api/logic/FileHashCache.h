@@ -0,0 +1,82 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <QFuture>
+
+#include "PersistentFileCache.h"
+
+#include "multimc_logic_export.h"
+
+/// Raw (not hex encoded) digests of a file
+struct FileHashes
+{
+	QByteArray md5;
+	QByteArray sha1;
+
+	bool isValid() const
+	{
+		return !md5.isEmpty();
+	}
+};
+
+inline QDataStream &operator<<(QDataStream &out, const FileHashes &hashes)
+{
+	return out << hashes.md5 << hashes.sha1;
+}
+
+inline QDataStream &operator>>(QDataStream &in, FileHashes &hashes)
+{
+	return in >> hashes.md5 >> hashes.sha1;
+}
+
+/*
+ * Hashes files and remembers the results.
+ *
+ * Files are read in fixed size chunks and MD5 and SHA-1 are computed in the same pass.
+ * Results are kept in a PersistentFileCache, so a file is only hashed again when it changes.
+ *
+ * All the hashing methods are thread safe.
+ */
+class MULTIMC_LOGIC_EXPORT FileHashCache
+{
+public:
+	/// supply path to the index file, or nothing for a cache that only lives in memory
+	explicit FileHashCache(const QString &indexPath = QString());
+
+	/// get the hashes of a file. Invalid hashes are returned if the file can't be read.
+	FileHashes hash(const QString &path);
+
+	/// same as hash(), but runs on the global thread pool
+	QFuture<FileHashes> hashAsync(const QString &path);
+
+	/// hash a file without looking into the cache
+	static FileHashes hashFile(const QString &path);
+
+	void load()
+	{
+		m_cache.load();
+	}
+	void save()
+	{
+		m_cache.save();
+	}
+
+private:
+	PersistentFileCache<FileHashes> m_cache;
+};
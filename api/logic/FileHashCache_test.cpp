@@ -0,0 +1,96 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include "TestUtil.h"
+
+#include "FileHashCache.h"
+#include <FileSystem.h>
+
+class FileHashCacheTest : public QObject
+{
+	Q_OBJECT
+private
+slots:
+	void test_Streaming()
+	{
+		QTemporaryDir dir;
+		QString path = FS::PathCombine(dir.path(), "data");
+		// a few chunks plus something extra
+		QByteArray data(1024 * 1024 + 123, 'x');
+		for (int i = 0; i < data.size(); i++)
+		{
+			data[i] = char(i * 31);
+		}
+		FS::write(path, data);
+
+		auto hashes = FileHashCache::hashFile(path);
+		QCOMPARE(hashes.md5, QCryptographicHash::hash(data, QCryptographicHash::Md5));
+		QCOMPARE(hashes.sha1, QCryptographicHash::hash(data, QCryptographicHash::Sha1));
+		QVERIFY(!FileHashCache::hashFile(FS::PathCombine(dir.path(), "missing")).isValid());
+	}
+
+	void test_Persistence()
+	{
+		QTemporaryDir dir;
+		QString index = FS::PathCombine(dir.path(), "hashcache");
+		QString path = FS::PathCombine(dir.path(), "data");
+		FS::write(path, "hello");
+		{
+			FileHashCache cache(index);
+			QCOMPARE(cache.hash(path).md5, QCryptographicHash::hash("hello", QCryptographicHash::Md5));
+		}
+		QVERIFY(QFile::exists(index));
+		FileHashCache cache(index);
+		cache.load();
+		QCOMPARE(cache.hash(path).sha1, QCryptographicHash::hash("hello", QCryptographicHash::Sha1));
+
+		// a changed file gets hashed again
+		FS::write(path, "hello world");
+		QCOMPARE(cache.hash(path).md5,
+				 QCryptographicHash::hash("hello world", QCryptographicHash::Md5));
+	}
+
+	void test_Async()
+	{
+		QTemporaryDir dir;
+		QString path = FS::PathCombine(dir.path(), "data");
+		FS::write(path, "async");
+		FileHashCache cache;
+		auto future = cache.hashAsync(path);
+		future.waitForFinished();
+		QCOMPARE(future.result().md5, QCryptographicHash::hash("async", QCryptographicHash::Md5));
+	}
+
+	void test_Benchmark()
+	{
+		QTemporaryDir dir;
+		QStringList paths;
+		QByteArray data(64 * 1024, 'a');
+		for (int i = 0; i < 500; i++)
+		{
+			QString path = FS::PathCombine(dir.path(), QString::number(i));
+			FS::write(path, data + QByteArray::number(i));
+			paths.append(path);
+		}
+		FileHashCache cache;
+		QElapsedTimer timer;
+		timer.start();
+		for (auto &path : paths)
+		{
+			cache.hash(path);
+		}
+		qDebug() << "Hashing 500 files:" << timer.elapsed() << "ms";
+		QBENCHMARK
+		{
+			for (auto &path : paths)
+			{
+				cache.hash(path);
+			}
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN(FileHashCacheTest)
+
+#include "FileHashCache_test.moc"
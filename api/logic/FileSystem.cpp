@@ -110,6 +110,10 @@ bool copy::operator()(const QString &offset)
 			qWarning() << "Cannot create path!";
 			return false;
 		}
+		if(m_linkFilter && m_linkFilter->matches(offset) && hardLink(src, dst))
+		{
+			return true;
+		}
 		return QFile::copy(src, dst);
 	}
 	else if(currentSrc.isDir())
@@ -148,6 +152,131 @@ bool copy::operator()(const QString &offset)
 #include <windows.h>
 #include <string>
 #endif
+#if defined Q_OS_UNIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+#if defined Q_OS_LINUX
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+static bool reflink(const QString &src, const QString &dst)
+{
+#if defined Q_OS_LINUX && defined FICLONE
+	// btrfs, xfs and friends can share the data without the risks of a hard link
+	int in = ::open(QFile::encodeName(src).constData(), O_RDONLY);
+	if (in < 0)
+	{
+		return false;
+	}
+	int out = ::open(QFile::encodeName(dst).constData(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+	bool cloned = false;
+	if (out >= 0)
+	{
+		cloned = ::ioctl(out, FICLONE, in) == 0;
+		::close(out);
+		if (!cloned)
+		{
+			::unlink(QFile::encodeName(dst).constData());
+		}
+	}
+	::close(in);
+	return cloned;
+#else
+	Q_UNUSED(src);
+	Q_UNUSED(dst);
+	return false;
+#endif
+}
+
+bool linkOrCopy(const QString &src, const QString &dst)
+{
+	if (reflink(src, dst) || hardLink(src, dst))
+	{
+		return true;
+	}
+	// different volumes, FAT, ...
+	return QFile::copy(src, dst);
+}
+
+bool cloneOrCopy(const QString &src, const QString &dst)
+{
+	return reflink(src, dst) || QFile::copy(src, dst);
+}
+
+bool hardLink(const QString &src, const QString &dst)
+{
+#if defined Q_OS_UNIX
+	return ::link(QFile::encodeName(src).constData(), QFile::encodeName(dst).constData()) == 0;
+#elif defined Q_OS_WIN32
+	auto srcW = QDir::toNativeSeparators(src).toStdWString();
+	auto dstW = QDir::toNativeSeparators(dst).toStdWString();
+	return CreateHardLinkW(dstW.c_str(), srcW.c_str(), NULL);
+#else
+	return false;
+#endif
+}
+
+#if defined Q_OS_WIN32
+static bool fileInformation(const QString &path, BY_HANDLE_FILE_INFORMATION &info)
+{
+	auto pathW = QDir::toNativeSeparators(path).toStdWString();
+	HANDLE file = CreateFileW(pathW.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+							  NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	bool ok = GetFileInformationByHandle(file, &info);
+	CloseHandle(file);
+	return ok;
+}
+#endif
+
+int linkCount(const QString &path)
+{
+#if defined Q_OS_UNIX
+	struct stat st;
+	if (::stat(QFile::encodeName(path).constData(), &st) != 0)
+	{
+		return 0;
+	}
+	return int(st.st_nlink);
+#elif defined Q_OS_WIN32
+	BY_HANDLE_FILE_INFORMATION info;
+	if (!fileInformation(path, info))
+	{
+		return 0;
+	}
+	return int(info.nNumberOfLinks);
+#else
+	return 0;
+#endif
+}
+
+bool sameFile(const QString &a, const QString &b)
+{
+#if defined Q_OS_UNIX
+	struct stat stA, stB;
+	if (::stat(QFile::encodeName(a).constData(), &stA) != 0 || ::stat(QFile::encodeName(b).constData(), &stB) != 0)
+	{
+		return false;
+	}
+	return stA.st_dev == stB.st_dev && stA.st_ino == stB.st_ino;
+#elif defined Q_OS_WIN32
+	BY_HANDLE_FILE_INFORMATION infoA, infoB;
+	if (!fileInformation(a, infoA) || !fileInformation(b, infoB))
+	{
+		return false;
+	}
+	return infoA.dwVolumeSerialNumber == infoB.dwVolumeSerialNumber && infoA.nFileIndexHigh == infoB.nFileIndexHigh &&
+		   infoA.nFileIndexLow == infoB.nFileIndexLow;
+#else
+	return QFileInfo(a).canonicalFilePath() == QFileInfo(b).canonicalFilePath();
+#endif
+}
+
 bool deletePath(QString path)
 {
 	bool OK = true;
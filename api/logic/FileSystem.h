@@ -59,6 +59,12 @@ public:
 		m_blacklist = filter;
 		return *this;
 	}
+	/// hard link files that match instead of copying them, where possible
+	copy & linkFiles(const IPathMatcher * filter)
+	{
+		m_linkFilter = filter;
+		return *this;
+	}
 	bool operator()()
 	{
 		return operator()(QString());
@@ -70,10 +76,40 @@ private:
 private:
 	bool m_followSymlinks = true;
 	const IPathMatcher * m_blacklist = nullptr;
+	const IPathMatcher * m_linkFilter = nullptr;
 	QDir m_src;
 	QDir m_dst;
 };
 
+/**
+ * Make dst a file with the same contents as src, as cheaply as the filesystem allows:
+ * a reflink (copy on write clone), then a hard link, then a plain copy.
+ * dst must not exist.
+ */
+MULTIMC_LOGIC_EXPORT bool linkOrCopy(const QString &src, const QString &dst);
+
+/**
+ * Like linkOrCopy, but never makes a hard link: changing dst in place never changes src.
+ * dst must not exist.
+ */
+MULTIMC_LOGIC_EXPORT bool cloneOrCopy(const QString &src, const QString &dst);
+
+/**
+ * Make dst a hard link to src. dst must not exist.
+ * Fails on filesystems that don't have hard links and across volumes.
+ */
+MULTIMC_LOGIC_EXPORT bool hardLink(const QString &src, const QString &dst);
+
+/**
+ * Number of hard links to a file, 0 if it can't be determined.
+ */
+MULTIMC_LOGIC_EXPORT int linkCount(const QString &path);
+
+/**
+ * True if both paths lead to the same file on disk, like two hard links do.
+ */
+MULTIMC_LOGIC_EXPORT bool sameFile(const QString &a, const QString &b);
+
 /**
  * Delete a folder recursively
  */
@@ -0,0 +1,244 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QDir>
+#include <QFileInfo>
+#include <QList>
+#include <QHash>
+#include <QFutureWatcher>
+#include <QtConcurrentMap>
+#include <QTimer>
+#include <QDebug>
+
+#include <algorithm>
+#include <functional>
+
+#include "ListModelDiff.h"
+
+/// how long a watched folder has to stay quiet before it is looked at again, in ms
+const int folderSettleInterval = 250;
+
+/*
+ * Copying a bunch of files into a watched folder fires one event per file. The model restarts the
+ * timer on every event and only looks at the folder once the timer fires.
+ */
+inline void setupFolderSettleTimer(QTimer &timer, QObject *receiver, const char *slot)
+{
+	timer.setSingleShot(true);
+	timer.setInterval(folderSettleInterval);
+	QObject::connect(&timer, SIGNAL(timeout()), receiver, slot);
+}
+
+/*
+ * Keeps the items of a list model backed by a folder up to date, through ListModelDiff.
+ *
+ * updateAsync() lists what the cache already knows right away. Everything else is scanned on
+ * the global thread pool and slots into the list as soon as it's done. A rescan asked for while
+ * one is running happens once it's done.
+ *
+ * The model owns this and has to be a friend of ListModelDiff.
+ */
+template <typename Model, typename T> class FolderModelScan
+{
+public:
+	/// What the scan needs to know about the items
+	struct Functions
+	{
+		/// unique key of an item, used to match old and new items up
+		QString (*key)(const T &);
+		/// true if nothing visible about the item changed
+		bool (*same)(const T &, const T &);
+		/// order of the list
+		bool (*lessThan)(const T &, const T &);
+		/// true if the entry should be looked at at all, nullptr for all entries
+		bool (*accepts)(const QFileInfo &);
+		/// true if scan() would have to look inside the entry instead of asking a cache
+		bool (*needsScan)(const QFileInfo &);
+		/// turn an entry into an item. Runs on worker threads.
+		T (*scan)(const QFileInfo &);
+		/// true if the item goes into the list, nullptr for all items
+		bool (*shown)(const T &);
+	};
+
+	FolderModelScan(Model *model, QDir &dir, QList<T> &items, Functions functions)
+		: m_model(model), m_dir(dir), m_items(items), m_fn(functions)
+	{
+		QObject::connect(&m_watcher, &QFutureWatcherBase::resultReadyAt, model, [this](int index)
+		{
+			resultReady(index);
+		});
+		QObject::connect(&m_watcher, &QFutureWatcherBase::finished, model, [this]()
+		{
+			finished();
+		});
+	}
+
+	/// called whenever a round of updates changed the list
+	void onChanged(std::function<void()> callback)
+	{
+		m_onChanged = callback;
+	}
+
+	/// scan everything on all cores and wait for it. Replaces whatever a background scan would come up with.
+	void update()
+	{
+		cancel();
+		m_dir.refresh();
+		QList<QFileInfo> entries;
+		for (auto &entry : m_dir.entryInfoList())
+		{
+			if (accepts(entry))
+			{
+				entries.append(entry);
+			}
+		}
+		QList<T> updated;
+		for (auto &item : QtConcurrent::blockingMapped(entries, m_fn.scan))
+		{
+			if (shown(item))
+			{
+				updated.append(item);
+			}
+		}
+		std::sort(updated.begin(), updated.end(), m_fn.lessThan);
+		m_changed |= ListModelDiff::apply(m_model, m_items, updated, m_fn.key, m_fn.same);
+		notify();
+	}
+
+	void updateAsync()
+	{
+		if (m_watcher.isRunning())
+		{
+			m_scanAgain = true;
+			return;
+		}
+
+		m_dir.refresh();
+		QHash<QString, int> listed;
+		for (int i = 0; i < m_items.size(); i++)
+		{
+			listed.insert(m_fn.key(m_items[i]), i);
+		}
+		QList<T> known;
+		QList<QFileInfo> unknown;
+		for (auto &entry : m_dir.entryInfoList())
+		{
+			if (!accepts(entry))
+			{
+				continue;
+			}
+			if (m_fn.needsScan(entry))
+			{
+				unknown.append(entry);
+				// keep showing what we had until the scan says otherwise
+				auto iter = listed.find(entry.filePath());
+				if (iter != listed.end())
+				{
+					known.append(m_items[*iter]);
+				}
+				continue;
+			}
+			auto item = m_fn.scan(entry);
+			if (shown(item))
+			{
+				known.append(item);
+			}
+		}
+		std::sort(known.begin(), known.end(), m_fn.lessThan);
+		m_changed |= ListModelDiff::apply(m_model, m_items, known, m_fn.key, m_fn.same);
+
+		if (unknown.isEmpty())
+		{
+			notify();
+			return;
+		}
+		qDebug() << "Scanning" << unknown.size() << "entries in" << m_dir.absolutePath();
+		m_watcher.setFuture(QtConcurrent::mapped(unknown, m_fn.scan));
+	}
+
+	/// stop the background scan and forget about any pending rescan
+	void cancel()
+	{
+		m_watcher.cancel();
+		m_watcher.waitForFinished();
+		m_scanAgain = false;
+	}
+
+private:
+	bool accepts(const QFileInfo &entry) const
+	{
+		return !m_fn.accepts || m_fn.accepts(entry);
+	}
+
+	bool shown(const T &item) const
+	{
+		return !m_fn.shown || m_fn.shown(item);
+	}
+
+	void resultReady(int index)
+	{
+		auto item = m_watcher.resultAt(index);
+		auto updated = m_items;
+		for (int i = 0; i < updated.size(); i++)
+		{
+			if (m_fn.key(updated[i]) == m_fn.key(item))
+			{
+				updated.removeAt(i);
+				break;
+			}
+		}
+		if (shown(item))
+		{
+			auto position = std::lower_bound(updated.begin(), updated.end(), item, m_fn.lessThan);
+			updated.insert(position, item);
+		}
+		m_changed |= ListModelDiff::apply(m_model, m_items, updated, m_fn.key, m_fn.same);
+	}
+
+	void finished()
+	{
+		if (m_watcher.isCanceled())
+		{
+			return;
+		}
+		if (m_scanAgain)
+		{
+			m_scanAgain = false;
+			updateAsync();
+			return;
+		}
+		notify();
+	}
+
+	void notify()
+	{
+		if (m_changed && m_onChanged)
+		{
+			m_onChanged();
+		}
+		m_changed = false;
+	}
+
+	Model *m_model;
+	QDir &m_dir;
+	QList<T> &m_items;
+	Functions m_fn;
+	QFutureWatcher<T> m_watcher;
+	std::function<void()> m_onChanged;
+	bool m_scanAgain = false;
+	bool m_changed = false;
+};
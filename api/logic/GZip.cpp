@@ -1,6 +1,21 @@
 #include "GZip.h"
 #include <zlib.h>
 #include <QByteArray>
+#include <QBuffer>
+#include <QtEndian>
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+// compressed data goes through buffers of this size
+const int bufferSize = 64 * 1024;
+// zlib counts in uInt, big reads and writes go through it in pieces of this size
+const qint64 maxChunk = 1 << 30;
+// the best deflate can do, used to tell a believable gzip trailer from a broken one
+const qint64 maxRatio = 1032;
+}
 
 bool GZip::unzip(const QByteArray &compressedBytes, QByteArray &uncompressedBytes)
 {
@@ -10,52 +25,57 @@ bool GZip::unzip(const QByteArray &compressedBytes, QByteArray &uncompressedByte
 		return true;
 	}
 
-	unsigned uncompLength = compressedBytes.size();
-	uncompressedBytes.clear();
-	uncompressedBytes.resize(uncompLength);
-
-	z_stream strm;
-	memset(&strm, 0, sizeof(strm));
-	strm.next_in = (Bytef *)compressedBytes.data();
-	strm.avail_in = compressedBytes.size();
-
-	bool done = false;
-
-	if (inflateInit2(&strm, (16 + MAX_WBITS)) != Z_OK)
+	QBuffer buffer;
+	buffer.setData(compressedBytes);
+	buffer.open(QIODevice::ReadOnly);
+	GZipReader reader(&buffer);
+	if (!reader.open(QIODevice::ReadOnly | QIODevice::Unbuffered))
 	{
 		return false;
 	}
 
-	int err = Z_OK;
+	// the trailer knows how big the result is, so it usually takes exactly one allocation
+	qint64 expected = reader.uncompressedSize();
+	if (expected < 0 || expected > qint64(compressedBytes.size()) * maxRatio)
+	{
+		expected = compressedBytes.size();
+	}
+	const int maxSize = std::numeric_limits<int>::max() / 2;
+	uncompressedBytes.clear();
+	uncompressedBytes.resize(int(std::min<qint64>(expected, maxSize)));
 
-	while (!done)
+	int total = 0;
+	while (true)
 	{
-		// If our output buffer is too small
-		if (strm.total_out >= uncompLength)
+		if (total == uncompressedBytes.size())
 		{
-			uncompressedBytes.resize(uncompLength * 2);
-			uncompLength *= 2;
+			// full: either done, or the trailer was wrong
+			char probe;
+			auto got = reader.read(&probe, 1);
+			if (got <= 0)
+			{
+				break;
+			}
+			if (uncompressedBytes.size() >= maxSize)
+			{
+				return false;
+			}
+			uncompressedBytes.resize(std::min(std::max(uncompressedBytes.size() * 2, 4096), maxSize));
+			uncompressedBytes[total++] = probe;
+			continue;
 		}
-
-		strm.next_out = (Bytef *)(uncompressedBytes.data() + strm.total_out);
-		strm.avail_out = uncompLength - strm.total_out;
-
-		// Inflate another chunk.
-		err = inflate(&strm, Z_SYNC_FLUSH);
-		if (err == Z_STREAM_END)
-			done = true;
-		else if (err != Z_OK)
+		auto got = reader.read(uncompressedBytes.data() + total, uncompressedBytes.size() - total);
+		if (got <= 0)
 		{
 			break;
 		}
+		total += int(got);
 	}
-
-	if (inflateEnd(&strm) != Z_OK || !done)
+	if (reader.hasError())
 	{
 		return false;
 	}
-
-	uncompressedBytes.resize(strm.total_out);
+	uncompressedBytes.resize(total);
 	return true;
 }
 
@@ -67,49 +87,268 @@ bool GZip::zip(const QByteArray &uncompressedBytes, QByteArray &compressedBytes)
 		return true;
 	}
 
-	unsigned compLength = std::min(uncompressedBytes.size(), 16);
 	compressedBytes.clear();
-	compressedBytes.resize(compLength);
+	QBuffer buffer(&compressedBytes);
+	buffer.open(QIODevice::WriteOnly);
+	GZipWriter writer(&buffer);
+	if (!writer.open(QIODevice::WriteOnly))
+	{
+		return false;
+	}
+	if (writer.write(uncompressedBytes) != uncompressedBytes.size())
+	{
+		return false;
+	}
+	return writer.finish();
+}
 
-	z_stream zs;
-	memset(&zs, 0, sizeof(zs));
+GZipReader::GZipReader(QIODevice *source, QObject *parent) : QIODevice(parent), m_source(source)
+{
+}
 
-	if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, (16 + MAX_WBITS), 8, Z_DEFAULT_STRATEGY) != Z_OK)
+GZipReader::~GZipReader()
+{
+	close();
+}
+
+bool GZipReader::open(OpenMode mode)
+{
+	if (mode & WriteOnly)
+	{
+		setErrorString("GZipReader can only read");
+		return false;
+	}
+	m_stream.reset(new z_stream());
+	if (inflateInit2(m_stream.get(), 16 + MAX_WBITS) != Z_OK)
 	{
+		m_stream.reset();
+		setErrorString("Couldn't initialize zlib");
 		return false;
 	}
+	m_input.resize(bufferSize);
+	m_finished = false;
+	m_error = false;
+
+	// ISIZE, the last 4 bytes
+	m_uncompressedSize = -1;
+	if (!m_source->isSequential())
+	{
+		auto start = m_source->pos();
+		auto end = m_source->size();
+		// smallest possible gzip file: 10 byte header, empty deflate stream, 8 byte trailer
+		if (end - start >= 20 && m_source->seek(end - 4))
+		{
+			uchar trailer[4];
+			if (m_source->read(reinterpret_cast<char *>(trailer), 4) == 4)
+			{
+				m_uncompressedSize = qFromLittleEndian<quint32>(trailer);
+			}
+			m_source->seek(start);
+		}
+	}
+	return QIODevice::open(mode);
+}
 
-	zs.next_in = (Bytef*)uncompressedBytes.data();
-	zs.avail_in = uncompressedBytes.size();
+void GZipReader::close()
+{
+	if (m_stream)
+	{
+		inflateEnd(m_stream.get());
+		m_stream.reset();
+	}
+	QIODevice::close();
+}
+
+bool GZipReader::atEnd() const
+{
+	return (m_finished || m_error) && QIODevice::atEnd();
+}
 
-	int ret;
-	compressedBytes.resize(uncompressedBytes.size());
+void GZipReader::fail(const QString &reason)
+{
+	m_error = true;
+	setErrorString(reason);
+}
+
+bool GZipReader::refill()
+{
+	auto got = m_source->read(m_input.data(), m_input.size());
+	if (got <= 0)
+	{
+		return false;
+	}
+	m_stream->next_in = reinterpret_cast<Bytef *>(m_input.data());
+	m_stream->avail_in = uInt(got);
+	return true;
+}
+
+bool GZipReader::nextMember()
+{
+	// the magic can be split between two reads
+	while (m_stream->avail_in < 2)
+	{
+		int kept = int(m_stream->avail_in);
+		if (kept)
+		{
+			m_input[0] = char(m_stream->next_in[0]);
+		}
+		auto got = m_source->read(m_input.data() + kept, m_input.size() - kept);
+		m_stream->next_in = reinterpret_cast<Bytef *>(m_input.data());
+		m_stream->avail_in = uInt(kept);
+		if (got <= 0)
+		{
+			return false;
+		}
+		m_stream->avail_in += uInt(got);
+	}
+	return m_stream->next_in[0] == 0x1f && m_stream->next_in[1] == 0x8b;
+}
 
-	unsigned offset = 0;
-	unsigned temp = 0;
-	do
+qint64 GZipReader::readData(char *data, qint64 maxSize)
+{
+	if (m_error || !m_stream)
+	{
+		return -1;
+	}
+	qint64 total = 0;
+	while (total < maxSize && !m_finished)
 	{
-		auto remaining = compressedBytes.size() - offset;
-		if(remaining < 1)
+		if (m_stream->avail_in == 0 && !refill())
 		{
-			compressedBytes.resize(compressedBytes.size() * 2);
+			fail("Unexpected end of gzip data");
+			break;
 		}
-		zs.next_out = (Bytef *) (compressedBytes.data() + offset);
-		temp = zs.avail_out = compressedBytes.size() - offset;
-		ret = deflate(&zs, Z_FINISH);
-		offset += temp - zs.avail_out;
-	} while (ret == Z_OK);
+		m_stream->next_out = reinterpret_cast<Bytef *>(data + total);
+		m_stream->avail_out = uInt(std::min(maxSize - total, maxChunk));
+		auto before = m_stream->avail_out;
+		int status = inflate(m_stream.get(), Z_NO_FLUSH);
+		total += before - m_stream->avail_out;
+		if (status == Z_STREAM_END)
+		{
+			if (nextMember())
+			{
+				inflateReset(m_stream.get());
+			}
+			else
+			{
+				// whatever else is there (zero padding, ...) is ignored, like gzip does
+				m_finished = true;
+			}
+		}
+		else if (status != Z_OK && status != Z_BUF_ERROR)
+		{
+			fail(m_stream->msg ? QString::fromLatin1(m_stream->msg) : QString("Broken gzip data"));
+			break;
+		}
+	}
+	if (m_error && total == 0)
+	{
+		return -1;
+	}
+	return total;
+}
 
-	compressedBytes.resize(offset);
+GZipWriter::GZipWriter(QIODevice *target, int level, QObject *parent)
+	: QIODevice(parent), m_target(target), m_level(level)
+{
+}
+
+GZipWriter::~GZipWriter()
+{
+	close();
+}
 
-	if (deflateEnd(&zs) != Z_OK)
+bool GZipWriter::open(OpenMode mode)
+{
+	if (mode & ReadOnly)
 	{
+		setErrorString("GZipWriter can only write");
 		return false;
 	}
-
-	if (ret != Z_STREAM_END)
+	m_stream.reset(new z_stream());
+	if (deflateInit2(m_stream.get(), m_level, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
 	{
+		m_stream.reset();
+		setErrorString("Couldn't initialize zlib");
 		return false;
 	}
-	return true;
-}
\ No newline at end of file
+	m_output.resize(bufferSize);
+	m_finished = false;
+	m_error = false;
+	return QIODevice::open(mode);
+}
+
+void GZipWriter::close()
+{
+	if (isOpen())
+	{
+		finish();
+	}
+	QIODevice::close();
+}
+
+bool GZipWriter::deflateSome(int flush)
+{
+	while (true)
+	{
+		m_stream->next_out = reinterpret_cast<Bytef *>(m_output.data());
+		m_stream->avail_out = uInt(m_output.size());
+		int status = deflate(m_stream.get(), flush);
+		if (status == Z_STREAM_ERROR)
+		{
+			m_error = true;
+			setErrorString("zlib failed to compress");
+			return false;
+		}
+		qint64 produced = m_output.size() - m_stream->avail_out;
+		if (produced && m_target->write(m_output.constData(), produced) != produced)
+		{
+			m_error = true;
+			setErrorString(m_target->errorString());
+			return false;
+		}
+		if (flush == Z_FINISH ? status == Z_STREAM_END : m_stream->avail_in == 0 && m_stream->avail_out != 0)
+		{
+			return true;
+		}
+	}
+}
+
+qint64 GZipWriter::writeData(const char *data, qint64 size)
+{
+	if (m_error || m_finished || !m_stream)
+	{
+		return -1;
+	}
+	qint64 remaining = size;
+	while (remaining > 0)
+	{
+		auto chunk = std::min(remaining, maxChunk);
+		m_stream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+		m_stream->avail_in = uInt(chunk);
+		if (!deflateSome(Z_NO_FLUSH))
+		{
+			return -1;
+		}
+		data += chunk;
+		remaining -= chunk;
+	}
+	return size;
+}
+
+bool GZipWriter::finish()
+{
+	if (!m_stream)
+	{
+		return !m_error;
+	}
+	if (!m_finished && !m_error)
+	{
+		m_stream->avail_in = 0;
+		deflateSome(Z_FINISH);
+		m_finished = true;
+	}
+	deflateEnd(m_stream.get());
+	m_stream.reset();
+	return !m_error;
+}
@@ -1,8 +1,12 @@
 #pragma once
 #include <QByteArray>
+#include <QIODevice>
+#include <memory>
 
 #include "multimc_logic_export.h"
 
+struct z_stream_s;
+
 class MULTIMC_LOGIC_EXPORT GZip
 {
 public:
@@ -10,3 +14,102 @@ public:
 	static bool zip(const QByteArray &uncompressedBytes, QByteArray &compressedBytes);
 };
 
+/*
+ * Reads gzip compressed data from another device, inflating it as it's read.
+ *
+ * Only a fixed size input buffer is kept, the data is inflated straight into what is passed to read().
+ * Open it with QIODevice::Unbuffered to avoid the extra copy through the QIODevice buffer.
+ * The source has to be open and stay alive while this is used.
+ */
+class MULTIMC_LOGIC_EXPORT GZipReader : public QIODevice
+{
+public:
+	explicit GZipReader(QIODevice *source, QObject *parent = nullptr);
+	virtual ~GZipReader();
+
+	/// only ReadOnly is supported
+	virtual bool open(OpenMode mode) override;
+	virtual void close() override;
+	virtual bool isSequential() const override
+	{
+		return true;
+	}
+	virtual bool atEnd() const override;
+
+	/**
+	 * Size of the data once inflated, as recorded at the end of the file (modulo 4 GiB).
+	 * Only known after open(), when the source can seek. -1 otherwise.
+	 */
+	qint64 uncompressedSize() const
+	{
+		return m_uncompressedSize;
+	}
+
+	/// true if the data turned out to be broken or truncated
+	bool hasError() const
+	{
+		return m_error;
+	}
+
+protected:
+	virtual qint64 readData(char *data, qint64 maxSize) override;
+	virtual qint64 writeData(const char *, qint64) override
+	{
+		return -1;
+	}
+
+private:
+	bool refill();
+	/// after the end of a member: true if another one follows, like in `cat a.gz b.gz`
+	bool nextMember();
+	void fail(const QString &reason);
+
+	QIODevice *m_source;
+	std::unique_ptr<z_stream_s> m_stream;
+	QByteArray m_input;
+	qint64 m_uncompressedSize = -1;
+	bool m_finished = false;
+	bool m_error = false;
+};
+
+/*
+ * Writes gzip compressed data to another device, deflating it as it's written.
+ *
+ * Only a fixed size output buffer is kept. The data is complete once finish() or close() is called.
+ * The target has to be open and stay alive while this is used.
+ */
+class MULTIMC_LOGIC_EXPORT GZipWriter : public QIODevice
+{
+public:
+	explicit GZipWriter(QIODevice *target, int level = -1, QObject *parent = nullptr);
+	virtual ~GZipWriter();
+
+	/// only WriteOnly is supported
+	virtual bool open(OpenMode mode) override;
+	/// calls finish()
+	virtual void close() override;
+	virtual bool isSequential() const override
+	{
+		return true;
+	}
+
+	/// write out everything that's left. Returns false if anything failed along the way.
+	bool finish();
+
+protected:
+	virtual qint64 readData(char *, qint64) override
+	{
+		return -1;
+	}
+	virtual qint64 writeData(const char *data, qint64 size) override;
+
+private:
+	bool deflateSome(int flush);
+
+	QIODevice *m_target;
+	int m_level;
+	std::unique_ptr<z_stream_s> m_stream;
+	QByteArray m_output;
+	bool m_finished = false;
+	bool m_error = false;
+};
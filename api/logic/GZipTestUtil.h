@@ -0,0 +1,21 @@
+#pragma once
+
+#include <QByteArray>
+
+class GZipTestUtil
+{
+public:
+	// something that compresses like a game log does
+	static QByteArray makeLog(int size)
+	{
+		QByteArray log;
+		log.reserve(size + 200);
+		for (int i = 0; log.size() < size; i++)
+		{
+			log.append("[12:34:" + QByteArray::number(i % 60) + "] [Client thread/INFO]: Loaded " +
+					   QByteArray::number(i) + " things from modname-" + QByteArray::number(i % 97) + ".jar\n");
+		}
+		log.resize(size);
+		return log;
+	}
+};
@@ -0,0 +1,92 @@
+#include <QTest>
+#include <QBuffer>
+#include <QElapsedTimer>
+#include "TestUtil.h"
+
+#include "GZip.h"
+#include "GZipTestUtil.h"
+
+class GZipBenchmark : public QObject, private GZipTestUtil
+{
+	Q_OBJECT
+
+private
+slots:
+	void benchmark_Log()
+	{
+		auto log = makeLog(64 * 1024 * 1024);
+
+		QElapsedTimer timer;
+		timer.start();
+		QByteArray compressed;
+		QVERIFY(GZip::zip(log, compressed));
+		auto zipTime = timer.nsecsElapsed();
+
+		// what GZip::unzip used to do: start at the compressed size and double until it fits
+		timer.restart();
+		QByteArray doubled;
+		{
+			QBuffer source;
+			source.setData(compressed);
+			source.open(QIODevice::ReadOnly);
+			GZipReader reader(&source);
+			QVERIFY(reader.open(QIODevice::ReadOnly | QIODevice::Unbuffered));
+			doubled.resize(compressed.size());
+			int total = 0;
+			while (true)
+			{
+				if (total == doubled.size())
+				{
+					doubled.resize(doubled.size() * 2);
+				}
+				auto got = reader.read(doubled.data() + total, doubled.size() - total);
+				if (got <= 0)
+				{
+					break;
+				}
+				total += int(got);
+			}
+			doubled.resize(total);
+		}
+		auto doublingTime = timer.nsecsElapsed();
+		QCOMPARE(doubled, log);
+		doubled.clear();
+
+		// sized from the gzip trailer
+		timer.restart();
+		QByteArray presized;
+		QVERIFY(GZip::unzip(compressed, presized));
+		auto presizedTime = timer.nsecsElapsed();
+		QCOMPARE(presized, log);
+		presized.clear();
+
+		// never holding more than a chunk
+		timer.restart();
+		qint64 streamed = 0;
+		{
+			QBuffer source;
+			source.setData(compressed);
+			source.open(QIODevice::ReadOnly);
+			GZipReader reader(&source);
+			QVERIFY(reader.open(QIODevice::ReadOnly | QIODevice::Unbuffered));
+			QByteArray chunk(64 * 1024, Qt::Uninitialized);
+			qint64 got;
+			while ((got = reader.read(chunk.data(), chunk.size())) > 0)
+			{
+				streamed += got;
+			}
+		}
+		auto streamingTime = timer.nsecsElapsed();
+		QCOMPARE(streamed, qint64(log.size()));
+
+		qDebug() << log.size() << "bytes of log," << compressed.size() << "compressed:";
+		qDebug() << "  zip:" << zipTime / 1000 << "us";
+		qDebug() << "  unzip, doubling the buffer:" << doublingTime / 1000 << "us";
+		qDebug() << "  unzip, sized from the trailer:" << presizedTime / 1000 << "us";
+		qDebug() << "  GZipReader, 64 KiB chunks:" << streamingTime / 1000 << "us";
+	}
+};
+
+QTEST_GUILESS_MAIN(GZipBenchmark)
+
+#include "GZip_benchmark.moc"
@@ -1,7 +1,9 @@
 #include <QTest>
+#include <QBuffer>
 #include "TestUtil.h"
 
 #include "GZip.h"
+#include "GZipTestUtil.h"
 #include <random>
 
 void fib(int &prev, int &cur)
@@ -11,9 +13,24 @@ void fib(int &prev, int &cur)
 	cur = ret;
 }
 
-class GZipTest : public QObject
+class GZipTest : public QObject, private GZipTestUtil
 {
 	Q_OBJECT
+
+	static QByteArray readInChunks(QIODevice &device, int chunkSize)
+	{
+		QByteArray result;
+		while (true)
+		{
+			auto chunk = device.read(chunkSize);
+			if (chunk.isEmpty())
+			{
+				return result;
+			}
+			result.append(chunk);
+		}
+	}
+
 private
 slots:
 
@@ -50,6 +67,83 @@ slots:
 			fib(prev, cur);
 		} while (cur < size);
 	}
+
+	void test_Streaming()
+	{
+		auto log = makeLog(1024 * 1024 + 13);
+		QByteArray compressed;
+		{
+			QBuffer target(&compressed);
+			target.open(QIODevice::WriteOnly);
+			GZipWriter writer(&target);
+			QVERIFY(writer.open(QIODevice::WriteOnly));
+			// odd sized writes, crossing the internal buffer boundaries
+			for (int pos = 0; pos < log.size(); pos += 1000)
+			{
+				auto piece = log.mid(pos, 1000);
+				QCOMPARE(writer.write(piece), qint64(piece.size()));
+			}
+			QVERIFY(writer.finish());
+		}
+
+		QByteArray unzipped;
+		QVERIFY(GZip::unzip(compressed, unzipped));
+		QCOMPARE(unzipped, log);
+
+		QBuffer source;
+		source.setData(compressed);
+		source.open(QIODevice::ReadOnly);
+		GZipReader reader(&source);
+		QVERIFY(reader.open(QIODevice::ReadOnly | QIODevice::Unbuffered));
+		QCOMPARE(reader.uncompressedSize(), qint64(log.size()));
+		QCOMPARE(readInChunks(reader, 777), log);
+		QVERIFY(reader.atEnd());
+		QVERIFY(!reader.hasError());
+	}
+
+	void test_Truncated()
+	{
+		QByteArray compressed;
+		QVERIFY(GZip::zip(makeLog(100000), compressed));
+		compressed.chop(100);
+
+		QByteArray unzipped;
+		QVERIFY(!GZip::unzip(compressed, unzipped));
+
+		QBuffer source;
+		source.setData(compressed);
+		source.open(QIODevice::ReadOnly);
+		GZipReader reader(&source);
+		QVERIFY(reader.open(QIODevice::ReadOnly));
+		readInChunks(reader, 4096);
+		QVERIFY(reader.hasError());
+		QVERIFY(reader.atEnd());
+
+		QVERIFY(!GZip::unzip(QByteArray(1000, 'x'), unzipped));
+	}
+
+	void test_MultipleMembers()
+	{
+		// what `cat first.gz second.gz` makes, rotated logs sometimes look like this
+		QByteArray first, second;
+		QVERIFY(GZip::zip("first part\n", first));
+		QVERIFY(GZip::zip("second part\n", second));
+		QByteArray unzipped;
+		QVERIFY(GZip::unzip(first + second, unzipped));
+		QCOMPARE(unzipped, QByteArray("first part\nsecond part\n"));
+	}
+
+	void test_TrailingGarbage()
+	{
+		// some tools pad gzip files with zeros. Everything after the data is ignored, like gzip does.
+		QByteArray compressed;
+		QVERIFY(GZip::zip("some data\n", compressed));
+		QByteArray unzipped;
+		QVERIFY(GZip::unzip(compressed + QByteArray(512, '\0'), unzipped));
+		QCOMPARE(unzipped, QByteArray("some data\n"));
+		QVERIFY(GZip::unzip(compressed + QByteArray(1, '\x1f'), unzipped));
+		QCOMPARE(unzipped, QByteArray("some data\n"));
+	}
 };
 
 QTEST_GUILESS_MAIN(GZipTest)
@@ -38,6 +38,8 @@
 #include "NullInstance.h"
 #include "FileSystem.h"
 #include "pathmatcher/RegexpMatcher.h"
+#include "ContentStore.h"
+#include "Env.h"
 
 const static int GROUP_FILE_FORMAT_VERSION = 1;
 
@@ -516,6 +518,27 @@ InstanceList::createInstance(InstancePtr &inst, BaseVersionPtr version, const QS
 	return InstanceList::NoSuchVersion;
 }
 
+namespace
+{
+// matches the files of an instance that are links to store blobs
+class StoreMatcher : public IPathMatcher
+{
+public:
+	StoreMatcher(std::shared_ptr<ContentStore> store, const QString &instanceRoot)
+		: m_store(store), m_instanceRoot(instanceRoot)
+	{
+	}
+	virtual bool matches(const QString &string) const override
+	{
+		return ContentStore::isShared(string) && m_store->contains(FS::PathCombine(m_instanceRoot, string));
+	}
+
+private:
+	std::shared_ptr<ContentStore> m_store;
+	QString m_instanceRoot;
+};
+}
+
 InstanceList::InstCreateError
 InstanceList::copyInstance(InstancePtr &newInstance, InstancePtr &oldInstance, const QString &instDir, bool copySaves)
 {
@@ -528,15 +551,28 @@ InstanceList::copyInstance(InstancePtr &newInstance, InstancePtr &oldInstance, c
 		matcher.reset(matcherReal);
 	}
 
+	std::unique_ptr<IPathMatcher> linkMatcher;
+	auto store = ENV.contentStore();
+	if (store)
+	{
+		// link what the old instance already shares through the store. The old instance itself is left alone.
+		linkMatcher.reset(new StoreMatcher(store, oldInstance->instanceRoot()));
+	}
+
 	qDebug() << instDir.toUtf8();
 	FS::copy folderCopy(oldInstance->instanceRoot(), instDir);
-	folderCopy.followSymlinks(false).blacklist(matcher.get());
+	folderCopy.followSymlinks(false).blacklist(matcher.get()).linkFiles(linkMatcher.get());
 	if (!folderCopy())
 	{
 		FS::deletePath(instDir);
 		return InstanceList::CantCreateDir;
 	}
 
+	if (store)
+	{
+		store->addInstance(instDir);
+	}
+
 	INISettingsObject settings_obj(FS::PathCombine(instDir, "instance.cfg"));
 	settings_obj.registerSetting("InstanceType", "Legacy");
 	QString inst_type = settings_obj.get("InstanceType").toString();
@@ -0,0 +1,122 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QAbstractItemModel>
+#include <QList>
+#include <QSet>
+#include <QString>
+
+/*
+ * Turns the contents of a list model into new contents step by step, telling the views
+ * exactly which rows went away, showed up, moved or changed. Unlike a model reset, this keeps
+ * selection, scroll position and everything else the views remember about the rows.
+ *
+ * Items are matched by a string key that has to be unique within each list.
+ *
+ * The model has to be a friend of this class, so it can call the protected row functions:
+ *     friend class ListModelDiff;
+ */
+class ListModelDiff
+{
+public:
+	/// Returns true if anything changed.
+	template <typename Model, typename T, typename KeyFn, typename SameFn>
+	static bool apply(Model *model, QList<T> &current, const QList<T> &updated, KeyFn key, SameFn same)
+	{
+		bool changed = false;
+
+		QSet<QString> updatedKeys;
+		updatedKeys.reserve(updated.size());
+		for (auto &item : updated)
+		{
+			updatedKeys.insert(key(item));
+		}
+
+		// remove what's gone, in as few steps as possible, from the back so rows don't shift
+		int row = current.size() - 1;
+		while (row >= 0)
+		{
+			if (updatedKeys.contains(key(current[row])))
+			{
+				row--;
+				continue;
+			}
+			int last = row;
+			while (row > 0 && !updatedKeys.contains(key(current[row - 1])))
+			{
+				row--;
+			}
+			model->beginRemoveRows(QModelIndex(), row, last);
+			current.erase(current.begin() + row, current.begin() + last + 1);
+			model->endRemoveRows();
+			changed = true;
+			row--;
+		}
+
+		// everything left over is also in the new list. Walk the new list, moving old rows into place
+		// and inserting new ones in between.
+		QSet<QString> remaining;
+		remaining.reserve(current.size());
+		for (auto &item : current)
+		{
+			remaining.insert(key(item));
+		}
+		for (row = 0; row < updated.size(); row++)
+		{
+			const QString wanted = key(updated[row]);
+			if (!remaining.contains(wanted))
+			{
+				int last = row;
+				while (last + 1 < updated.size() && !remaining.contains(key(updated[last + 1])))
+				{
+					last++;
+				}
+				model->beginInsertRows(QModelIndex(), row, last);
+				for (int i = row; i <= last; i++)
+				{
+					current.insert(i, updated[i]);
+				}
+				model->endInsertRows();
+				changed = true;
+				row = last;
+				continue;
+			}
+			remaining.remove(wanted);
+
+			if (key(current[row]) != wanted)
+			{
+				int from = row + 1;
+				while (key(current[from]) != wanted)
+				{
+					from++;
+				}
+				model->beginMoveRows(QModelIndex(), from, from, QModelIndex(), row);
+				current.move(from, row);
+				model->endMoveRows();
+				changed = true;
+			}
+			if (!same(current[row], updated[row]))
+			{
+				current[row] = updated[row];
+				int lastColumn = model->columnCount(QModelIndex()) - 1;
+				emit model->dataChanged(model->index(row, 0), model->index(row, lastColumn));
+				changed = true;
+			}
+		}
+		return changed;
+	}
+};
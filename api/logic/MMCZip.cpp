@@ -24,12 +24,14 @@ see quazip/(un)MMCZip.h files for details. Basically it's the zlib license.
 */
 
 #include <quazip.h>
-#include <JlCompress.h>
-#include <quazipdir.h>
+#include <quazipfile.h>
 #include "MMCZip.h"
+#include "ExtractZipTask.h"
+#include "ZipIndex.h"
 #include "FileSystem.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
 
 bool copyData(QIODevice &inFile, QIODevice &outFile)
 {
@@ -47,7 +49,7 @@ bool copyData(QIODevice &inFile, QIODevice &outFile)
 
 QStringList MMCZip::extractDir(QString fileCompressed, QString dir)
 {
-	return JlCompress::extractDir(fileCompressed, dir);
+	return ExtractZipTask::extract(fileCompressed, dir);
 }
 
 bool compressFile(QuaZip *zip, QString fileName, QString fileDest)
@@ -165,14 +167,84 @@ bool MMCZip::compressSubDir(QuaZip* zip, QString dir, QString origDir, QSet<QStr
 	return true;
 }
 
+// Copy the current entry of 'from' into 'into' by inflating and deflating it again
+static bool recompressEntry(QuaZip *from, QuaZip *into, const QString &filename)
+{
+	QuaZipFile fileInsideMod(from);
+	QuaZipFile zipOutFile(into);
+	if (!fileInsideMod.open(QIODevice::ReadOnly))
+	{
+		qCritical() << "Failed to open " << filename << " from " << from->getZipName();
+		return false;
+	}
+
+	QuaZipNewInfo info_out(fileInsideMod.getActualFileName());
+
+	if (!zipOutFile.open(QIODevice::WriteOnly, info_out))
+	{
+		qCritical() << "Failed to open " << filename << " in the jar";
+		fileInsideMod.close();
+		return false;
+	}
+	if (!copyData(fileInsideMod, zipOutFile))
+	{
+		zipOutFile.close();
+		fileInsideMod.close();
+		qCritical() << "Failed to copy data of " << filename << " into the jar";
+		return false;
+	}
+	zipOutFile.close();
+	// a CRC mismatch only shows up here
+	fileInsideMod.close();
+	if (fileInsideMod.getZipError() != UNZ_OK || zipOutFile.getZipError() != UNZ_OK)
+	{
+		qCritical() << "Failed to copy data of " << filename << " into the jar";
+		return false;
+	}
+	return true;
+}
+
+// Copy the current entry of 'from' into 'into' as it is, without touching the compressed data
+static bool copyEntryRaw(QuaZip *from, QuaZip *into, const QuaZipFileInfo64 &info)
+{
+	QuaZipFile fileInsideMod(from);
+	QuaZipFile zipOutFile(into);
+	int method = 0;
+	int level = 0;
+	if (!fileInsideMod.open(QIODevice::ReadOnly, &method, &level, true))
+	{
+		qCritical() << "Failed to open " << info.name << " from " << from->getZipName();
+		return false;
+	}
+
+	QuaZipNewInfo info_out(info.name);
+	info_out.dateTime = info.dateTime;
+	info_out.uncompressedSize = info.uncompressedSize;
+
+	if (!zipOutFile.open(QIODevice::WriteOnly, info_out, nullptr, info.crc, method, level, true))
+	{
+		qCritical() << "Failed to open " << info.name << " in the jar";
+		fileInsideMod.close();
+		return false;
+	}
+	if (!copyData(fileInsideMod, zipOutFile))
+	{
+		zipOutFile.close();
+		fileInsideMod.close();
+		qCritical() << "Failed to copy data of " << info.name << " into the jar";
+		return false;
+	}
+	zipOutFile.close();
+	fileInsideMod.close();
+	return zipOutFile.getZipError() == UNZ_OK;
+}
+
 bool MMCZip::mergeZipFiles(QuaZip *into, QFileInfo from, QSet<QString> &contained,
 				   std::function<bool(QString)> filter)
 {
 	QuaZip modZip(from.filePath());
 	modZip.open(QuaZip::mdUnzip);
 
-	QuaZipFile fileInsideMod(&modZip);
-	QuaZipFile zipOutFile(into);
 	for (bool more = modZip.goToFirstFile(); more; more = modZip.goToNextFile())
 	{
 		QString filename = modZip.getCurrentFileName();
@@ -190,35 +262,35 @@ bool MMCZip::mergeZipFiles(QuaZip *into, QFileInfo from, QSet<QString> &containe
 		}
 		contained.insert(filename);
 
-		if (!fileInsideMod.open(QIODevice::ReadOnly))
+		QuaZipFileInfo64 info;
+		if (!modZip.getCurrentFileInfo(&info))
 		{
-			qCritical() << "Failed to open " << filename << " from " << from.fileName();
+			qCritical() << "Failed to read the header of " << filename << " from " << from.fileName();
 			return false;
 		}
-
-		QuaZipNewInfo info_out(fileInsideMod.getActualFileName());
-
-		if (!zipOutFile.open(QIODevice::WriteOnly, info_out))
+		// Stored and deflated entries can go in as they are, CRC and all.
+		// Anything else (encrypted, other compression methods) is unpacked and compressed again.
+		bool encrypted = info.flags & 1;
+		bool raw = !encrypted && (info.method == 0 || info.method == Z_DEFLATED);
+		if (raw)
 		{
-			qCritical() << "Failed to open " << filename << " in the jar";
-			fileInsideMod.close();
-			return false;
+			if (!copyEntryRaw(&modZip, into, info))
+			{
+				return false;
+			}
 		}
-		if (!copyData(fileInsideMod, zipOutFile))
+		else if (!recompressEntry(&modZip, into, filename))
 		{
-			zipOutFile.close();
-			fileInsideMod.close();
-			qCritical() << "Failed to copy data of " << filename << " into the jar";
 			return false;
 		}
-		zipOutFile.close();
-		fileInsideMod.close();
 	}
 	return true;
 }
 
 bool MMCZip::createModdedJar(QString sourceJarPath, QString targetJarPath, const QList<Mod>& mods)
 {
+	QElapsedTimer timer;
+	timer.start();
 	QuaZip zipOut(targetJarPath);
 	if (!zipOut.open(QuaZip::mdCreate))
 	{
@@ -297,6 +369,7 @@ bool MMCZip::createModdedJar(QString sourceJarPath, QString targetJarPath, const
 		qCritical() << "Failed to finalize minecraft.jar!";
 		return false;
 	}
+	qDebug() << "Created the modded jar in" << timer.elapsed() << "ms";
 	return true;
 }
 
@@ -341,38 +414,14 @@ bool MMCZip::compressDir(QString zipFile, QString dir, QString prefix, const Sep
 
 QString MMCZip::findFileInZip(QuaZip * zip, const QString & what, const QString &root)
 {
-	QuaZipDir rootDir(zip, root);
-	for(auto fileName: rootDir.entryList(QDir::Files))
-	{
-		if(fileName == what)
-			return root;
-	}
-	for(auto fileName: rootDir.entryList(QDir::Dirs))
-	{
-		QString result = findFileInZip(zip, what, root + fileName);
-		if(!result.isEmpty())
-		{
-			return result;
-		}
-	}
-	return QString();
+	ZipIndex index(zip->getZipName());
+	return index.findFile(what, root);
 }
 
 bool MMCZip::findFilesInZip(QuaZip * zip, const QString & what, QStringList & result, const QString &root)
 {
-	QuaZipDir rootDir(zip, root);
-	for(auto fileName: rootDir.entryList(QDir::Files))
-	{
-		if(fileName == what)
-		{
-			result.append(root);
-			return true;
-		}
-	}
-	for(auto fileName: rootDir.entryList(QDir::Dirs))
-	{
-		findFilesInZip(zip, what, result, root + fileName);
-	}
+	ZipIndex index(zip->getZipName());
+	result.append(index.findFiles(what, root));
 	return !result.isEmpty();
 }
 
@@ -461,31 +510,5 @@ bool MMCZip::extractFile(QuaZip *zip, const QString &fileName, const QString &fi
 
 QStringList MMCZip::extractSubDir(QuaZip *zip, const QString & subdir, const QString &target)
 {
-	QDir directory(target);
-	QStringList extracted;
-	if (!zip->goToFirstFile())
-	{
-		return QStringList();
-	}
-	do
-	{
-		QString name = zip->getCurrentFileName();
-		if(!name.startsWith(subdir))
-		{
-			continue;
-		}
-		name.remove(0, subdir.size());
-		QString absFilePath = directory.absoluteFilePath(name);
-		if(name.isEmpty())
-		{
-			absFilePath += "/";
-		}
-		if (!extractFile(zip, "", absFilePath))
-		{
-			removeFile(extracted);
-			return QStringList();
-		}
-		extracted.append(absFilePath);
-	} while (zip->goToNextFile());
-	return extracted;
+	return ExtractZipTask::extract(zip->getZipName(), target, subdir);
 }
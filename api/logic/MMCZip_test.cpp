@@ -0,0 +1,118 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include "TestUtil.h"
+
+#include "MMCZip.h"
+#include <FileSystem.h>
+#include <quazip.h>
+#include <quazipfile.h>
+
+class MMCZipTest : public QObject
+{
+	Q_OBJECT
+
+	struct Entry
+	{
+		QString name;
+		int method;
+		QByteArray data;
+		QByteArray password;
+	};
+
+	// DOS timestamps only have a two second resolution
+	const QDateTime timestamp = QDateTime(QDate(2015, 6, 1), QTime(12, 34, 56));
+
+	QString makeZip(const QString &path, const QList<Entry> &entries)
+	{
+		QuaZip zip(path);
+		if (!zip.open(QuaZip::mdCreate))
+		{
+			return QString();
+		}
+		for (auto &entry : entries)
+		{
+			QuaZipFile file(&zip);
+			QuaZipNewInfo info(entry.name);
+			info.dateTime = timestamp;
+			auto password = entry.password.isEmpty() ? nullptr : entry.password.constData();
+			if (!file.open(QIODevice::WriteOnly, info, password, 0, entry.method, Z_DEFAULT_COMPRESSION))
+			{
+				return QString();
+			}
+			file.write(entry.data);
+			file.close();
+		}
+		zip.close();
+		return path;
+	}
+
+private
+slots:
+	void test_RawCopy()
+	{
+		QTemporaryDir dir;
+		QByteArray random;
+		for (int i = 0; i < 50000; i++)
+		{
+			random.append(char(i * 7919 % 251));
+		}
+		QList<Entry> entries = {{"stored.bin", 0, random, QByteArray()},
+								{"deflated.txt", Z_DEFLATED, QByteArray(100000, 'd'), QByteArray()},
+								{"META-INF/MANIFEST.MF", Z_DEFLATED, "Manifest-Version: 1.0\n", QByteArray()}};
+		auto source = makeZip(FS::PathCombine(dir.path(), "source.jar"), entries);
+		QVERIFY(!source.isEmpty());
+
+		QuaZip out(FS::PathCombine(dir.path(), "out.jar"));
+		QVERIFY(out.open(QuaZip::mdCreate));
+		QSet<QString> contained;
+		QVERIFY(MMCZip::mergeZipFiles(&out, QFileInfo(source), contained, MMCZip::metaInfFilter));
+		out.close();
+		QCOMPARE(out.getZipError(), UNZ_OK);
+
+		QuaZip sourceZip(source);
+		QVERIFY(sourceZip.open(QuaZip::mdUnzip));
+		QuaZip merged(FS::PathCombine(dir.path(), "out.jar"));
+		QVERIFY(merged.open(QuaZip::mdUnzip));
+		QCOMPARE(merged.getEntriesCount(), 2);
+		for (int i = 0; i < 2; i++)
+		{
+			QVERIFY(sourceZip.setCurrentFile(entries[i].name));
+			QVERIFY(merged.setCurrentFile(entries[i].name));
+			QuaZipFileInfo64 before, after;
+			QVERIFY(sourceZip.getCurrentFileInfo(&before));
+			QVERIFY(merged.getCurrentFileInfo(&after));
+			QCOMPARE(after.method, quint16(entries[i].method));
+			QCOMPARE(after.method, before.method);
+			QCOMPARE(after.crc, before.crc);
+			QCOMPARE(after.compressedSize, before.compressedSize);
+			QCOMPARE(after.dateTime, timestamp);
+
+			QuaZipFile file(&merged);
+			QVERIFY(file.open(QIODevice::ReadOnly));
+			QCOMPARE(file.readAll(), entries[i].data);
+			file.close();
+			QCOMPARE(file.getZipError(), UNZ_OK);
+		}
+	}
+
+	void test_Recompress()
+	{
+		// encrypted entries can't be copied raw. Without the password they can't be read either, so
+		// the merge has to fail instead of writing garbage into the jar.
+		QTemporaryDir dir;
+		QList<Entry> entries = {{"plain.txt", Z_DEFLATED, QByteArray(1000, 'p'), QByteArray()},
+								{"secret.txt", Z_DEFLATED, QByteArray(1000, 's'), "password"}};
+		auto source = makeZip(FS::PathCombine(dir.path(), "source.jar"), entries);
+		QVERIFY(!source.isEmpty());
+
+		QuaZip out(FS::PathCombine(dir.path(), "out.jar"));
+		QVERIFY(out.open(QuaZip::mdCreate));
+		QSet<QString> contained;
+		QVERIFY(!MMCZip::mergeZipFiles(&out, QFileInfo(source), contained, MMCZip::noFilter));
+		out.close();
+	}
+};
+
+QTEST_GUILESS_MAIN(MMCZipTest)
+
+#include "MMCZip_test.moc"
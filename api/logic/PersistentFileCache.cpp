@@ -0,0 +1,59 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PersistentFileCache.h"
+#include "FileSystem.h"
+
+#include <QFileInfo>
+#include <QDateTime>
+
+#ifdef Q_OS_UNIX
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+bool FileStamp::of(const QString &path, FileStamp &stamp)
+{
+	QFileInfo info(path);
+	if (!info.isFile())
+	{
+		return false;
+	}
+	stamp.size = info.size();
+	stamp.mtime = info.lastModified().toUTC().toMSecsSinceEpoch();
+	stamp.inode = 0;
+#ifdef Q_OS_UNIX
+	struct stat st;
+	if (::stat(QFile::encodeName(path).constData(), &st) == 0)
+	{
+		stamp.inode = st.st_ino;
+	}
+#endif
+	return true;
+}
+
+bool writeCacheIndex(const QString &path, const QByteArray &data)
+{
+	try
+	{
+		FS::write(path, data);
+	}
+	catch (Exception &e)
+	{
+		qWarning() << e.what();
+		return false;
+	}
+	return true;
+}
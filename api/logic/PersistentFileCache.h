@@ -0,0 +1,203 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QDataStream>
+#include <QFile>
+#include <QDebug>
+
+#include "multimc_logic_export.h"
+
+/// What a file looked like when something was remembered about it
+struct MULTIMC_LOGIC_EXPORT FileStamp
+{
+	qint64 size = 0;
+	qint64 mtime = 0;
+	/// 0 where there are no inodes
+	quint64 inode = 0;
+
+	bool operator==(const FileStamp &other) const
+	{
+		return size == other.size && mtime == other.mtime && inode == other.inode;
+	}
+
+	/// stamp the file at path. False if it isn't a file.
+	static bool of(const QString &path, FileStamp &stamp);
+};
+
+/// write the data of an index file, logging any failure
+MULTIMC_LOGIC_EXPORT bool writeCacheIndex(const QString &path, const QByteArray &data);
+
+/*
+ * Remembers a value of type T for files, like their hashes or what was found inside them.
+ *
+ * Values are keyed by the absolute path, size, modification time and inode of the file, so
+ * a file is only looked at again when it changes. The values can be persisted into an index file
+ * that starts with a magic number and a format version. T has to be readable and writable with
+ * QDataStream.
+ *
+ * All the methods are thread safe.
+ */
+template <typename T> class PersistentFileCache
+{
+public:
+	/// supply path to the index file, or nothing for a cache that only lives in memory
+	PersistentFileCache(quint32 magic, quint32 version, const QString &indexPath = QString())
+		: m_magic(magic), m_version(version), m_index_file(indexPath)
+	{
+	}
+
+	~PersistentFileCache()
+	{
+		save();
+	}
+
+	/// the value remembered for the file at the absolute path, if the file didn't change since
+	bool find(const QString &path, T &value)
+	{
+		FileStamp stamp;
+		if (!FileStamp::of(path, stamp))
+		{
+			return false;
+		}
+		return find(path, stamp, value);
+	}
+
+	/**
+	 * The value for the file at the absolute path. If it's not known or the file changed,
+	 * compute(value) is called to produce it, and it's remembered if that returns true.
+	 *
+	 * Returns false if the file isn't there or compute() failed.
+	 */
+	template <typename Compute> bool get(const QString &path, T &value, Compute compute)
+	{
+		FileStamp before;
+		if (!FileStamp::of(path, before))
+		{
+			return false;
+		}
+		if (find(path, before, value))
+		{
+			return true;
+		}
+		if (!compute(value))
+		{
+			return false;
+		}
+		// don't remember anything if the file changed while we were looking at it
+		FileStamp after;
+		if (!FileStamp::of(path, after) || !(after == before))
+		{
+			return true;
+		}
+		QWriteLocker l(&m_lock);
+		m_records[path] = {before, value};
+		m_dirty = true;
+		return true;
+	}
+
+	void load()
+	{
+		if (m_index_file.isEmpty())
+			return;
+
+		QFile index(m_index_file);
+		if (!index.open(QIODevice::ReadOnly))
+			return;
+
+		QDataStream in(&index);
+		quint32 magic = 0;
+		quint32 version = 0;
+		in >> magic >> version;
+		if (magic != m_magic || version != m_version)
+		{
+			qWarning() << "Ignoring unknown index format in" << m_index_file;
+			return;
+		}
+
+		QWriteLocker l(&m_lock);
+		while (!in.atEnd())
+		{
+			QString path;
+			Record record;
+			in >> path >> record.stamp.size >> record.stamp.mtime >> record.stamp.inode >> record.value;
+			if (in.status() != QDataStream::Ok)
+			{
+				break;
+			}
+			m_records[path] = record;
+		}
+		m_dirty = false;
+	}
+
+	void save()
+	{
+		if (m_index_file.isEmpty())
+			return;
+
+		QByteArray data;
+		{
+			QReadLocker l(&m_lock);
+			if (!m_dirty)
+				return;
+			QDataStream out(&data, QIODevice::WriteOnly);
+			out << m_magic << m_version;
+			for (auto iter = m_records.constBegin(); iter != m_records.constEnd(); iter++)
+			{
+				// forget about files that are gone
+				if (!QFile::exists(iter.key()))
+					continue;
+				out << iter.key() << iter->stamp.size << iter->stamp.mtime << iter->stamp.inode << iter->value;
+			}
+		}
+		if (!writeCacheIndex(m_index_file, data))
+		{
+			return;
+		}
+		QWriteLocker l(&m_lock);
+		m_dirty = false;
+	}
+
+private:
+	struct Record
+	{
+		FileStamp stamp;
+		T value;
+	};
+
+	bool find(const QString &path, const FileStamp &stamp, T &value)
+	{
+		QReadLocker l(&m_lock);
+		auto iter = m_records.constFind(path);
+		if (iter == m_records.constEnd() || !(iter->stamp == stamp))
+		{
+			return false;
+		}
+		value = iter->value;
+		return true;
+	}
+
+	const quint32 m_magic;
+	const quint32 m_version;
+	QReadWriteLock m_lock;
+	QHash<QString, Record> m_records;
+	QString m_index_file;
+	bool m_dirty = false;
+};
@@ -0,0 +1,369 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ZipIndex.h"
+
+#include <QDebug>
+#include <zlib.h>
+
+#include <algorithm>
+#include <climits>
+
+namespace
+{
+const quint32 endOfCentralDirSignature = 0x06054b50;
+const quint32 zip64LocatorSignature = 0x07064b50;
+const quint32 zip64EndOfCentralDirSignature = 0x06064b50;
+const quint32 centralHeaderSignature = 0x02014b50;
+const quint32 localHeaderSignature = 0x04034b50;
+
+const int endOfCentralDirSize = 22;
+const int zip64LocatorSize = 20;
+const int zip64EndOfCentralDirSize = 56;
+const int centralHeaderSize = 46;
+const int localHeaderSize = 30;
+
+quint16 read16(const uchar *p)
+{
+	return quint16(p[0]) | quint16(p[1]) << 8;
+}
+
+quint32 read32(const uchar *p)
+{
+	return quint32(read16(p)) | quint32(read16(p + 2)) << 16;
+}
+
+quint64 read64(const uchar *p)
+{
+	return quint64(read32(p)) | quint64(read32(p + 4)) << 32;
+}
+
+QDateTime fromDosTime(quint16 time, quint16 date)
+{
+	return QDateTime(QDate(1980 + (date >> 9), (date >> 5) & 0xf, date & 0x1f),
+					 QTime(time >> 11, (time >> 5) & 0x3f, (time & 0x1f) * 2));
+}
+
+// 100ns intervals since 1601, like QuaZipFileInfo64::getNTFSmTime
+QDateTime fromFileTime(quint64 fileTime)
+{
+	QDateTime epoch(QDate(1601, 1, 1), QTime(0, 0), Qt::UTC);
+	return epoch.addMSecs(qint64(fileTime / 10000));
+}
+
+// go through the extra field of a central directory header
+void parseExtra(const uchar *extra, int size, ZipIndex::Entry &entry)
+{
+	int pos = 0;
+	while (pos + 4 <= size)
+	{
+		quint16 tag = read16(extra + pos);
+		quint16 length = read16(extra + pos + 2);
+		const uchar *field = extra + pos + 4;
+		pos += 4 + length;
+		if (pos > size)
+		{
+			return;
+		}
+		if (tag == 0x0001)
+		{
+			// zip64: only the values that didn't fit are here, in this order
+			int offset = 0;
+			auto next = [&](quint64 &value)
+			{
+				if (value == 0xffffffff && offset + 8 <= length)
+				{
+					value = read64(field + offset);
+					offset += 8;
+				}
+			};
+			next(entry.uncompressedSize);
+			next(entry.compressedSize);
+			next(entry.localHeaderOffset);
+		}
+		else if (tag == 0x000a && length >= 32)
+		{
+			// NTFS: 4 reserved bytes, then attributes. Attribute 1 holds mtime, atime and ctime.
+			int offset = 4;
+			while (offset + 4 <= length)
+			{
+				quint16 attrTag = read16(field + offset);
+				quint16 attrSize = read16(field + offset + 2);
+				if (attrTag == 1 && attrSize >= 8 && offset + 4 + 8 <= length)
+				{
+					entry.modified = fromFileTime(read64(field + offset + 4));
+					break;
+				}
+				offset += 4 + attrSize;
+			}
+		}
+	}
+}
+}
+
+ZipIndex::ZipIndex(const QString &path) : m_file(path)
+{
+	if (!m_file.open(QIODevice::ReadOnly))
+	{
+		return;
+	}
+	m_size = m_file.size();
+	if (m_size < endOfCentralDirSize)
+	{
+		return;
+	}
+	m_data = m_file.map(0, m_size);
+	if (!m_data)
+	{
+		qWarning() << "Couldn't map" << path;
+		return;
+	}
+	m_valid = parse();
+	if (!m_valid)
+	{
+		qWarning() << path << "is not a valid zip file";
+	}
+}
+
+bool ZipIndex::parse()
+{
+	// the end of central directory record is at the end, followed by a comment of up to 64 KiB
+	qint64 eocd = -1;
+	qint64 lowest = std::max<qint64>(0, m_size - endOfCentralDirSize - 0xffff);
+	for (qint64 pos = m_size - endOfCentralDirSize; pos >= lowest; pos--)
+	{
+		if (read32(m_data + pos) == endOfCentralDirSignature &&
+			pos + endOfCentralDirSize + read16(m_data + pos + 20) == m_size)
+		{
+			eocd = pos;
+			break;
+		}
+	}
+	if (eocd < 0)
+	{
+		return false;
+	}
+	quint64 count = read16(m_data + eocd + 10);
+	quint64 dirSize = read32(m_data + eocd + 12);
+	quint64 dirOffset = read32(m_data + eocd + 16);
+
+	qint64 locator = eocd - zip64LocatorSize;
+	if (locator >= 0 && read32(m_data + locator) == zip64LocatorSignature)
+	{
+		quint64 zip64eocd = read64(m_data + locator + 8);
+		if (zip64eocd + zip64EndOfCentralDirSize > quint64(m_size) ||
+			read32(m_data + zip64eocd) != zip64EndOfCentralDirSignature)
+		{
+			return false;
+		}
+		count = read64(m_data + zip64eocd + 32);
+		dirSize = read64(m_data + zip64eocd + 40);
+		dirOffset = read64(m_data + zip64eocd + 48);
+	}
+	if (dirOffset + dirSize > quint64(m_size))
+	{
+		return false;
+	}
+
+	// every header takes at least this much, don't let a broken count allocate gigabytes
+	m_entries.reserve(int(std::min<quint64>(count, dirSize / centralHeaderSize)));
+	m_lookup.reserve(m_entries.capacity());
+	const uchar *pos = m_data + dirOffset;
+	const uchar *end = pos + dirSize;
+	for (quint64 i = 0; i < count; i++)
+	{
+		if (end - pos < centralHeaderSize || read32(pos) != centralHeaderSignature)
+		{
+			return false;
+		}
+		quint16 nameLength = read16(pos + 28);
+		quint16 extraLength = read16(pos + 30);
+		quint16 commentLength = read16(pos + 32);
+		if (end - pos < centralHeaderSize + nameLength + extraLength + commentLength)
+		{
+			return false;
+		}
+
+		Entry entry;
+		entry.flags = read16(pos + 8);
+		entry.method = read16(pos + 10);
+		entry.crc = read32(pos + 16);
+		entry.compressedSize = read32(pos + 20);
+		entry.uncompressedSize = read32(pos + 24);
+		entry.localHeaderOffset = read32(pos + 42);
+		auto rawName = reinterpret_cast<const char *>(pos + centralHeaderSize);
+		// bit 11: the name is UTF-8. Otherwise it's whatever QuaZip would assume.
+		entry.name = (entry.flags & (1 << 11)) ? QString::fromUtf8(rawName, nameLength)
+											   : QString::fromLocal8Bit(rawName, nameLength);
+		parseExtra(pos + centralHeaderSize + nameLength, extraLength, entry);
+		if (!entry.modified.isValid())
+		{
+			entry.modified = fromDosTime(read16(pos + 12), read16(pos + 14));
+		}
+
+		if (!m_lookup.contains(entry.name))
+		{
+			m_lookup.insert(entry.name, m_entries.size());
+		}
+		m_entries.append(entry);
+		pos += centralHeaderSize + nameLength + extraLength + commentLength;
+	}
+	return true;
+}
+
+const ZipIndex::Entry *ZipIndex::find(const QString &name) const
+{
+	auto iter = m_lookup.find(name);
+	if (iter == m_lookup.end())
+	{
+		return nullptr;
+	}
+	return &m_entries[*iter];
+}
+
+bool ZipIndex::read(const QString &name, QByteArray &data) const
+{
+	auto entry = find(name);
+	if (!entry)
+	{
+		return false;
+	}
+	return read(*entry, data);
+}
+
+bool ZipIndex::read(const Entry &entry, QByteArray &data) const
+{
+	// encrypted
+	if (!m_valid || entry.flags & 1)
+	{
+		return false;
+	}
+	quint64 header = entry.localHeaderOffset;
+	if (header + localHeaderSize > quint64(m_size) || read32(m_data + header) != localHeaderSignature)
+	{
+		return false;
+	}
+	// the local header can have a different extra field than the central one
+	quint64 start = header + localHeaderSize + read16(m_data + header + 26) + read16(m_data + header + 28);
+	if (start + entry.compressedSize > quint64(m_size) || entry.uncompressedSize > quint64(INT_MAX))
+	{
+		return false;
+	}
+	const uchar *compressed = m_data + start;
+
+	if (entry.method == 0)
+	{
+		if (entry.compressedSize != entry.uncompressedSize)
+		{
+			return false;
+		}
+		data = QByteArray(reinterpret_cast<const char *>(compressed), int(entry.uncompressedSize));
+	}
+	else if (entry.method == Z_DEFLATED)
+	{
+		data.resize(int(entry.uncompressedSize));
+		z_stream stream = {};
+		if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+		{
+			return false;
+		}
+		// zlib counts in uInt, feed big entries in pieces
+		quint64 remainingIn = entry.compressedSize;
+		stream.next_in = const_cast<Bytef *>(compressed);
+		stream.next_out = reinterpret_cast<Bytef *>(data.data());
+		stream.avail_out = uInt(entry.uncompressedSize);
+		int status = Z_OK;
+		while (status == Z_OK)
+		{
+			if (stream.avail_in == 0)
+			{
+				if (remainingIn == 0)
+				{
+					break;
+				}
+				stream.avail_in = uInt(std::min<quint64>(remainingIn, 1 << 30));
+				remainingIn -= stream.avail_in;
+			}
+			status = inflate(&stream, Z_NO_FLUSH);
+		}
+		bool complete = status == Z_STREAM_END && stream.total_out == entry.uncompressedSize;
+		inflateEnd(&stream);
+		if (!complete)
+		{
+			return false;
+		}
+	}
+	else
+	{
+		return false;
+	}
+
+	quint32 crc = crc32(crc32(0, nullptr, 0), reinterpret_cast<const Bytef *>(data.constData()), data.size());
+	return crc == entry.crc;
+}
+
+QString ZipIndex::findFile(const QString &what, const QString &root) const
+{
+	auto found = findFiles(what, root);
+	if (found.isEmpty())
+	{
+		return QString();
+	}
+	return *std::min_element(found.begin(), found.end(), [](const QString &a, const QString &b)
+	{
+		int depthA = a.count('/');
+		int depthB = b.count('/');
+		if (depthA != depthB)
+		{
+			return depthA < depthB;
+		}
+		return a < b;
+	});
+}
+
+QStringList ZipIndex::findFiles(const QString &what, const QString &root) const
+{
+	QStringList prefixes;
+	for (auto iter = m_lookup.constBegin(); iter != m_lookup.constEnd(); iter++)
+	{
+		auto &name = iter.key();
+		if (!name.startsWith(root) || !name.endsWith(what))
+		{
+			continue;
+		}
+		auto prefix = name.left(name.size() - what.size());
+		if (prefix.isEmpty())
+		{
+			// found in the root, which is not the same as not found
+			prefixes.append(QString(""));
+		}
+		else if (prefix.endsWith('/'))
+		{
+			prefixes.append(prefix);
+		}
+	}
+	// a match hides everything below it
+	std::sort(prefixes.begin(), prefixes.end());
+	QStringList result;
+	for (auto &prefix : prefixes)
+	{
+		if (!result.isEmpty() && prefix.startsWith(result.last()))
+		{
+			continue;
+		}
+		result.append(prefix);
+	}
+	return result;
+}
@@ -0,0 +1,105 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include <QFile>
+#include <QDateTime>
+
+#include "multimc_logic_export.h"
+
+/*
+ * The central directory of a zip file, read once and kept around for lookups.
+ *
+ * The file is memory mapped, so finding and reading entries doesn't scan the archive again.
+ * Only stored and deflated entries can be read, which is everything jars and world zips use.
+ */
+class MULTIMC_LOGIC_EXPORT ZipIndex
+{
+public:
+	struct Entry
+	{
+		QString name;
+		quint32 crc = 0;
+		quint64 compressedSize = 0;
+		quint64 uncompressedSize = 0;
+		quint64 localHeaderOffset = 0;
+		quint16 method = 0;
+		quint16 flags = 0;
+		/// NTFS modification time if the entry has one, the DOS timestamp otherwise
+		QDateTime modified;
+	};
+
+	explicit ZipIndex(const QString &path);
+	ZipIndex(const ZipIndex &) = delete;
+	ZipIndex &operator=(const ZipIndex &) = delete;
+
+	bool isValid() const
+	{
+		return m_valid;
+	}
+
+	int size() const
+	{
+		return m_entries.size();
+	}
+
+	bool contains(const QString &name) const
+	{
+		return m_lookup.contains(name);
+	}
+
+	/// the entry with the given name, or nullptr. With duplicate names, the first one wins.
+	const Entry *find(const QString &name) const;
+
+	/// all entries, in the order of the central directory
+	const QVector<Entry> &entries() const
+	{
+		return m_entries;
+	}
+
+	/// read and inflate an entry. Returns false if it's missing, damaged or uses an unsupported method.
+	bool read(const QString &name, QByteArray &data) const;
+	bool read(const Entry &entry, QByteArray &data) const;
+
+	/**
+	 * Find the folder that has a file named 'what' (not a path) in it, starting at root.
+	 * Shallower folders win, then the ones that sort first.
+	 *
+	 * \return the path prefix where the file is, null if it wasn't found
+	 */
+	QString findFile(const QString &what, const QString &root = QString()) const;
+
+	/**
+	 * Find all the folders with a file named 'what' in them, starting at root.
+	 * If a file is found in a folder, nothing below that folder is returned.
+	 */
+	QStringList findFiles(const QString &what, const QString &root = QString()) const;
+
+private:
+	bool parse();
+
+private:
+	QFile m_file;
+	const uchar *m_data = nullptr;
+	qint64 m_size = 0;
+	bool m_valid = false;
+	QVector<Entry> m_entries;
+	QHash<QString, int> m_lookup;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QMap>
+#include <QByteArray>
+#include <QString>
+#include <FileSystem.h>
+
+#include <quazip.h>
+#include <quazipfile.h>
+
+class ZipIndexTestUtil
+{
+public:
+	static bool makeZip(const QString &path, const QMap<QString, QByteArray> &files)
+	{
+		QuaZip zip(path);
+		if (!zip.open(QuaZip::mdCreate))
+		{
+			return false;
+		}
+		for (auto iter = files.begin(); iter != files.end(); iter++)
+		{
+			QuaZipFile file(&zip);
+			if (!file.open(QIODevice::WriteOnly, QuaZipNewInfo(iter.key())))
+			{
+				return false;
+			}
+			file.write(iter.value());
+			file.close();
+		}
+		zip.close();
+		return zip.getZipError() == 0;
+	}
+
+	static QString makeBigJar(const QString &root, int count)
+	{
+		QMap<QString, QByteArray> files;
+		for (int i = 0; i < count; i++)
+		{
+			files.insert(QString("net/minecraft/pkg%1/Class%2.class").arg(i % 50).arg(i),
+						 QByteArray(100 + i % 500, char('a' + i % 26)));
+		}
+		files.insert("mcmod.info", "[{\"modid\": \"test\"}]");
+		QString path = FS::PathCombine(root, "big.jar");
+		return makeZip(path, files) ? path : QString();
+	}
+};
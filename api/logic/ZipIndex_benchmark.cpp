@@ -0,0 +1,60 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include "TestUtil.h"
+
+#include "ZipIndex.h"
+#include "ZipIndexTestUtil.h"
+#include <FileSystem.h>
+
+class ZipIndexBenchmark : public QObject, private ZipIndexTestUtil
+{
+	Q_OBJECT
+
+private
+slots:
+	void benchmark_BigJar()
+	{
+		QTemporaryDir dir;
+		auto path = makeBigJar(dir.path(), 12000);
+		QVERIFY(!path.isEmpty());
+
+		QElapsedTimer timer;
+		timer.start();
+		ZipIndex index(path);
+		auto indexTime = timer.nsecsElapsed();
+		QVERIFY(index.isValid());
+		QCOMPARE(index.size(), 12001);
+
+		// look up the same things Mod::repath and World::readFromZip do
+		const QStringList names = {"mcmod.info", "forgeversion.properties", "litemod.json",
+								   "net/minecraft/pkg7/Class11957.class"};
+		timer.restart();
+		for (auto &name : names)
+		{
+			index.contains(name);
+		}
+		index.findFile("level.dat");
+		auto lookupTime = timer.nsecsElapsed();
+
+		timer.restart();
+		QuaZip zip(path);
+		QVERIFY(zip.open(QuaZip::mdUnzip));
+		for (auto &name : names)
+		{
+			zip.setCurrentFile(name);
+		}
+		auto quazipTime = timer.nsecsElapsed();
+
+		qDebug() << "12001 entries: index built in" << indexTime / 1000 << "us, lookups took" << lookupTime / 1000
+				 << "us; QuaZip open + setCurrentFile took" << quazipTime / 1000 << "us";
+
+		QByteArray data;
+		QVERIFY(index.read("net/minecraft/pkg7/Class11957.class", data));
+		QCOMPARE(data, QByteArray(100 + 11957 % 500, char('a' + 11957 % 26)));
+	}
+};
+
+QTEST_GUILESS_MAIN(ZipIndexBenchmark)
+
+#include "ZipIndex_benchmark.moc"
@@ -0,0 +1,62 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include "TestUtil.h"
+
+#include "ZipIndex.h"
+#include "ZipIndexTestUtil.h"
+#include <FileSystem.h>
+
+class ZipIndexTest : public QObject, private ZipIndexTestUtil
+{
+	Q_OBJECT
+
+private
+slots:
+	void test_Lookup()
+	{
+		QTemporaryDir dir;
+		QString path = FS::PathCombine(dir.path(), "world.zip");
+		QMap<QString, QByteArray> files;
+		files.insert("readme.txt", "hi");
+		files.insert("saves/World/level.dat", "level");
+		files.insert("saves/World/DIM1/level.dat", "nested");
+		files.insert("saves/Other/level.dat", "other");
+		files.insert("saves/Other/empty.txt", QByteArray());
+		files.insert("saves/Other/large.txt", QByteArray(10000, 'x'));
+		QVERIFY(makeZip(path, files));
+
+		ZipIndex index(path);
+		QVERIFY(index.isValid());
+		QCOMPARE(index.size(), files.size());
+		QVERIFY(index.contains("readme.txt"));
+		QVERIFY(!index.contains("missing.txt"));
+		QVERIFY(index.find("missing.txt") == nullptr);
+		for (auto iter = files.begin(); iter != files.end(); iter++)
+		{
+			QByteArray data;
+			QVERIFY(index.read(iter.key(), data));
+			QCOMPARE(data, iter.value());
+		}
+		QVERIFY(index.find("readme.txt")->modified.isValid());
+
+		QCOMPARE(index.findFile("level.dat"), QString("saves/Other/"));
+		QCOMPARE(index.findFiles("level.dat"), QStringList() << "saves/Other/" << "saves/World/");
+		QCOMPARE(index.findFile("readme.txt"), QString(""));
+		QVERIFY(!index.findFile("readme.txt").isNull());
+		QVERIFY(index.findFile("nothing.dat").isNull());
+		QCOMPARE(index.findFile("level.dat", "saves/World/DIM1/"), QString("saves/World/DIM1/"));
+	}
+
+	void test_Invalid()
+	{
+		QTemporaryDir dir;
+		QString path = FS::PathCombine(dir.path(), "broken.zip");
+		FS::write(path, QByteArray(1000, 'x'));
+		QVERIFY(!ZipIndex(path).isValid());
+		QVERIFY(!ZipIndex(FS::PathCombine(dir.path(), "missing.zip")).isValid());
+	}
+};
+
+QTEST_GUILESS_MAIN(ZipIndexTest)
+
+#include "ZipIndex_test.moc"
@@ -22,11 +22,257 @@
 #include <QJsonObject>
 #include <QVariant>
 #include <QDebug>
+#include <QSet>
+#include <QtConcurrentMap>
+#include <cstring>
 
 #include "AssetsUtils.h"
+#include "Env.h"
+#include "FileHashCache.h"
 #include "FileSystem.h"
 #include "net/MD5EtagDownload.h"
 
+namespace
+{
+/*
+ * The compiled form of an asset index, stored next to the JSON file:
+ *
+ *   SidecarHeader
+ *   SidecarEntry[count], in the order of the paths
+ *   UTF-8 paths, not terminated
+ *
+ * Everything is in host byte order. A different byte order fails the magic check and the index is compiled again.
+ */
+// "MMCA"
+const quint32 sidecarMagic = 0x41434d4d;
+const quint32 sidecarVersion = 1;
+
+struct SidecarHeader
+{
+	quint32 magic;
+	quint32 version;
+	/// sha1 of the JSON file this was compiled from
+	char jsonSha1[20];
+	quint32 isVirtual;
+	quint32 count;
+	quint32 stringsSize;
+};
+static_assert(sizeof(SidecarHeader) == 40, "SidecarHeader must not have padding");
+
+struct SidecarEntry
+{
+	quint32 pathOffset;
+	quint32 pathLength;
+	quint64 size;
+	char hash[20];
+	quint32 reserved;
+};
+static_assert(sizeof(SidecarEntry) == 40, "SidecarEntry must not have padding");
+
+/// one file of a virtual assets tree
+struct VirtualAsset
+{
+	/// path within the tree and the asset it should contain
+	QString path;
+	QString hash;
+	QString original;
+	QString target;
+	bool placed = false;
+};
+
+void placeVirtualAsset(VirtualAsset &asset)
+{
+	if (!QFile::exists(asset.original))
+	{
+		return;
+	}
+	// whatever is there is outdated
+	QFile::remove(asset.target);
+	asset.placed = FS::linkOrCopy(asset.original, asset.target);
+	if (!asset.placed)
+	{
+		qWarning() << "Failed to place" << asset.original << "at" << asset.target;
+	}
+}
+
+/*
+ * The manifest of a virtual assets tree:
+ *
+ *   index <sha1 of the index JSON, empty if the tree is incomplete>
+ *   <asset hash> <path>
+ *   ...
+ */
+QString readManifest(const QString &path, QMap<QString, QString> &entries)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		return QString();
+	}
+	QString indexSha1;
+	bool first = true;
+	while (!file.atEnd())
+	{
+		QString line = QString::fromUtf8(file.readLine()).trimmed();
+		if (first)
+		{
+			first = false;
+			if (!line.startsWith("index"))
+			{
+				entries.clear();
+				return QString();
+			}
+			indexSha1 = line.mid(6);
+			continue;
+		}
+		if (line.size() < 42)
+		{
+			continue;
+		}
+		entries.insert(line.mid(41), line.left(40));
+	}
+	return indexSha1;
+}
+
+void writeManifest(const QString &path, const QString &indexSha1, const QMap<QString, QString> &entries)
+{
+	QByteArray data = "index " + indexSha1.toLatin1() + "\n";
+	for (auto iter = entries.constBegin(); iter != entries.constEnd(); iter++)
+	{
+		data += iter.value().toLatin1() + " " + iter.key().toUtf8() + "\n";
+	}
+	try
+	{
+		FS::write(path, data);
+	}
+	catch (Exception &e)
+	{
+		qWarning() << "Failed to write assets manifest:" << e.what();
+	}
+}
+
+// true if every file the manifest lists is still in the tree
+bool manifestComplete(const QDir &root, const QMap<QString, QString> &entries)
+{
+	for (auto iter = entries.constBegin(); iter != entries.constEnd(); iter++)
+	{
+		if (!QFile::exists(root.filePath(iter.key())))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+QString sidecarPath(const QString &indexPath)
+{
+	return indexPath + ".bin";
+}
+
+bool loadCompiledIndex(const QString &path, const QByteArray &jsonSha1, AssetsIndex *index)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		return false;
+	}
+	qint64 fileSize = file.size();
+	if (fileSize < qint64(sizeof(SidecarHeader)))
+	{
+		return false;
+	}
+	const uchar *data = file.map(0, fileSize);
+	if (!data)
+	{
+		return false;
+	}
+
+	SidecarHeader header;
+	std::memcpy(&header, data, sizeof(header));
+	if (header.magic != sidecarMagic || header.version != sidecarVersion ||
+		jsonSha1.size() != int(sizeof(header.jsonSha1)) ||
+		std::memcmp(header.jsonSha1, jsonSha1.constData(), sizeof(header.jsonSha1)) != 0)
+	{
+		return false;
+	}
+	qint64 entriesEnd = sizeof(SidecarHeader) + qint64(header.count) * sizeof(SidecarEntry);
+	if (entriesEnd + header.stringsSize != fileSize)
+	{
+		return false;
+	}
+
+	const char *strings = (const char *)data + entriesEnd;
+	QMap<QString, AssetObject> objects;
+	for (quint32 i = 0; i < header.count; i++)
+	{
+		SidecarEntry entry;
+		std::memcpy(&entry, data + sizeof(SidecarHeader) + i * sizeof(SidecarEntry), sizeof(entry));
+		if (qint64(entry.pathOffset) + entry.pathLength > header.stringsSize)
+		{
+			return false;
+		}
+		AssetObject object;
+		object.hash = QString::fromLatin1(QByteArray::fromRawData(entry.hash, sizeof(entry.hash)).toHex());
+		object.size = entry.size;
+		// the entries are already sorted, so this always appends
+		objects.insert(objects.constEnd(), QString::fromUtf8(strings + entry.pathOffset, entry.pathLength), object);
+	}
+	index->objects = objects;
+	index->isVirtual = header.isVirtual != 0;
+	return true;
+}
+
+void compileIndex(const QString &path, const QByteArray &jsonSha1, const AssetsIndex &index)
+{
+	if (jsonSha1.size() != 20)
+	{
+		return;
+	}
+	SidecarHeader header;
+	std::memset(&header, 0, sizeof(header));
+	header.magic = sidecarMagic;
+	header.version = sidecarVersion;
+	std::memcpy(header.jsonSha1, jsonSha1.constData(), sizeof(header.jsonSha1));
+	header.isVirtual = index.isVirtual;
+	header.count = index.objects.size();
+
+	QByteArray entries;
+	QByteArray strings;
+	entries.reserve(index.objects.size() * sizeof(SidecarEntry));
+	for (auto iter = index.objects.constBegin(); iter != index.objects.constEnd(); iter++)
+	{
+		QByteArray hash = QByteArray::fromHex(iter->hash.toLatin1());
+		if (hash.size() != 20)
+		{
+			qWarning() << "Not compiling assets index" << index.id << "because of a bad hash in" << iter.key();
+			return;
+		}
+		QByteArray utf8 = iter.key().toUtf8();
+		SidecarEntry entry;
+		std::memset(&entry, 0, sizeof(entry));
+		entry.pathOffset = strings.size();
+		entry.pathLength = utf8.size();
+		entry.size = iter->size;
+		std::memcpy(entry.hash, hash.constData(), sizeof(entry.hash));
+		entries.append((const char *)&entry, sizeof(entry));
+		strings.append(utf8);
+	}
+	header.stringsSize = strings.size();
+
+	QByteArray data((const char *)&header, sizeof(header));
+	data.append(entries);
+	data.append(strings);
+	try
+	{
+		FS::write(path, data);
+	}
+	catch (Exception &e)
+	{
+		qWarning() << "Failed to write compiled assets index:" << e.what();
+	}
+}
+}
+
 namespace AssetsUtils
 {
 
@@ -60,6 +306,13 @@ bool loadAssetsIndexJson(QString assetsId, QString path, AssetsIndex *index)
 	}
 	index->id = assetsId;
 
+	// use the compiled index if it is still up to date
+	auto jsonSha1 = ENV.fileHashes()->hash(path).sha1;
+	if (loadCompiledIndex(sidecarPath(path), jsonSha1, index))
+	{
+		return true;
+	}
+
 	// Read the file and close it.
 	QByteArray jsonData = file.readAll();
 	file.close();
@@ -122,6 +375,7 @@ bool loadAssetsIndexJson(QString assetsId, QString path, AssetsIndex *index)
 		index->objects.insert(iter.key(), object);
 	}
 
+	compileIndex(sidecarPath(path), jsonSha1, *index);
 	return true;
 }
 
@@ -142,6 +396,16 @@ QDir reconstructAssets(QString assetsId)
 		return virtualRoot;
 	}
 
+	// nothing to do if the tree was completely built from this exact index before and nothing was deleted since
+	QString manifestPath = FS::PathCombine(virtualRoot.path(), ".manifest");
+	QString indexSha1 = QString::fromLatin1(ENV.fileHashes()->hash(indexPath).sha1.toHex());
+	QMap<QString, QString> oldManifest;
+	QString oldIndexSha1 = readManifest(manifestPath, oldManifest);
+	if (!indexSha1.isEmpty() && oldIndexSha1 == indexSha1 && manifestComplete(virtualRoot, oldManifest))
+	{
+		return virtualRoot;
+	}
+
 	qDebug() << "reconstructAssets" << assetsDir.path() << indexDir.path()
 				 << objectDir.path() << virtualDir.path() << virtualRoot.path();
 
@@ -152,33 +416,61 @@ QDir reconstructAssets(QString assetsId)
 	{
 		qDebug() << "Reconstructing virtual assets folder at" << virtualRoot.path();
 
-		for (QString map : index.objects.keys())
+		// files that belong to a different asset now, or to none at all, have to go
+		for (auto iter = oldManifest.constBegin(); iter != oldManifest.constEnd(); iter++)
 		{
-			AssetObject asset_object = index.objects.value(map);
-			QString target_path = FS::PathCombine(virtualRoot.path(), map);
-			QFile target(target_path);
-
-			QString tlk = asset_object.hash.left(2);
+			auto object = index.objects.constFind(iter.key());
+			if (object == index.objects.constEnd() || object->hash != iter.value())
+			{
+				QFile::remove(FS::PathCombine(virtualRoot.path(), iter.key()));
+			}
+		}
 
-			QString original_path = FS::PathCombine(objectDir.path(), tlk, asset_object.hash);
-			QFile original(original_path);
-			if (!original.exists())
+		QList<VirtualAsset> work;
+		QSet<QString> folders;
+		QMap<QString, QString> newManifest;
+		for (auto iter = index.objects.constBegin(); iter != index.objects.constEnd(); iter++)
+		{
+			VirtualAsset asset;
+			asset.target = FS::PathCombine(virtualRoot.path(), iter.key());
+			asset.original = FS::PathCombine(objectDir.path(), iter->hash.left(2), iter->hash);
+			if (oldManifest.value(iter.key()) == iter->hash && QFile::exists(asset.target))
+			{
+				newManifest.insert(iter.key(), iter->hash);
 				continue;
-			if (!target.exists())
+			}
+			asset.path = iter.key();
+			asset.hash = iter->hash;
+			folders.insert(QFileInfo(asset.target).absolutePath());
+			work.append(asset);
+		}
+
+		// create the folders up front, so the workers don't race each other doing it
+		for (auto &folder : folders)
+		{
+			QDir().mkpath(folder);
+		}
+		QtConcurrent::blockingMap(work, &placeVirtualAsset);
+
+		bool complete = true;
+		int placed = 0;
+		for (auto &asset : work)
+		{
+			if (asset.placed)
+			{
+				newManifest.insert(asset.path, asset.hash);
+				placed++;
+			}
+			else
 			{
-				QFileInfo info(target_path);
-				QDir target_dir = info.dir();
-				// qDebug() << target_dir;
-				if (!target_dir.exists())
-					QDir("").mkpath(target_dir.path());
-
-				bool couldCopy = original.copy(target_path);
-				qDebug() << " Copying" << original_path << "to" << target_path
-							 << QString::number(couldCopy); // << original.errorString();
+				complete = false;
 			}
 		}
+		qDebug() << "Placed" << placed << "of" << work.size() << "changed assets," << newManifest.size()
+				 << "of" << index.objects.size() << "total";
 
-		// TODO: Write last used time to virtualRoot/.lastused
+		// an incomplete tree gets checked again next time
+		writeManifest(manifestPath, complete ? indexSha1 : QString(), newManifest);
 	}
 
 	return virtualRoot;
@@ -192,7 +484,9 @@ NetActionPtr AssetObject::getDownloadAction()
 	if ((!objectFile.isFile()) || (objectFile.size() != size))
 	{
 		auto objectDL = MD5EtagDownload::make(getUrl(), objectFile.filePath());
-		objectDL->m_total_progress = size;
+		objectDL->setSizeHint(size);
+		// assets are named by their sha1
+		objectDL->m_expected_sha1 = hash;
 		return objectDL;
 	}
 	return nullptr;
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QString>
+
+class AssetsUtilsTestUtil
+{
+public:
+	/// an index about as big as the biggest one Mojang ships
+	static QByteArray syntheticIndex(int count, bool isVirtual)
+	{
+		QByteArray out = "{\"virtual\": ";
+		out += isVirtual ? "true" : "false";
+		out += ", \"objects\": {";
+		for (int i = 0; i < count; i++)
+		{
+			if (i)
+				out += ",";
+			auto hash = QCryptographicHash::hash(QByteArray::number(i), QCryptographicHash::Sha1).toHex();
+			out += QString("\"minecraft/sounds/thing%1/ü%2.ogg\": {\"hash\": \"%3\", \"size\": %4}")
+					   .arg(i % 50)
+					   .arg(i)
+					   .arg(QString::fromLatin1(hash))
+					   .arg(1000 + i * 7)
+					   .toUtf8();
+		}
+		out += "}}";
+		return out;
+	}
+};
@@ -0,0 +1,52 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include "TestUtil.h"
+
+#include "minecraft/AssetsUtils.h"
+#include "minecraft/AssetsUtilsTestUtil.h"
+#include "FileSystem.h"
+
+class AssetsUtilsBenchmark : public QObject, private AssetsUtilsTestUtil
+{
+	Q_OBJECT
+private
+slots:
+	void benchmark_LoadIndex()
+	{
+		QTemporaryDir dir;
+		QString path = FS::PathCombine(dir.path(), "big.json");
+		FS::write(path, syntheticIndex(4000, false));
+		const int rounds = 20;
+		QElapsedTimer timer;
+
+		timer.start();
+		for (int i = 0; i < rounds; i++)
+		{
+			QFile::remove(path + ".bin");
+			AssetsIndex index;
+			AssetsUtils::loadAssetsIndexJson("big", path, &index);
+		}
+		qint64 jsonTime = timer.elapsed();
+
+		timer.start();
+		for (int i = 0; i < rounds; i++)
+		{
+			AssetsIndex index;
+			AssetsUtils::loadAssetsIndexJson("big", path, &index);
+		}
+		qint64 sidecarTime = timer.elapsed();
+		qDebug() << "Loading a 4000 object index: JSON" << double(jsonTime) / rounds << "ms, compiled"
+				 << double(sidecarTime) / rounds << "ms";
+
+		QBENCHMARK
+		{
+			AssetsIndex index;
+			AssetsUtils::loadAssetsIndexJson("big", path, &index);
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN(AssetsUtilsBenchmark)
+
+#include "AssetsUtils_benchmark.moc"
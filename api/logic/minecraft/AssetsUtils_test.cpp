@@ -0,0 +1,109 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QCryptographicHash>
+#include <QDir>
+#include "TestUtil.h"
+
+#include "minecraft/AssetsUtils.h"
+#include "minecraft/AssetsUtilsTestUtil.h"
+#include "FileSystem.h"
+
+class AssetsUtilsTest : public QObject, private AssetsUtilsTestUtil
+{
+	Q_OBJECT
+private
+slots:
+	void test_SidecarRoundTrip()
+	{
+		QTemporaryDir dir;
+		QString path = FS::PathCombine(dir.path(), "test.json");
+		FS::write(path, syntheticIndex(100, true));
+
+		AssetsIndex fromJson;
+		QVERIFY(AssetsUtils::loadAssetsIndexJson("test", path, &fromJson));
+		QVERIFY(QFile::exists(path + ".bin"));
+
+		AssetsIndex fromSidecar;
+		QVERIFY(AssetsUtils::loadAssetsIndexJson("test", path, &fromSidecar));
+		QCOMPARE(fromSidecar.id, QString("test"));
+		QCOMPARE(fromSidecar.isVirtual, true);
+		QCOMPARE(fromSidecar.objects.keys(), fromJson.objects.keys());
+		for (auto &key : fromJson.objects.keys())
+		{
+			QCOMPARE(fromSidecar.objects[key].hash, fromJson.objects[key].hash);
+			QCOMPARE(fromSidecar.objects[key].size, fromJson.objects[key].size);
+		}
+	}
+
+	void test_SidecarInvalidation()
+	{
+		QTemporaryDir dir;
+		QString path = FS::PathCombine(dir.path(), "test.json");
+		FS::write(path, syntheticIndex(100, false));
+		AssetsIndex first;
+		QVERIFY(AssetsUtils::loadAssetsIndexJson("test", path, &first));
+		QCOMPARE(first.objects.size(), 100);
+
+		// the old sidecar must not be used for the new JSON
+		FS::write(path, syntheticIndex(120, false));
+		AssetsIndex second;
+		QVERIFY(AssetsUtils::loadAssetsIndexJson("test", path, &second));
+		QCOMPARE(second.objects.size(), 120);
+
+		// and a broken sidecar is ignored
+		FS::write(path + ".bin", "garbage");
+		AssetsIndex third;
+		QVERIFY(AssetsUtils::loadAssetsIndexJson("test", path, &third));
+		QCOMPARE(third.objects.size(), 120);
+	}
+
+	void test_VirtualReconstruction()
+	{
+		QTemporaryDir dir;
+		QString oldCwd = QDir::currentPath();
+		QDir::setCurrent(dir.path());
+
+		QStringList contents = {"one", "two", "three"};
+		QStringList hashes;
+		for (auto &content : contents)
+		{
+			auto hash = QString::fromLatin1(
+				QCryptographicHash::hash(content.toUtf8(), QCryptographicHash::Sha1).toHex());
+			FS::write(FS::PathCombine("assets/objects", hash.left(2), hash), content.toUtf8());
+			hashes.append(hash);
+		}
+		auto writeIndex = [&](QString a, QString b)
+		{
+			FS::write("assets/indexes/legacy.json",
+					  QString("{\"virtual\": true, \"objects\": {"
+							  "\"a.txt\": {\"hash\": \"%1\", \"size\": 3},"
+							  "\"sub/b.txt\": {\"hash\": \"%2\", \"size\": 3}}}")
+						  .arg(a)
+						  .arg(b)
+						  .toUtf8());
+		};
+
+		writeIndex(hashes[0], hashes[1]);
+		QDir root = AssetsUtils::reconstructAssets("legacy");
+		QCOMPARE(FS::read(root.filePath("a.txt")), QByteArray("one"));
+		QCOMPARE(FS::read(root.filePath("sub/b.txt")), QByteArray("two"));
+		QVERIFY(QFile::exists(root.filePath(".manifest")));
+
+		// only the changed file is replaced
+		writeIndex(hashes[0], hashes[2]);
+		AssetsUtils::reconstructAssets("legacy");
+		QCOMPARE(FS::read(root.filePath("a.txt")), QByteArray("one"));
+		QCOMPARE(FS::read(root.filePath("sub/b.txt")), QByteArray("three"));
+
+		// a deleted file comes back even though the index didn't change
+		QVERIFY(QFile::remove(root.filePath("a.txt")));
+		AssetsUtils::reconstructAssets("legacy");
+		QCOMPARE(FS::read(root.filePath("a.txt")), QByteArray("one"));
+
+		QDir::setCurrent(oldCwd);
+	}
+};
+
+QTEST_GUILESS_MAIN(AssetsUtilsTest)
+
+#include "AssetsUtils_test.moc"
@@ -68,17 +68,54 @@ void Library::getApplicableFiles(OpSys system, QStringList& jar, QStringList& na
 	}
 }
 
+QList<MojangDownloadInfo::Ptr> Library::getMojangDownloads(OpSys system) const
+{
+	QList<MojangDownloadInfo::Ptr> out;
+	if(!m_mojangDownloads)
+	{
+		return out;
+	}
+	if(m_mojangDownloads->artifact)
+	{
+		out.append(m_mojangDownloads->artifact);
+	}
+	if(m_nativeClassifiers.contains(system))
+	{
+		auto nativeClassifier = m_nativeClassifiers[system];
+		QStringList classifiers;
+		if(nativeClassifier.contains("${arch}"))
+		{
+			classifiers.append(QString(nativeClassifier).replace("${arch}", "32"));
+			classifiers.append(QString(nativeClassifier).replace("${arch}", "64"));
+		}
+		else
+		{
+			classifiers.append(nativeClassifier);
+		}
+		for(auto &classifier: classifiers)
+		{
+			auto info = m_mojangDownloads->classifiers.value(classifier);
+			if(info)
+			{
+				out.append(info);
+			}
+		}
+	}
+	return out;
+}
+
 QList<NetActionPtr> Library::getDownloads(OpSys system, HttpMetaCache * cache, QStringList &failedFiles) const
 {
 	QList<NetActionPtr> out;
 	bool isLocal = (hint() == "local");
 	bool isForge = (hint() == "forge-pack-xz");
 
-	auto add_download = [&](QString storage, QString dl)
+	auto add_download = [&](QString storage, QString dl, qint64 size, QString sha1)
 	{
-		auto entry = cache->resolveEntry("libraries", storage);
-		if (!entry->isStale())
+		// most libraries are already there, don't create cache handles for those
+		if (cache->checkEntry("libraries", storage))
 			return true;
+		auto entry = cache->resolveEntry("libraries", storage);
 		if(isLocal)
 		{
 			QFileInfo fileinfo(entry->getFullPath());
@@ -89,14 +126,21 @@ QList<NetActionPtr> Library::getDownloads(OpSys system, HttpMetaCache * cache, Q
 			}
 			return true;
 		}
+		NetActionPtr action;
 		if (isForge)
 		{
-			out.append(ForgeXzDownload::make(storage, entry));
+			action = ForgeXzDownload::make(storage, entry);
 		}
 		else
 		{
-			out.append(CacheDownload::make(dl, entry));
+			auto cacheDownload = CacheDownload::make(dl, entry);
+			cacheDownload->setExpectedSha1(sha1);
+			action = cacheDownload;
 		}
+		// libraries are needed to launch the game at all
+		action->setPriority(Priority_High);
+		action->setSizeHint(size);
+		out.append(action);
 		return true;
 	};
 
@@ -105,7 +149,7 @@ QList<NetActionPtr> Library::getDownloads(OpSys system, HttpMetaCache * cache, Q
 		if(m_mojangDownloads->artifact)
 		{
 			auto artifact = m_mojangDownloads->artifact;
-			add_download(artifact->path, artifact->url);
+			add_download(artifact->path, artifact->url, artifact->size, artifact->sha1);
 		}
 		if(m_nativeClassifiers.contains(system))
 		{
@@ -118,17 +162,17 @@ QList<NetActionPtr> Library::getDownloads(OpSys system, HttpMetaCache * cache, Q
 				nat64Classifier.replace("${arch}", "64");
 				auto nat32info = m_mojangDownloads->getDownloadInfo(nat32Classifier);
 				if(nat32info)
-					add_download(nat32info->path, nat32info->url);
+					add_download(nat32info->path, nat32info->url, nat32info->size, nat32info->sha1);
 				auto nat64info = m_mojangDownloads->getDownloadInfo(nat64Classifier);
 				if(nat64info)
-					add_download(nat64info->path, nat64info->url);
+					add_download(nat64info->path, nat64info->url, nat64info->size, nat64info->sha1);
 			}
 			else
 			{
 				auto info = m_mojangDownloads->getDownloadInfo(nativeClassifier);
 				if(info)
 				{
-					add_download(info->path, info->url);
+					add_download(info->path, info->url, info->size, info->sha1);
 				}
 			}
 		}
@@ -160,14 +204,14 @@ QList<NetActionPtr> Library::getDownloads(OpSys system, HttpMetaCache * cache, Q
 		{
 			QString cooked_storage = raw_storage;
 			QString cooked_dl = raw_dl;
-			add_download(cooked_storage.replace("${arch}", "32"), cooked_dl.replace("${arch}", "32"));
+			add_download(cooked_storage.replace("${arch}", "32"), cooked_dl.replace("${arch}", "32"), 0, QString());
 			cooked_storage = raw_storage;
 			cooked_dl = raw_dl;
-			add_download(cooked_storage.replace("${arch}", "64"), cooked_dl.replace("${arch}", "64"));
+			add_download(cooked_storage.replace("${arch}", "64"), cooked_dl.replace("${arch}", "64"), 0, QString());
 		}
 		else
 		{
-			add_download(raw_storage, raw_dl);
+			add_download(raw_storage, raw_dl, 0, QString());
 		}
 	}
 	return out;
@@ -128,6 +128,9 @@ public: /* methods */
 	// Get a list of downloads for this library
 	QList<NetActionPtr> getDownloads(OpSys system, class HttpMetaCache * cache, QStringList &failedFiles) const;
 
+	/// Get the Mojang download info (with checksums) of all the files this library uses on the system
+	QList<MojangDownloadInfo::Ptr> getMojangDownloads(OpSys system) const;
+
 private: /* methods */
 	/// the default storage prefix used by MultiMC
 	static QString defaultStoragePrefix();
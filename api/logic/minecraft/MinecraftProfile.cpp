@@ -588,6 +588,16 @@ QString MinecraftProfile::getMainJarUrl() const
 	}
 }
 
+QString MinecraftProfile::getMainJarSha1() const
+{
+	auto iter = mojangDownloads.find("client");
+	if(iter != mojangDownloads.end())
+	{
+		return iter.value()->sha1;
+	}
+	return QString();
+}
+
 void MinecraftProfile::installJarMods(QStringList selectedFiles)
 {
 	m_strategy->installJarMods(selectedFiles);
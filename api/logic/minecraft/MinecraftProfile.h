@@ -111,6 +111,8 @@ public: /* getters for profile variables */
 	const QList<JarmodPtr> & getJarMods() const;
 	const QList<LibraryPtr> & getLibraries() const;
 	QString getMainJarUrl() const;
+	/// hex encoded sha1 of the main jar, if known
+	QString getMainJarSha1() const;
 	bool hasTrait(const QString & trait) const;
 	ProblemSeverity getProblemSeverity() const;
 
@@ -19,20 +19,20 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QJsonValue>
-#include <quazip.h>
-#include <quazipfile.h>
+#include <QDataStream>
+#include "ZipIndex.h"
 
 #include "Mod.h"
 #include "settings/INIFile.h"
 #include <FileSystem.h>
 #include <QDebug>
 
-Mod::Mod(const QFileInfo &file)
+Mod::Mod(const QFileInfo &file, bool readContents)
 {
-	repath(file);
+	repath(file, readContents);
 }
 
-void Mod::repath(const QFileInfo &file)
+void Mod::repath(const QFileInfo &file, bool readContents)
 {
 	m_file = file;
 	QString name_base = file.fileName();
@@ -74,42 +74,34 @@ void Mod::repath(const QFileInfo &file)
 		m_name = name_base;
 	}
 
+	if (!readContents)
+	{
+		return;
+	}
+
 	if (m_type == MOD_ZIPFILE)
 	{
-		QuaZip zip(m_file.filePath());
-		if (!zip.open(QuaZip::mdUnzip))
+		ZipIndex zip(m_file.filePath());
+		if (!zip.isValid())
 			return;
 
-		QuaZipFile file(&zip);
-
-		if (zip.setCurrentFile("mcmod.info"))
+		QByteArray data;
+		if (zip.contains("mcmod.info"))
 		{
-			if (!file.open(QIODevice::ReadOnly))
+			if (zip.read("mcmod.info", data))
 			{
-				zip.close();
-				return;
+				ReadMCModInfo(data);
 			}
-
-			ReadMCModInfo(file.readAll());
-			file.close();
-			zip.close();
 			return;
 		}
-		else if (zip.setCurrentFile("forgeversion.properties"))
+		else if (zip.contains("forgeversion.properties"))
 		{
-			if (!file.open(QIODevice::ReadOnly))
+			if (zip.read("forgeversion.properties", data))
 			{
-				zip.close();
-				return;
+				ReadForgeInfo(data);
 			}
-
-			ReadForgeInfo(file.readAll());
-			file.close();
-			zip.close();
 			return;
 		}
-
-		zip.close();
 	}
 	else if (m_type == MOD_FOLDER)
 	{
@@ -127,24 +119,12 @@ void Mod::repath(const QFileInfo &file)
 	}
 	else if (m_type == MOD_LITEMOD)
 	{
-		QuaZip zip(m_file.filePath());
-		if (!zip.open(QuaZip::mdUnzip))
-			return;
-
-		QuaZipFile file(&zip);
-
-		if (zip.setCurrentFile("litemod.json"))
+		ZipIndex zip(m_file.filePath());
+		QByteArray data;
+		if (zip.read("litemod.json", data))
 		{
-			if (!file.open(QIODevice::ReadOnly))
-			{
-				zip.close();
-				return;
-			}
-
-			ReadLiteModInfo(file.readAll());
-			file.close();
+			ReadLiteModInfo(data);
 		}
-		zip.close();
 	}
 }
 
@@ -264,6 +244,18 @@ void Mod::ReadLiteModInfo(QByteArray contents)
 	m_homeurl = object.value("url").toString();
 }
 
+void Mod::writeMetadata(QDataStream &out) const
+{
+	out << m_mod_id << m_name << m_version << m_mcversion << m_homeurl << m_updateurl << m_description
+		<< m_authors << m_credits;
+}
+
+void Mod::readMetadata(QDataStream &in)
+{
+	in >> m_mod_id >> m_name >> m_version >> m_mcversion >> m_homeurl >> m_updateurl >> m_description
+		>> m_authors >> m_credits;
+}
+
 bool Mod::replace(Mod &with)
 {
 	if (!destroy())
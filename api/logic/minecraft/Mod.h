@@ -16,6 +16,8 @@
 #pragma once
 #include <QFileInfo>
 
+class QDataStream;
+
 class Mod
 {
 public:
@@ -28,7 +30,9 @@ public:
 		MOD_LITEMOD, //!< The mod is a litemod
 	};
 
-	Mod(const QFileInfo &file);
+	Mod() = default;
+	/// readContents = false skips looking inside the mod file, for when the metadata comes from elsewhere
+	Mod(const QFileInfo &file, bool readContents = true);
 
 	QFileInfo filename() const
 	{
@@ -98,7 +102,11 @@ public:
 	// replace this mod with a copy of the other
 	bool replace(Mod &with);
 	// change the mod's filesystem path (used by mod lists for *MAGIC* purposes)
-	void repath(const QFileInfo &file);
+	void repath(const QFileInfo &file, bool readContents = true);
+
+	// save and restore what was read from inside the mod file (used by ModMetadataCache)
+	void writeMetadata(QDataStream &out) const;
+	void readMetadata(QDataStream &in);
 
 	// WEAK compare operator - used for replacing mods
 	bool operator==(const Mod &other) const;
@@ -130,5 +138,5 @@ protected:
 	QString m_authors;
 	QString m_credits;
 
-	ModType m_type;
+	ModType m_type = MOD_UNKNOWN;
 };
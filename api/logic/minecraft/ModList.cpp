@@ -14,6 +14,9 @@
  */
 
 #include "ModList.h"
+#include "ModMetadataCache.h"
+#include "ContentStore.h"
+#include <Env.h>
 #include <FileSystem.h>
 #include <QMimeData>
 #include <QUrl>
@@ -22,7 +25,10 @@
 #include <QFileSystemWatcher>
 #include <QDebug>
 
-ModList::ModList(const QString &dir) : QAbstractListModel(), m_dir(dir)
+ModList::ModList(const QString &dir)
+	: QAbstractListModel(), m_dir(dir),
+	  m_scan(this, m_dir, mods, {&ModList::modKey, &ModList::sameMod, &ModList::modLessThan, nullptr,
+								 &ModList::needsScan, &ModList::scanMod, nullptr})
 {
 	FS::ensureFolderPathExists(m_dir.absolutePath());
 	m_dir.setFilter(QDir::Readable | QDir::NoDotAndDotDot | QDir::Files | QDir::Dirs |
@@ -32,11 +38,16 @@ ModList::ModList(const QString &dir) : QAbstractListModel(), m_dir(dir)
 	is_watching = false;
 	connect(m_watcher, SIGNAL(directoryChanged(QString)), this,
 			SLOT(directoryChanged(QString)));
+	setupFolderSettleTimer(m_updateTimer, this, SLOT(directorySettled()));
+	m_scan.onChanged([this]()
+	{
+		emit changed();
+	});
 }
 
 void ModList::startWatching()
 {
-	update();
+	updateAsync();
 	is_watching = m_watcher->addPath(m_dir.absolutePath());
 	if (is_watching)
 	{
@@ -61,17 +72,38 @@ void ModList::stopWatching()
 	}
 }
 
-void ModList::internalSort(QList<Mod> &what)
+bool ModList::modLessThan(const Mod &left, const Mod &right)
 {
-	auto predicate = [](const Mod &left, const Mod &right)
+	if (left.name() == right.name())
 	{
-		if (left.name() == right.name())
-		{
-			return left.mmc_id().localeAwareCompare(right.mmc_id()) < 0;
-		}
-		return left.name().localeAwareCompare(right.name()) < 0;
-	};
-	std::sort(what.begin(), what.end(), predicate);
+		return left.mmc_id().localeAwareCompare(right.mmc_id()) < 0;
+	}
+	return left.name().localeAwareCompare(right.name()) < 0;
+}
+
+void ModList::internalSort(QList<Mod> &what)
+{
+	std::sort(what.begin(), what.end(), &ModList::modLessThan);
+}
+
+Mod ModList::scanMod(const QFileInfo &file)
+{
+	return ENV.modMetadata()->get(file);
+}
+
+bool ModList::needsScan(const QFileInfo &file)
+{
+	return ENV.modMetadata()->needsScan(file);
+}
+
+QString ModList::modKey(const Mod &mod)
+{
+	return mod.filename().filePath();
+}
+
+bool ModList::sameMod(const Mod &left, const Mod &right)
+{
+	return left.strongCompare(right) && left.name() == right.name() && left.enabled() == right.enabled();
 }
 
 bool ModList::update()
@@ -79,54 +111,28 @@ bool ModList::update()
 	if (!isValid())
 		return false;
 
-	QList<Mod> orderedMods;
-	QList<Mod> newMods;
-	m_dir.refresh();
-	auto folderContents = m_dir.entryInfoList();
-	bool orderOrStateChanged = false;
-
-	// if there are any untracked files...
-	if (folderContents.size())
-	{
-		// the order surely changed!
-		for (auto entry : folderContents)
-		{
-			newMods.append(Mod(entry));
-		}
-		internalSort(newMods);
-		orderedMods.append(newMods);
-		orderOrStateChanged = true;
-	}
-	// otherwise, if we were already tracking some mods
-	else if (mods.size())
-	{
-		// if the number doesn't match, order changed.
-		if (mods.size() != orderedMods.size())
-			orderOrStateChanged = true;
-		// if it does match, compare the mods themselves
-		else
-			for (int i = 0; i < mods.size(); i++)
-			{
-				if (!mods[i].strongCompare(orderedMods[i]))
-				{
-					orderOrStateChanged = true;
-					break;
-				}
-			}
-	}
-	beginResetModel();
-	mods.swap(orderedMods);
-	endResetModel();
-	if (orderOrStateChanged)
-	{
-		emit changed();
-	}
+	m_updateTimer.stop();
+	m_scan.update();
 	return true;
 }
 
+void ModList::updateAsync()
+{
+	if (!isValid())
+		return;
+
+	m_updateTimer.stop();
+	m_scan.updateAsync();
+}
+
 void ModList::directoryChanged(QString path)
 {
-	update();
+	m_updateTimer.start();
+}
+
+void ModList::directorySettled()
+{
+	updateAsync();
 }
 
 bool ModList::isValid()
@@ -155,7 +161,8 @@ bool ModList::installMod(const QString &filename)
 	if (type == Mod::MOD_SINGLEFILE || type == Mod::MOD_ZIPFILE || type == Mod::MOD_LITEMOD)
 	{
 		QString newpath = FS::PathCombine(m_dir.path(), fileinfo.fileName());
-		if (!QFile::copy(fileinfo.filePath(), newpath))
+		auto store = ENV.contentStore();
+		if (store ? !store->install(fileinfo.filePath(), newpath) : !QFile::copy(fileinfo.filePath(), newpath))
 			return false;
 		m.repath(newpath);
 		update();
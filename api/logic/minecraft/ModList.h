@@ -19,8 +19,10 @@
 #include <QString>
 #include <QDir>
 #include <QAbstractListModel>
+#include <QTimer>
 
 #include "minecraft/Mod.h"
+#include "FolderModelScan.h"
 
 #include "multimc_logic_export.h"
 
@@ -35,6 +37,7 @@ class QFileSystemWatcher;
 class MULTIMC_LOGIC_EXPORT ModList : public QAbstractListModel
 {
 	Q_OBJECT
+	friend class ListModelDiff;
 public:
 	enum Columns
 	{
@@ -78,6 +81,12 @@ public:
 	/// Reloads the mod list and returns true if the list changed.
 	virtual bool update();
 
+	/**
+	 * Reloads the mod list in the background.
+	 * Mods that didn't change since they were last seen show up right away, the rest as they are scanned.
+	 */
+	void updateAsync();
+
 	/**
 	 * Adds the given mod to the list at the given index - if the list supports custom ordering
 	 */
@@ -106,6 +115,11 @@ public:
 
 private:
 	void internalSort(QList<Mod> & what);
+	static bool modLessThan(const Mod &left, const Mod &right);
+	static Mod scanMod(const QFileInfo &file);
+	static bool needsScan(const QFileInfo &file);
+	static QString modKey(const Mod &mod);
+	static bool sameMod(const Mod &left, const Mod &right);
 	struct OrderItem
 	{
 		QString id;
@@ -114,6 +128,7 @@ private:
 private
 slots:
 	void directoryChanged(QString path);
+	void directorySettled();
 
 signals:
 	void changed();
@@ -124,4 +139,6 @@ protected:
 	QDir m_dir;
 	QString m_list_id;
 	QList<Mod> mods;
+	QTimer m_updateTimer;
+	FolderModelScan<ModList, Mod> m_scan;
 };
@@ -1,6 +1,7 @@
 
 #include <QTest>
 #include <QTemporaryDir>
+#include <QSignalSpy>
 #include "TestUtil.h"
 
 #include "FileSystem.h"
@@ -46,6 +47,49 @@ slots:
 			verify(tempDir.path());
 		}
 	}
+
+	// rescanning only touches the rows that changed
+	void test_IncrementalUpdate()
+	{
+		QTemporaryDir tempDir;
+		auto add = [&](const QString &name)
+		{
+			FS::write(FS::PathCombine(tempDir.path(), name), "mod");
+		};
+		add("a.txt");
+		add("b.txt");
+		add("c.txt");
+		ModList m(tempDir.path());
+		m.update();
+		QCOMPARE(m.rowCount(QModelIndex()), 3);
+
+		QSignalSpy reset(&m, SIGNAL(modelReset()));
+		QSignalSpy inserted(&m, SIGNAL(rowsInserted(QModelIndex, int, int)));
+		QSignalSpy removed(&m, SIGNAL(rowsRemoved(QModelIndex, int, int)));
+		QSignalSpy changed(&m, SIGNAL(changed()));
+
+		m.update();
+		QCOMPARE(inserted.count() + removed.count() + changed.count(), 0);
+
+		add("d.txt");
+		add("e.txt");
+		QFile::remove(FS::PathCombine(tempDir.path(), "b.txt"));
+		m.update();
+		QCOMPARE(reset.count(), 0);
+		QCOMPARE(removed.count(), 1);
+		QCOMPARE(removed[0][1].toInt(), 1);
+		QCOMPARE(inserted.count(), 1);
+		QCOMPARE(inserted[0][1].toInt(), 2);
+		QCOMPARE(inserted[0][2].toInt(), 3);
+		QCOMPARE(changed.count(), 1);
+
+		QStringList names;
+		for (auto &mod : m.allMods())
+		{
+			names.append(mod.filename().fileName());
+		}
+		QCOMPARE(names, QStringList() << "a.txt" << "c.txt" << "d.txt" << "e.txt");
+	}
 };
 
 QTEST_GUILESS_MAIN(ModListTest)
@@ -0,0 +1,78 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ModMetadataCache.h"
+
+#include <QDataStream>
+
+namespace
+{
+// "MMCM"
+const quint32 indexMagic = 0x4d4d434d;
+// 2: records have an inode
+const quint32 indexVersion = 2;
+}
+
+ModMetadataCache::ModMetadataCache(const QString &indexPath) : m_cache(indexMagic, indexVersion, indexPath)
+{
+}
+
+bool ModMetadataCache::cacheable(const QFileInfo &file)
+{
+	// only these are opened to find out what's inside
+	if (!file.isFile())
+	{
+		return false;
+	}
+	Mod mod(file, false);
+	return mod.type() == Mod::MOD_ZIPFILE || mod.type() == Mod::MOD_LITEMOD;
+}
+
+bool ModMetadataCache::needsScan(const QFileInfo &file)
+{
+	QByteArray metadata;
+	return cacheable(file) && !m_cache.find(file.absoluteFilePath(), metadata);
+}
+
+Mod ModMetadataCache::get(const QFileInfo &file)
+{
+	if (!cacheable(file))
+	{
+		return Mod(file);
+	}
+
+	Mod mod(file, false);
+	bool opened = false;
+	QByteArray metadata;
+	bool found = m_cache.get(file.absoluteFilePath(), metadata, [&](QByteArray &out)
+	{
+		mod = Mod(file);
+		opened = true;
+		QDataStream stream(&out, QIODevice::WriteOnly);
+		mod.writeMetadata(stream);
+		return true;
+	});
+	if (!found)
+	{
+		// gone in the meantime
+		return Mod(file);
+	}
+	if (!opened)
+	{
+		QDataStream in(metadata);
+		mod.readMetadata(in);
+	}
+	return mod;
+}
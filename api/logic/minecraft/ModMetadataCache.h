@@ -0,0 +1,58 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+
+#include "PersistentFileCache.h"
+#include "minecraft/Mod.h"
+
+#include "multimc_logic_export.h"
+
+/*
+ * Remembers what was found inside mod files (mcmod.info, litemod.json, ...).
+ *
+ * Results are kept in a PersistentFileCache, so a mod file is only opened again when it changes.
+ *
+ * All the methods are thread safe.
+ */
+class MULTIMC_LOGIC_EXPORT ModMetadataCache
+{
+public:
+	/// supply path to the index file, or nothing for a cache that only lives in memory
+	explicit ModMetadataCache(const QString &indexPath = QString());
+
+	/// get the mod for a file, looking inside it only if it's not known or changed
+	Mod get(const QFileInfo &file);
+
+	/// true if get() would have to open the file
+	bool needsScan(const QFileInfo &file);
+
+	void load()
+	{
+		m_cache.load();
+	}
+	void save()
+	{
+		m_cache.save();
+	}
+
+private:
+	static bool cacheable(const QFileInfo &file);
+
+	PersistentFileCache<QByteArray> m_cache;
+};
@@ -0,0 +1,73 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include "TestUtil.h"
+
+#include "minecraft/ModMetadataCache.h"
+#include "MMCZip.h"
+#include <FileSystem.h>
+
+class ModMetadataCacheTest : public QObject
+{
+	Q_OBJECT
+
+	QString makeMod(const QString &root, const QString &fileName, const QString &name)
+	{
+		QString folder = FS::PathCombine(root, fileName + "_contents");
+		FS::write(FS::PathCombine(folder, "mcmod.info"),
+				  QString("[{\"modid\": \"test\", \"name\": \"%1\", \"version\": \"1.0\"}]").arg(name).toUtf8());
+		QString path = FS::PathCombine(root, fileName);
+		QFile::remove(path);
+		MMCZip::compressDir(path, folder);
+		return path;
+	}
+
+private
+slots:
+	void test_Cache()
+	{
+		QTemporaryDir dir;
+		auto path = makeMod(dir.path(), "test.jar", "Test Mod");
+		QString index = FS::PathCombine(dir.path(), "modcache");
+		{
+			ModMetadataCache cache(index);
+			QVERIFY(cache.needsScan(QFileInfo(path)));
+			auto mod = cache.get(QFileInfo(path));
+			QCOMPARE(mod.name(), QString("Test Mod"));
+			QCOMPARE(mod.version(), QString("1.0"));
+			QVERIFY(!cache.needsScan(QFileInfo(path)));
+		}
+		QVERIFY(QFile::exists(index));
+
+		ModMetadataCache cache(index);
+		cache.load();
+		QVERIFY(!cache.needsScan(QFileInfo(path)));
+		auto mod = cache.get(QFileInfo(path));
+		QCOMPARE(mod.name(), QString("Test Mod"));
+		QCOMPARE(mod.mod_id(), QString("test"));
+		QCOMPARE(mod.type(), Mod::MOD_ZIPFILE);
+
+		// a changed file gets scanned again
+		QTest::qWait(1100);
+		makeMod(dir.path(), "test.jar", "Other Mod");
+		QVERIFY(cache.needsScan(QFileInfo(path)));
+		QCOMPARE(cache.get(QFileInfo(path)).name(), QString("Other Mod"));
+	}
+
+	void test_NotCached()
+	{
+		QTemporaryDir dir;
+		QString folder = FS::PathCombine(dir.path(), "folder_mod");
+		QDir().mkpath(folder);
+		QString file = FS::PathCombine(dir.path(), "notes.txt");
+		FS::write(file, "hi");
+		ModMetadataCache cache;
+		QVERIFY(!cache.needsScan(QFileInfo(folder)));
+		QVERIFY(!cache.needsScan(QFileInfo(file)));
+		QCOMPARE(cache.get(QFileInfo(folder)).type(), Mod::MOD_FOLDER);
+		QCOMPARE(cache.get(QFileInfo(file)).type(), Mod::MOD_SINGLEFILE);
+	}
+};
+
+QTEST_GUILESS_MAIN(ModMetadataCacheTest)
+
+#include "ModMetadataCache_test.moc"
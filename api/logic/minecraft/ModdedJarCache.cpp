@@ -0,0 +1,264 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ModdedJarCache.h"
+#include "Env.h"
+#include "FileHashCache.h"
+#include "FileSystem.h"
+#include "MMCZip.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QUuid>
+#include <QDebug>
+
+#include <algorithm>
+
+namespace
+{
+// change this when createModdedJar starts producing different jars
+const char *keyVersion = "moddedjar-2";
+const char *indexName = "index.json";
+// eviction only needs to know roughly when a jar was used last, so the index isn't written on every launch
+const qint64 touchGranularity = 24ll * 60 * 60 * 1000;
+}
+
+ModdedJarCache::ModdedJarCache(const QString &root, qint64 maxSize, int maxEntries)
+	: m_root(root), m_max_size(maxSize), m_max_entries(maxEntries)
+{
+}
+
+QString ModdedJarCache::key(const QString &sourceJarPath, const QList<Mod> &mods) const
+{
+	auto hashes = ENV.fileHashes();
+	QCryptographicHash key(QCryptographicHash::Sha1);
+	key.addData(keyVersion);
+
+	auto base = hashes->hash(sourceJarPath);
+	if (!base.isValid())
+	{
+		return QString();
+	}
+	key.addData(base.sha1);
+
+	for (auto &mod : mods)
+	{
+		auto file = mod.filename();
+		key.addData("\nmod ");
+		key.addData(QByteArray::number(mod.type()));
+		key.addData(mod.enabled() ? " enabled " : " disabled ");
+		// single files and folders keep their names inside the jar
+		key.addData(file.fileName().toUtf8());
+		if (mod.type() == Mod::MOD_FOLDER)
+		{
+			QDir folder(file.absoluteFilePath());
+			QStringList paths;
+			QDirIterator iter(folder.absolutePath(), QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+			while (iter.hasNext())
+			{
+				paths.append(folder.relativeFilePath(iter.next()));
+			}
+			paths.sort();
+			for (auto &path : paths)
+			{
+				auto fileHashes = hashes->hash(folder.absoluteFilePath(path));
+				if (!fileHashes.isValid())
+				{
+					return QString();
+				}
+				key.addData("\n" + path.toUtf8() + " ");
+				key.addData(fileHashes.sha1);
+			}
+		}
+		else if (file.isFile())
+		{
+			auto fileHashes = hashes->hash(file.absoluteFilePath());
+			if (!fileHashes.isValid())
+			{
+				return QString();
+			}
+			key.addData(fileHashes.sha1);
+		}
+	}
+	return QString::fromLatin1(key.result().toHex());
+}
+
+QString ModdedJarCache::entryPath(const QString &key) const
+{
+	return FS::PathCombine(m_root, key + ".jar");
+}
+
+bool ModdedJarCache::install(const QString &sourceJarPath, const QList<Mod> &mods, const QString &targetJarPath)
+{
+	m_last_cached = false;
+	if (QFile::exists(targetJarPath) && !QFile::remove(targetJarPath))
+	{
+		qCritical() << "Couldn't remove" << targetJarPath;
+		return false;
+	}
+
+	auto jarKey = key(sourceJarPath, mods);
+	if (jarKey.isEmpty())
+	{
+		// can't cache what can't be hashed. Let it fail the usual way.
+		qWarning() << "Couldn't compute the modded jar key, building it without the cache";
+		return MMCZip::createModdedJar(sourceJarPath, targetJarPath, mods);
+	}
+
+	auto cached = entryPath(jarKey);
+	if (QFile::exists(cached))
+	{
+		m_last_cached = true;
+		qDebug() << "Using cached modded jar" << cached;
+		touch(jarKey, loadIndex());
+	}
+	else
+	{
+		if (!build(sourceJarPath, mods, jarKey))
+		{
+			return false;
+		}
+		// this also records the new jar as used
+		evict(jarKey);
+	}
+
+	if (!FS::cloneOrCopy(cached, targetJarPath))
+	{
+		qCritical() << "Couldn't put" << cached << "at" << targetJarPath;
+		return false;
+	}
+	return true;
+}
+
+bool ModdedJarCache::build(const QString &sourceJarPath, const QList<Mod> &mods, const QString &key)
+{
+	if (!FS::ensureFolderPathExists(m_root))
+	{
+		qCritical() << "Couldn't create" << m_root;
+		return false;
+	}
+	// build under a unique name, so two instances building the same jar don't collide
+	auto tempPath = FS::PathCombine(m_root, key + "." + QUuid::createUuid().toString().mid(1, 8) + ".tmp");
+	qDebug() << "Building modded jar" << key;
+	if (!MMCZip::createModdedJar(sourceJarPath, tempPath, mods))
+	{
+		QFile::remove(tempPath);
+		return false;
+	}
+	if (!QFile::rename(tempPath, entryPath(key)))
+	{
+		QFile::remove(tempPath);
+		// somebody else was faster
+		if (!QFile::exists(entryPath(key)))
+		{
+			qCritical() << "Couldn't move the modded jar into" << entryPath(key);
+			return false;
+		}
+	}
+	return true;
+}
+
+QMap<QString, qint64> ModdedJarCache::loadIndex() const
+{
+	QMap<QString, qint64> index;
+	QFile file(FS::PathCombine(m_root, indexName));
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		return index;
+	}
+	auto object = QJsonDocument::fromJson(file.readAll()).object();
+	for (auto iter = object.constBegin(); iter != object.constEnd(); iter++)
+	{
+		index.insert(iter.key(), (qint64)iter.value().toDouble());
+	}
+	return index;
+}
+
+void ModdedJarCache::saveIndex(const QMap<QString, qint64> &index) const
+{
+	QJsonObject object;
+	for (auto iter = index.constBegin(); iter != index.constEnd(); iter++)
+	{
+		object.insert(iter.key(), (double)iter.value());
+	}
+	try
+	{
+		FS::write(FS::PathCombine(m_root, indexName), QJsonDocument(object).toJson(QJsonDocument::Compact));
+	}
+	catch (Exception &e)
+	{
+		qWarning() << e.what();
+	}
+}
+
+void ModdedJarCache::touch(const QString &key, const QMap<QString, qint64> &index)
+{
+	auto now = QDateTime::currentMSecsSinceEpoch();
+	if (index.contains(key) && now - index[key] < touchGranularity)
+	{
+		return;
+	}
+	auto updated = index;
+	updated[key] = now;
+	saveIndex(updated);
+}
+
+void ModdedJarCache::evict(const QString &keep)
+{
+	struct Entry
+	{
+		QString key;
+		qint64 size;
+		qint64 lastUsed;
+	};
+
+	auto index = loadIndex();
+	QList<Entry> entries;
+	qint64 totalSize = 0;
+	QDir root(m_root);
+	auto now = QDateTime::currentMSecsSinceEpoch();
+	for (auto &info : root.entryInfoList(QStringList() << "*.jar", QDir::Files))
+	{
+		auto entryKey = info.completeBaseName();
+		// jars nobody remembers using go first
+		qint64 lastUsed = entryKey == keep ? now : index.value(entryKey, info.lastModified().toMSecsSinceEpoch());
+		entries.append({entryKey, info.size(), lastUsed});
+		totalSize += info.size();
+	}
+	std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b)
+	{
+		return a.lastUsed < b.lastUsed;
+	});
+
+	QMap<QString, qint64> remaining;
+	int count = entries.size();
+	for (auto &entry : entries)
+	{
+		bool overLimit = totalSize > m_max_size || count > m_max_entries;
+		if (overLimit && entry.key != keep && QFile::remove(entryPath(entry.key)))
+		{
+			qDebug() << "Evicted modded jar" << entry.key;
+			totalSize -= entry.size;
+			count--;
+			continue;
+		}
+		remaining.insert(entry.key, entry.lastUsed);
+	}
+	saveIndex(remaining);
+}
@@ -0,0 +1,73 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QList>
+#include <QMap>
+
+#include "minecraft/Mod.h"
+
+#include "multimc_logic_export.h"
+
+/*
+ * Keeps jar modded minecraft.jar files around, so they don't have to be built on every launch.
+ *
+ * The jars are stored under a key made from the hash of the base jar and the hashes, names,
+ * types and enabled flags of the jar mods, in order. Jars are put into instances as copy on write
+ * clones where the filesystem can do that, as copies otherwise. Never as hard links: whatever
+ * patches the jar of one instance in place must not change it for all the others.
+ *
+ * The least recently used jars are removed when the cache grows over its limits.
+ */
+class MULTIMC_LOGIC_EXPORT ModdedJarCache
+{
+public:
+	explicit ModdedJarCache(const QString &root, qint64 maxSize = 512 * 1024 * 1024, int maxEntries = 16);
+
+	/// compute the key for the given jar and mods. Empty if any of the files can't be read.
+	QString key(const QString &sourceJarPath, const QList<Mod> &mods) const;
+
+	/// where the jar for the key is (or would be) stored
+	QString entryPath(const QString &key) const;
+
+	/**
+	 * Put the modded jar at targetJarPath, replacing anything that is there.
+	 * The jar is only built if it isn't in the cache already.
+	 */
+	bool install(const QString &sourceJarPath, const QList<Mod> &mods, const QString &targetJarPath);
+
+	/// true if the last install() didn't have to build the jar
+	bool lastInstallWasCached() const
+	{
+		return m_last_cached;
+	}
+
+	/// remove the least recently used jars until the cache fits into the limits. keep is never removed and counts as just used.
+	void evict(const QString &keep = QString());
+
+private:
+	bool build(const QString &sourceJarPath, const QList<Mod> &mods, const QString &key);
+	QMap<QString, qint64> loadIndex() const;
+	void saveIndex(const QMap<QString, qint64> &index) const;
+	void touch(const QString &key, const QMap<QString, qint64> &index);
+
+private:
+	QString m_root;
+	qint64 m_max_size;
+	int m_max_entries;
+	bool m_last_cached = false;
+};
@@ -0,0 +1,110 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include "TestUtil.h"
+
+#include "minecraft/ModdedJarCache.h"
+#include "MMCZip.h"
+#include <FileSystem.h>
+
+class ModdedJarCacheTest : public QObject
+{
+	Q_OBJECT
+
+	QString makeJar(const QString &root, const QString &name, const QByteArray &content)
+	{
+		QString folder = FS::PathCombine(root, name + "_contents");
+		FS::write(FS::PathCombine(folder, "file.txt"), content);
+		QString jar = FS::PathCombine(root, name + ".jar");
+		MMCZip::compressDir(jar, folder);
+		return jar;
+	}
+
+private
+slots:
+	void test_Reuse()
+	{
+		QTemporaryDir dir;
+		auto base = makeJar(dir.path(), "base", "base");
+		auto modJar = makeJar(dir.path(), "mod", "mod");
+		QList<Mod> mods{Mod(QFileInfo(modJar))};
+
+		ModdedJarCache cache(FS::PathCombine(dir.path(), "cache"));
+		auto target = FS::PathCombine(dir.path(), "minecraft.jar");
+		QVERIFY(cache.install(base, mods, target));
+		QVERIFY(!cache.lastInstallWasCached());
+		QVERIFY(QFile::exists(target));
+		auto key = cache.key(base, mods);
+		QVERIFY(!key.isEmpty());
+		QVERIFY(QFile::exists(cache.entryPath(key)));
+
+		QVERIFY(cache.install(base, mods, target));
+		QVERIFY(cache.lastInstallWasCached());
+		QVERIFY(QFile::exists(target));
+
+		// a changed mod means a different jar
+		FS::write(FS::PathCombine(dir.path(), "mod_contents/file.txt"), "changed");
+		QFile::remove(modJar);
+		MMCZip::compressDir(modJar, FS::PathCombine(dir.path(), "mod_contents"));
+		QVERIFY(cache.key(base, mods) != key);
+		QVERIFY(cache.install(base, mods, target));
+		QVERIFY(!cache.lastInstallWasCached());
+	}
+
+	void test_Isolation()
+	{
+		QTemporaryDir dir;
+		auto base = makeJar(dir.path(), "base", "base");
+		QList<Mod> mods{Mod(QFileInfo(makeJar(dir.path(), "mod", "mod")))};
+		ModdedJarCache cache(FS::PathCombine(dir.path(), "cache"));
+		auto first = FS::PathCombine(dir.path(), "first.jar");
+		auto second = FS::PathCombine(dir.path(), "second.jar");
+		QVERIFY(cache.install(base, mods, first));
+		QVERIFY(cache.install(base, mods, second));
+		QVERIFY(cache.lastInstallWasCached());
+		auto entry = cache.entryPath(cache.key(base, mods));
+		auto original = FS::read(entry);
+		QVERIFY(!FS::sameFile(first, entry));
+
+		// patching one instance's jar in place leaves the cache and the other instances alone
+		QFile jar(first);
+		QVERIFY(jar.open(QIODevice::ReadWrite));
+		QVERIFY(jar.seek(0));
+		jar.write("garbage");
+		jar.close();
+		QCOMPARE(FS::read(entry), original);
+		QCOMPARE(FS::read(second), original);
+
+		// using a cached jar again doesn't rewrite the index every time
+		auto indexPath = FS::PathCombine(dir.path(), "cache/index.json");
+		auto indexBefore = QFileInfo(indexPath).lastModified();
+		QTest::qWait(1100);
+		QVERIFY(cache.install(base, mods, second));
+		QVERIFY(cache.lastInstallWasCached());
+		QCOMPARE(QFileInfo(indexPath).lastModified(), indexBefore);
+	}
+
+	void test_Eviction()
+	{
+		QTemporaryDir dir;
+		auto base = makeJar(dir.path(), "base", "base");
+		ModdedJarCache cache(FS::PathCombine(dir.path(), "cache"), 1024 * 1024, 2);
+		auto target = FS::PathCombine(dir.path(), "minecraft.jar");
+		QStringList keys;
+		for (int i = 0; i < 3; i++)
+		{
+			auto name = QString("mod%1").arg(i);
+			QList<Mod> mods{Mod(QFileInfo(makeJar(dir.path(), name, name.toUtf8())))};
+			QVERIFY(cache.install(base, mods, target));
+			keys.append(cache.key(base, mods));
+			// make sure the entries don't share a timestamp
+			QTest::qWait(5);
+		}
+		QVERIFY(!QFile::exists(cache.entryPath(keys[0])));
+		QVERIFY(QFile::exists(cache.entryPath(keys[1])));
+		QVERIFY(QFile::exists(cache.entryPath(keys[2])));
+	}
+};
+
+QTEST_GUILESS_MAIN(ModdedJarCacheTest)
+
+#include "ModdedJarCache_test.moc"
@@ -16,7 +16,7 @@ struct MojangDownloadInfo
 	/// sha-1 checksum of the file
 	QString sha1;
 	/// size of the file in bytes
-	int size;
+	int size = 0;
 };
 
 
@@ -0,0 +1,416 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NBTReader.h"
+#include "GZip.h"
+
+#include <QBuffer>
+#include <QSet>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+// the inflated data goes through a buffer of this size
+const int bufferSize = 64 * 1024;
+// nobody nests this deep, except broken or malicious files
+const int maxDepth = 512;
+
+enum TagType
+{
+	TagEnd = 0,
+	TagByte,
+	TagShort,
+	TagInt,
+	TagLong,
+	TagFloat,
+	TagDouble,
+	TagByteArray,
+	TagString,
+	TagList,
+	TagCompound,
+	TagIntArray,
+	TagLongArray
+};
+
+// payload size of the tags that have a fixed one, 0 for the others
+int fixedSize(int type)
+{
+	switch (type)
+	{
+	case TagByte:
+		return 1;
+	case TagShort:
+		return 2;
+	case TagInt:
+	case TagFloat:
+		return 4;
+	case TagLong:
+	case TagDouble:
+		return 8;
+	default:
+		return 0;
+	}
+}
+
+class Parser
+{
+public:
+	Parser(QIODevice *device, const QStringList &paths, QVariantMap &values)
+		: m_gzip(device), m_values(values), m_output(bufferSize, 0)
+	{
+		for (auto &path : paths)
+		{
+			m_wanted.insert(path);
+			// everything on the way to a wanted value has to be looked into
+			auto parts = path.split('/');
+			for (int i = 1; i < parts.size(); i++)
+			{
+				m_prefixes.insert(QStringList(parts.mid(0, i)).join('/'));
+			}
+		}
+	}
+
+	bool run()
+	{
+		if (!m_gzip.open(QIODevice::ReadOnly | QIODevice::Unbuffered))
+		{
+			return false;
+		}
+
+		quint8 type = 0;
+		if (!readNumber(type) || type != TagCompound || !skipString())
+		{
+			return false;
+		}
+		return compound(QString(), 0);
+	}
+
+private:
+	bool finished() const
+	{
+		return m_values.size() == m_wanted.size();
+	}
+
+	// make sure there is some inflated data to take from
+	bool fill()
+	{
+		if (m_outputPos == m_outputEnd)
+		{
+			auto got = m_gzip.read(m_output.data(), bufferSize);
+			if (got <= 0)
+			{
+				return false;
+			}
+			m_outputPos = 0;
+			m_outputEnd = int(got);
+		}
+		return true;
+	}
+
+	bool take(char *destination, qint64 size)
+	{
+		while (size > 0)
+		{
+			if (!fill())
+			{
+				return false;
+			}
+			int chunk = int(std::min<qint64>(size, m_outputEnd - m_outputPos));
+			memcpy(destination, m_output.constData() + m_outputPos, chunk);
+			m_outputPos += chunk;
+			destination += chunk;
+			size -= chunk;
+		}
+		return true;
+	}
+
+	bool skip(qint64 size)
+	{
+		while (size > 0)
+		{
+			if (!fill())
+			{
+				return false;
+			}
+			int chunk = int(std::min<qint64>(size, m_outputEnd - m_outputPos));
+			m_outputPos += chunk;
+			size -= chunk;
+		}
+		return true;
+	}
+
+	template <typename T> bool readNumber(T &value)
+	{
+		uchar data[sizeof(T)];
+		if (!take(reinterpret_cast<char *>(data), sizeof(T)))
+		{
+			return false;
+		}
+		value = qFromBigEndian<T>(data);
+		return true;
+	}
+
+	bool readString(QString &value)
+	{
+		quint16 length = 0;
+		if (!readNumber(length))
+		{
+			return false;
+		}
+		QByteArray data(length, Qt::Uninitialized);
+		if (!take(data.data(), length))
+		{
+			return false;
+		}
+		// really Java's modified UTF-8, which only differs for NUL and characters outside the BMP
+		value = QString::fromUtf8(data);
+		return true;
+	}
+
+	bool skipString()
+	{
+		quint16 length = 0;
+		return readNumber(length) && skip(length);
+	}
+
+	// skip an array of count elements of the given size
+	bool skipArray(int elementSize)
+	{
+		qint32 count = 0;
+		if (!readNumber(count) || count < 0)
+		{
+			return false;
+		}
+		return skip(qint64(count) * elementSize);
+	}
+
+	bool skipPayload(int type, int depth)
+	{
+		if (depth > maxDepth)
+		{
+			return false;
+		}
+		if (auto size = fixedSize(type))
+		{
+			return skip(size);
+		}
+		switch (type)
+		{
+		case TagByteArray:
+			return skipArray(1);
+		case TagIntArray:
+			return skipArray(4);
+		case TagLongArray:
+			return skipArray(8);
+		case TagString:
+			return skipString();
+		case TagList:
+		{
+			quint8 elementType = 0;
+			qint32 count = 0;
+			if (!readNumber(elementType) || !readNumber(count) || count < 0)
+			{
+				return false;
+			}
+			if (elementType == TagEnd)
+			{
+				return true;
+			}
+			if (auto size = fixedSize(elementType))
+			{
+				return skip(qint64(count) * size);
+			}
+			for (qint32 i = 0; i < count; i++)
+			{
+				if (!skipPayload(elementType, depth + 1))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+		case TagCompound:
+		{
+			while (true)
+			{
+				quint8 tagType = 0;
+				if (!readNumber(tagType))
+				{
+					return false;
+				}
+				if (tagType == TagEnd)
+				{
+					return true;
+				}
+				if (!skipString() || !skipPayload(tagType, depth + 1))
+				{
+					return false;
+				}
+			}
+		}
+		default:
+			return false;
+		}
+	}
+
+	template <typename T> bool readInteger(const QString &path)
+	{
+		T value = 0;
+		if (!readNumber(value))
+		{
+			return false;
+		}
+		m_values.insert(path, qint64(value));
+		return true;
+	}
+
+	bool readValue(int type, const QString &path)
+	{
+		switch (type)
+		{
+		case TagByte:
+			return readInteger<qint8>(path);
+		case TagShort:
+			return readInteger<qint16>(path);
+		case TagInt:
+			return readInteger<qint32>(path);
+		case TagLong:
+			return readInteger<qint64>(path);
+		case TagFloat:
+		{
+			quint32 bits = 0;
+			if (!readNumber(bits))
+			{
+				return false;
+			}
+			float value;
+			memcpy(&value, &bits, sizeof(value));
+			m_values.insert(path, double(value));
+			return true;
+		}
+		case TagDouble:
+		{
+			quint64 bits = 0;
+			if (!readNumber(bits))
+			{
+				return false;
+			}
+			double value;
+			memcpy(&value, &bits, sizeof(value));
+			m_values.insert(path, value);
+			return true;
+		}
+		case TagString:
+		{
+			QString value;
+			if (!readString(value))
+			{
+				return false;
+			}
+			m_values.insert(path, value);
+			return true;
+		}
+		default:
+			// not something we can hand out, pretend it's not there
+			m_wanted.remove(path);
+			return skipPayload(type, 0);
+		}
+	}
+
+	bool compound(const QString &prefix, int depth)
+	{
+		if (depth > maxDepth)
+		{
+			return false;
+		}
+		while (!finished())
+		{
+			quint8 type = 0;
+			if (!readNumber(type))
+			{
+				return false;
+			}
+			if (type == TagEnd)
+			{
+				return true;
+			}
+			QString name;
+			if (!readString(name))
+			{
+				return false;
+			}
+			QString path = prefix.isEmpty() ? name : prefix + '/' + name;
+			bool ok;
+			if (type == TagCompound && m_wanted.contains(path))
+			{
+				// just a marker, the contents can be asked for separately
+				m_values.insert(path, QVariantMap());
+				ok = m_prefixes.contains(path) ? compound(path, depth + 1) : skipPayload(type, depth + 1);
+			}
+			else if (type == TagCompound && m_prefixes.contains(path))
+			{
+				ok = compound(path, depth + 1);
+			}
+			else if (m_wanted.contains(path))
+			{
+				ok = readValue(type, path);
+			}
+			else
+			{
+				ok = skipPayload(type, depth + 1);
+			}
+			if (!ok)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	GZipReader m_gzip;
+	QVariantMap &m_values;
+	QSet<QString> m_wanted;
+	QSet<QString> m_prefixes;
+
+	QByteArray m_output;
+	int m_outputPos = 0;
+	int m_outputEnd = 0;
+};
+}
+
+NBTReader::NBTReader(QIODevice *device) : m_device(device)
+{
+}
+
+bool NBTReader::read(const QStringList &paths, QVariantMap &values)
+{
+	values.clear();
+	Parser parser(m_device, paths, values);
+	return parser.run();
+}
+
+bool NBTReader::read(const QByteArray &data, const QStringList &paths, QVariantMap &values)
+{
+	QBuffer buffer;
+	buffer.setData(data);
+	if (!buffer.open(QIODevice::ReadOnly))
+	{
+		return false;
+	}
+	return NBTReader(&buffer).read(paths, values);
+}
@@ -0,0 +1,52 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QIODevice>
+#include <QStringList>
+#include <QVariantMap>
+#include <QByteArray>
+
+#include "multimc_logic_export.h"
+
+/*
+ * Picks a few values out of gzip compressed NBT data (level.dat and friends) without building a tag tree.
+ *
+ * The data is inflated through fixed size buffers straight into the tokenizer, so memory use doesn't
+ * depend on the size of the file. Everything that wasn't asked for is skipped as it streams by, and
+ * reading stops as soon as all the requested values are found.
+ *
+ * Paths are tag names separated by '/', starting below the root compound: "Data/LevelName".
+ * Numbers, strings and compounds can be requested. Integers come out as qint64, floats as double,
+ * strings as QString. Compounds come out as an empty QVariantMap, only to tell that they are there;
+ * their contents can be requested at the same time with longer paths.
+ */
+class MULTIMC_LOGIC_EXPORT NBTReader
+{
+public:
+	/// the device has to stay open and alive while reading
+	explicit NBTReader(QIODevice *device);
+
+	/// Reads the values at the given paths. Paths that aren't there are missing from the result.
+	/// Returns false if the data is broken before all of them were found.
+	bool read(const QStringList &paths, QVariantMap &values);
+
+	/// same as above, for compressed data in memory
+	static bool read(const QByteArray &data, const QStringList &paths, QVariantMap &values);
+
+private:
+	QIODevice *m_device;
+};
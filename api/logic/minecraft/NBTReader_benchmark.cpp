@@ -0,0 +1,46 @@
+#include <QTest>
+#include <QElapsedTimer>
+#include "TestUtil.h"
+
+#include "minecraft/NBTReader.h"
+#include "minecraft/NBTTestUtil.h"
+#include "GZip.h"
+
+class NBTReaderBenchmark : public QObject, private NBTTestUtil
+{
+	Q_OBJECT
+
+private
+slots:
+	void benchmark_LevelDat()
+	{
+		auto nbt = makeLevelDat(20000, 16 * 1024 * 1024);
+		QByteArray compressed;
+		QVERIFY(GZip::zip(nbt, compressed));
+		const QStringList paths = {"Data/LevelName", "Data/LastPlayed", "Data/RandomSeed"};
+
+		QElapsedTimer timer;
+		timer.start();
+		QVariantMap values;
+		QVERIFY(NBTReader::read(compressed, paths, values));
+		auto streamingTime = timer.nsecsElapsed();
+		QCOMPARE(values.size(), 3);
+
+		// what World used to do before it even started building the tag tree
+		timer.restart();
+		QByteArray inflated;
+		QVERIFY(GZip::unzip(compressed, inflated));
+		std::string copy(inflated.constData(), inflated.size());
+		auto inflateTime = timer.nsecsElapsed();
+		QCOMPARE(int(copy.size()), nbt.size());
+
+		qDebug() << "level.dat with" << nbt.size() << "bytes of NBT," << compressed.size() << "compressed:";
+		qDebug() << "  NBTReader:" << streamingTime / 1000 << "us, 128 KiB of buffers";
+		qDebug() << "  GZip::unzip + copy (before parsing):" << inflateTime / 1000 << "us,"
+				 << (inflated.capacity() + copy.capacity()) / 1024 << "KiB";
+	}
+};
+
+QTEST_GUILESS_MAIN(NBTReaderBenchmark)
+
+#include "NBTReader_benchmark.moc"
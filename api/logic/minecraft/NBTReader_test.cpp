@@ -0,0 +1,68 @@
+#include <QTest>
+#include "TestUtil.h"
+
+#include "minecraft/NBTReader.h"
+#include "minecraft/NBTTestUtil.h"
+#include "GZip.h"
+
+class NBTReaderTest : public QObject, private NBTTestUtil
+{
+	Q_OBJECT
+
+private
+slots:
+	void test_Read()
+	{
+		QByteArray compressed;
+		QVERIFY(GZip::zip(makeLevelDat(100, 1000), compressed));
+
+		QVariantMap values;
+		QVERIFY(NBTReader::read(compressed, {"Data/LevelName", "Data/LastPlayed", "Data/RandomSeed", "Data/version",
+											 "Data/Player/Inventory", "Data/Missing", "Missing/LevelName"},
+								values));
+		QCOMPARE(values.size(), 4);
+		QCOMPARE(values["Data/LevelName"].toString(), QString("Modded World"));
+		QCOMPARE(values["Data/LastPlayed"].toLongLong(), 1450000000000LL);
+		QCOMPARE(values["Data/RandomSeed"].toLongLong(), -1234567890123LL);
+		QCOMPARE(values["Data/version"].toLongLong(), 19133LL);
+	}
+
+	void test_Compound()
+	{
+		QByteArray compressed;
+		QVERIFY(GZip::zip(makeLevelDat(10, 10), compressed));
+
+		// the compound and something inside it
+		QVariantMap values;
+		QVERIFY(NBTReader::read(compressed, {"Data", "Data/LevelName", "Data/Player"}, values));
+		QCOMPARE(values.size(), 3);
+		QCOMPARE(values["Data"].type(), QVariant::Map);
+		QCOMPARE(values["Data/Player"].type(), QVariant::Map);
+		QCOMPARE(values["Data/LevelName"].toString(), QString("Modded World"));
+
+		// a Data compound with nothing we know in it is still there
+		QByteArray empty;
+		putName(empty, 10, "");
+		putName(empty, 10, "Data");
+		empty.append(char(0));
+		empty.append(char(0));
+		QVERIFY(GZip::zip(empty, compressed));
+		QVERIFY(NBTReader::read(compressed, {"Data", "Data/LevelName"}, values));
+		QCOMPARE(values.size(), 1);
+		QCOMPARE(values["Data"].type(), QVariant::Map);
+	}
+
+	void test_Broken()
+	{
+		QByteArray compressed;
+		QVERIFY(GZip::zip(makeLevelDat(100, 1000), compressed));
+		QVariantMap values;
+		QVERIFY(!NBTReader::read(compressed.left(compressed.size() / 2), {"Data/LevelName"}, values));
+		QVERIFY(!NBTReader::read(QByteArray(1000, 'x'), {"Data/LevelName"}, values));
+		QVERIFY(!NBTReader::read(QByteArray(), {"Data/LevelName"}, values));
+	}
+};
+
+QTEST_GUILESS_MAIN(NBTReaderTest)
+
+#include "NBTReader_test.moc"
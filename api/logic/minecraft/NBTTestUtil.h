@@ -0,0 +1,87 @@
+#pragma once
+
+#include <QByteArray>
+#include <QtEndian>
+
+/// Writes uncompressed NBT for tests. Big endian: tag type, name length, name, payload.
+class NBTTestUtil
+{
+public:
+	static void putName(QByteArray &out, char type, const QByteArray &name)
+	{
+		out.append(type);
+		putShort(out, name.size());
+		out.append(name);
+	}
+	static void putShort(QByteArray &out, quint16 value)
+	{
+		uchar data[2];
+		qToBigEndian<quint16>(value, data);
+		out.append(reinterpret_cast<char *>(data), 2);
+	}
+	static void putInt(QByteArray &out, qint32 value)
+	{
+		uchar data[4];
+		qToBigEndian<qint32>(value, data);
+		out.append(reinterpret_cast<char *>(data), 4);
+	}
+	static void putLong(QByteArray &out, qint64 value)
+	{
+		uchar data[8];
+		qToBigEndian<qint64>(value, data);
+		out.append(reinterpret_cast<char *>(data), 8);
+	}
+	/// a whole string tag
+	static void putString(QByteArray &out, const QByteArray &name, const QByteArray &value)
+	{
+		putName(out, 8, name);
+		putShort(out, value.size());
+		out.append(value);
+	}
+
+	/// looks like the level.dat of a heavily modded world: lots of junk before the interesting parts
+	static QByteArray makeLevelDat(int items, int blobSize)
+	{
+		QByteArray nbt;
+		putName(nbt, 10, "");
+		putName(nbt, 10, "Data");
+
+		putName(nbt, 10, "Player");
+		putName(nbt, 9, "Inventory");
+		nbt.append(char(10));
+		putInt(nbt, items);
+		for (int i = 0; i < items; i++)
+		{
+			putString(nbt, "id", "modname:item_" + QByteArray::number(i));
+			putName(nbt, 1, "Count");
+			nbt.append(char(64));
+			putName(nbt, 10, "tag");
+			putName(nbt, 11, "Energy");
+			putInt(nbt, 3);
+			putInt(nbt, 1);
+			putInt(nbt, 2);
+			putInt(nbt, 3);
+			nbt.append(char(0));
+			nbt.append(char(0));
+		}
+		nbt.append(char(0));
+
+		putName(nbt, 7, "ModData");
+		putInt(nbt, blobSize);
+		for (int i = 0; i < blobSize; i++)
+		{
+			nbt.append(char(i * 7 % 251));
+		}
+
+		putString(nbt, "LevelName", "Modded World");
+		putName(nbt, 4, "LastPlayed");
+		putLong(nbt, 1450000000000);
+		putName(nbt, 4, "RandomSeed");
+		putLong(nbt, -1234567890123);
+		putName(nbt, 3, "version");
+		putInt(nbt, 19133);
+		nbt.append(char(0));
+		nbt.append(char(0));
+		return nbt;
+	}
+};
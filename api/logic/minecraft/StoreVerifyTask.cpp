@@ -0,0 +1,219 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "StoreVerifyTask.h"
+#include "AssetsUtils.h"
+#include "Env.h"
+#include "FileHashCache.h"
+#include "FileSystem.h"
+#include "net/CacheDownload.h"
+#include "net/MD5EtagDownload.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QtConcurrentRun>
+#include <QtConcurrentFilter>
+#include <QDebug>
+
+StoreVerifyTask::StoreVerifyTask(QList<LibraryPtr> libraries, QObject *parent)
+	: Task(parent), m_libraries(libraries)
+{
+	connect(&m_collectWatcher, SIGNAL(finished()), SLOT(collectFinished()));
+	connect(&m_verifyWatcher, SIGNAL(progressValueChanged(int)), SLOT(verifyProgress(int)));
+	connect(&m_verifyWatcher, SIGNAL(finished()), SLOT(verifyFinished()));
+}
+
+QList<StoreVerifyTask::Item> StoreVerifyTask::collect(QList<LibraryPtr> libraries)
+{
+	// the same file can be referenced many times, only check it once
+	QMap<QString, Item> items;
+
+	QDir indexDir("assets/indexes");
+	for (auto &entry : indexDir.entryInfoList(QStringList() << "*.json", QDir::Files))
+	{
+		AssetsIndex index;
+		if (!AssetsUtils::loadAssetsIndexJson(entry.completeBaseName(), entry.filePath(), &index))
+		{
+			continue;
+		}
+		for (auto &object : index.objects)
+		{
+			Item item;
+			item.path = object.getLocalPath();
+			item.sha1 = object.hash;
+			item.size = object.size;
+			item.url = object.getUrl();
+			items.insert(item.path, item);
+		}
+	}
+
+	for (auto &library : libraries)
+	{
+		for (auto &info : library->getMojangDownloads(currentSystem))
+		{
+			if (info->sha1.isEmpty())
+			{
+				continue;
+			}
+			Item item;
+			item.path = FS::PathCombine("libraries", info->path);
+			item.sha1 = info->sha1;
+			item.size = info->size;
+			item.url = QUrl(info->url);
+			item.libraryStorage = info->path;
+			items.insert(item.path, item);
+		}
+	}
+	return items.values();
+}
+
+bool StoreVerifyTask::isBroken(const Item &item)
+{
+	QFileInfo info(item.path);
+	if (!info.isFile())
+	{
+		return true;
+	}
+	// no need to read the file if the size is already wrong
+	if (item.size > 0 && info.size() != item.size)
+	{
+		return true;
+	}
+	// this has to look at the data, not at the cache
+	auto hashes = FileHashCache::hashFile(item.path);
+	if (!hashes.isValid())
+	{
+		return true;
+	}
+	return QString::fromLatin1(hashes.sha1.toHex()).compare(item.sha1, Qt::CaseInsensitive) != 0;
+}
+
+void StoreVerifyTask::executeTask()
+{
+	setStatus(tr("Looking for files to verify..."));
+	m_collectWatcher.setFuture(QtConcurrent::run(&StoreVerifyTask::collect, m_libraries));
+}
+
+void StoreVerifyTask::collectFinished()
+{
+	if (m_aborted)
+	{
+		emitFailed(tr("Aborted."));
+		return;
+	}
+	m_items = m_collectWatcher.result();
+	m_totalBytes = 0;
+	for (auto &item : m_items)
+	{
+		m_totalBytes += item.size;
+	}
+	qDebug() << "Verifying" << m_items.size() << "files," << m_totalBytes / (1024 * 1024) << "MiB";
+	setStatus(tr("Verifying %1 files...").arg(m_items.size()));
+	m_timer.start();
+	m_verifyWatcher.setFuture(QtConcurrent::filtered(m_items, &StoreVerifyTask::isBroken));
+}
+
+QString StoreVerifyTask::throughput() const
+{
+	double seconds = qMax<qint64>(1, m_verifyTime) / 1000.0;
+	return tr("%1 files/s, %2 MB/s")
+		.arg(m_items.size() / seconds, 0, 'f', 0)
+		.arg(m_totalBytes / (1024.0 * 1024.0) / seconds, 0, 'f', 1);
+}
+
+void StoreVerifyTask::verifyProgress(int value)
+{
+	setProgress(value, qMax(1, m_items.size()));
+}
+
+void StoreVerifyTask::verifyFinished()
+{
+	if (m_aborted)
+	{
+		emitFailed(tr("Aborted."));
+		return;
+	}
+	m_verifyTime = m_timer.elapsed();
+	auto broken = m_verifyWatcher.future().results();
+	m_brokenCount = broken.size();
+	qDebug() << "Verified" << m_items.size() << "files in" << m_verifyTime << "ms (" << throughput()
+			 << ")," << m_brokenCount << "broken";
+	if (broken.isEmpty())
+	{
+		setStatus(tr("All %1 files are fine (%2).").arg(m_items.size()).arg(throughput()));
+		emitSucceeded();
+		return;
+	}
+
+	setStatus(tr("Downloading %1 broken files...").arg(broken.size()));
+	m_repairJob.reset(new NetJob(tr("Repair of the asset and library store")));
+	auto metacache = ENV.metacache();
+	for (auto &item : broken)
+	{
+		qWarning() << "Broken file:" << item.path;
+		// don't let the downloads think the local file is good
+		QFile::remove(item.path);
+		if (item.libraryStorage.isEmpty())
+		{
+			auto download = MD5EtagDownload::make(item.url, item.path);
+			download->m_expected_sha1 = item.sha1;
+			download->setSizeHint(item.size);
+			m_repairJob->addNetAction(download);
+		}
+		else
+		{
+			auto entry = metacache->resolveEntry("libraries", item.libraryStorage);
+			entry->setStale(true);
+			auto download = CacheDownload::make(item.url, entry);
+			download->setExpectedSha1(item.sha1);
+			download->setSizeHint(item.size);
+			m_repairJob->addNetAction(download);
+		}
+	}
+	connect(m_repairJob.get(), SIGNAL(succeeded()), SLOT(repairSucceeded()));
+	connect(m_repairJob.get(), &NetJob::failed, this, &StoreVerifyTask::repairFailed);
+	connect(m_repairJob.get(), &NetJob::progress, this, &StoreVerifyTask::setProgress);
+	m_repairJob->start();
+}
+
+void StoreVerifyTask::repairSucceeded()
+{
+	m_repairJob.reset();
+	setStatus(tr("Repaired %1 of %2 files (%3).").arg(m_brokenCount).arg(m_items.size()).arg(throughput()));
+	emitSucceeded();
+}
+
+void StoreVerifyTask::repairFailed(QString reason)
+{
+	m_repairJob.reset();
+	if (m_aborted)
+	{
+		emitFailed(tr("Aborted."));
+		return;
+	}
+	emitFailed(tr("Failed to download broken files: %1").arg(reason));
+}
+
+bool StoreVerifyTask::abort()
+{
+	m_aborted = true;
+	if (m_repairJob)
+	{
+		return m_repairJob->abort();
+	}
+	m_collectWatcher.cancel();
+	m_verifyWatcher.cancel();
+	return true;
+}
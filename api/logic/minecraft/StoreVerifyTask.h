@@ -0,0 +1,92 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+#include <QUrl>
+
+#include "tasks/Task.h"
+#include "net/NetJob.h"
+#include "minecraft/Library.h"
+
+#include "multimc_logic_export.h"
+
+/*
+ * Checks the shared asset and library store against the known checksums and downloads the broken files again.
+ *
+ * All the asset indexes in assets/indexes are checked, plus the given libraries.
+ * Files are hashed on all available cores.
+ */
+class MULTIMC_LOGIC_EXPORT StoreVerifyTask : public Task
+{
+	Q_OBJECT
+public:
+	/// One file in the store
+	struct Item
+	{
+		/// where the file lives, relative to the MultiMC root
+		QString path;
+		/// hex encoded sha1
+		QString sha1;
+		qint64 size = 0;
+		QUrl url;
+		/// path inside the 'libraries' metacache base, empty for assets
+		QString libraryStorage;
+	};
+
+	explicit StoreVerifyTask(QList<LibraryPtr> libraries, QObject *parent = 0);
+	virtual ~StoreVerifyTask() {};
+
+	bool canAbort() const override
+	{
+		return true;
+	}
+
+	/// find everything that should be verified
+	static QList<Item> collect(QList<LibraryPtr> libraries);
+
+	/// true if the file is missing or doesn't match its checksum
+	static bool isBroken(const Item &item);
+
+public slots:
+	bool abort() override;
+
+protected:
+	void executeTask() override;
+
+private slots:
+	void collectFinished();
+	void verifyProgress(int value);
+	void verifyFinished();
+	void repairSucceeded();
+	void repairFailed(QString reason);
+
+private:
+	QString throughput() const;
+
+private:
+	QList<LibraryPtr> m_libraries;
+	QList<Item> m_items;
+	qint64 m_totalBytes = 0;
+	int m_brokenCount = 0;
+	QElapsedTimer m_timer;
+	qint64 m_verifyTime = 0;
+	bool m_aborted = false;
+	QFutureWatcher<QList<Item>> m_collectWatcher;
+	QFutureWatcher<Item> m_verifyWatcher;
+	NetJobPtr m_repairJob;
+};
@@ -0,0 +1,151 @@
+#include <QTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QCryptographicHash>
+#include <QDir>
+#include "TestUtil.h"
+
+#include "minecraft/StoreVerifyTask.h"
+#include "FileSystem.h"
+
+class StoreVerifyTaskTest : public QObject
+{
+	Q_OBJECT
+
+	static QString sha1(const QByteArray &data)
+	{
+		return QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex());
+	}
+
+	static QByteArray indexJson(const QList<QByteArray> &contents)
+	{
+		QByteArray out = "{\"objects\": {";
+		for (int i = 0; i < contents.size(); i++)
+		{
+			if (i)
+				out += ",";
+			out += QString("\"thing%1.ogg\": {\"hash\": \"%2\", \"size\": %3}")
+					   .arg(i)
+					   .arg(sha1(contents[i]))
+					   .arg(contents[i].size())
+					   .toUtf8();
+		}
+		out += "}}";
+		return out;
+	}
+
+	static void putObject(const QByteArray &content)
+	{
+		auto hash = sha1(content);
+		auto path = FS::PathCombine("assets/objects", hash.left(2), hash);
+		FS::write(path, content);
+	}
+
+	QTemporaryDir *m_dir = nullptr;
+	QString m_oldCurrent;
+
+private
+slots:
+	// the store lives in the working directory
+	void init()
+	{
+		m_dir = new QTemporaryDir();
+		m_oldCurrent = QDir::currentPath();
+		QVERIFY(QDir::setCurrent(m_dir->path()));
+		QVERIFY(QDir().mkpath("assets/indexes"));
+	}
+
+	void cleanup()
+	{
+		QDir::setCurrent(m_oldCurrent);
+		delete m_dir;
+		m_dir = nullptr;
+	}
+
+	void test_isBroken()
+	{
+		QByteArray content = "some asset";
+		putObject(content);
+		StoreVerifyTask::Item item;
+		item.sha1 = sha1(content);
+		item.path = FS::PathCombine("assets/objects", item.sha1.left(2), item.sha1);
+		item.size = content.size();
+		QVERIFY(!StoreVerifyTask::isBroken(item));
+
+		auto wrongSize = item;
+		wrongSize.size++;
+		QVERIFY(StoreVerifyTask::isBroken(wrongSize));
+
+		auto wrongHash = item;
+		wrongHash.sha1 = sha1("something else");
+		QVERIFY(StoreVerifyTask::isBroken(wrongHash));
+
+		auto missing = item;
+		missing.path += ".missing";
+		QVERIFY(StoreVerifyTask::isBroken(missing));
+	}
+
+	void test_collect()
+	{
+		// the same object in two indexes is only checked once
+		FS::write("assets/indexes/a.json", indexJson({"one", "two"}));
+		FS::write("assets/indexes/b.json", indexJson({"two", "three"}));
+		auto items = StoreVerifyTask::collect({});
+		QCOMPARE(items.size(), 3);
+	}
+
+	void test_allFine()
+	{
+		QList<QByteArray> contents = {"one", "two", "three"};
+		for (auto &content : contents)
+		{
+			putObject(content);
+		}
+		FS::write("assets/indexes/a.json", indexJson(contents));
+
+		StoreVerifyTask task(QList<LibraryPtr>{});
+		QSignalSpy succeeded(&task, SIGNAL(succeeded()));
+		task.start();
+		QVERIFY(succeeded.wait(5000));
+	}
+
+	void test_abortVerify()
+	{
+		FS::write("assets/indexes/a.json", indexJson({"one", "two"}));
+		StoreVerifyTask task(QList<LibraryPtr>{});
+		QSignalSpy failed(&task, SIGNAL(failed(QString)));
+		task.start();
+		QVERIFY(task.abort());
+		QVERIFY(failed.wait(5000));
+		QCOMPARE(task.failReason(), QString("Aborted."));
+	}
+
+	void test_abortRepair()
+	{
+		// nothing is there, so everything has to be downloaded
+		FS::write("assets/indexes/a.json", indexJson({"one", "two"}));
+		StoreVerifyTask task(QList<LibraryPtr>{});
+		QSignalSpy failed(&task, SIGNAL(failed(QString)));
+		connect(&task, &Task::status, [&](QString status)
+		{
+			// right after the repair download was started
+			if (status.startsWith("Downloading"))
+			{
+				QMetaObject::invokeMethod(&task, "abort", Qt::QueuedConnection);
+			}
+		});
+		task.start();
+		QVERIFY(failed.wait(5000));
+		QCOMPARE(failed.size(), 1);
+		QCOMPARE(task.failReason(), QString("Aborted."));
+
+		// and the downloads don't come back to life
+		QTest::qWait(50);
+		QCOMPARE(failed.size(), 1);
+		QVERIFY(!task.isRunning());
+	}
+};
+
+QTEST_GUILESS_MAIN(StoreVerifyTaskTest)
+
+#include "StoreVerifyTask_test.moc"
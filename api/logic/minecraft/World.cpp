@@ -17,10 +17,13 @@
 #include <QString>
 #include <QDebug>
 #include <QSaveFile>
+#include <QBuffer>
 #include "World.h"
 
 #include "GZip.h"
 #include <MMCZip.h>
+#include "ZipIndex.h"
+#include "NBTReader.h"
 #include <FileSystem.h>
 #include <sstream>
 #include <io/stream_reader.h>
@@ -28,7 +31,6 @@
 #include <tag_primitive.h>
 #include <quazip.h>
 #include <quazipfile.h>
-#include <quazipdir.h>
 
 std::unique_ptr <nbt::tag_compound> parseLevelDat(QByteArray data)
 {
@@ -94,12 +96,13 @@ bool putLevelDatDataToFS(const QFileInfo &file, QByteArray & data)
 	{
 		return false;
 	}
-	QByteArray compressed;
-	if(!GZip::zip(data, compressed))
+	GZipWriter writer(&f);
+	if(!writer.open(QIODevice::WriteOnly))
 	{
+		f.cancelWriting();
 		return false;
 	}
-	if(f.write(compressed) != compressed.size())
+	if(writer.write(data) != data.size() || !writer.finish())
 	{
 		f.cancelWriting();
 		return false;
@@ -107,15 +110,19 @@ bool putLevelDatDataToFS(const QFileInfo &file, QByteArray & data)
 	return f.commit();
 }
 
-World::World(const QFileInfo &file)
+World::World(const QFileInfo &file, bool readContents)
 {
-	repath(file);
+	repath(file, readContents);
 }
 
-void World::repath(const QFileInfo &file)
+void World::repath(const QFileInfo &file, bool readContents)
 {
 	m_containerFile = file;
 	m_folderName = file.fileName();
+	if(!readContents)
+	{
+		return;
+	}
 	if(file.isFile() && file.suffix() == "zip")
 	{
 		readFromZip(file);
@@ -128,53 +135,55 @@ void World::repath(const QFileInfo &file)
 
 void World::readFromFS(const QFileInfo &file)
 {
-	auto bytes = getLevelDatDataFromFS(file);
-	if(bytes.isEmpty())
+	auto fullFilePath = getLevelDatFromFS(file);
+	QFile levelDat(fullFilePath);
+	if(fullFilePath.isNull() || !levelDat.open(QIODevice::ReadOnly))
 	{
 		is_valid = false;
 		return;
 	}
-	loadFromLevelDat(bytes);
 	levelDatTime = file.lastModified();
+	loadFromLevelDat(&levelDat);
 }
 
 void World::readFromZip(const QFileInfo &file)
 {
-	QuaZip zip(file.absoluteFilePath());
-	is_valid = zip.open(QuaZip::mdUnzip);
+	ZipIndex zip(file.absoluteFilePath());
+	is_valid = zip.isValid();
 	if (!is_valid)
 	{
 		return;
 	}
-	auto location = MMCZip::findFileInZip(&zip, "level.dat");
-	is_valid = !location.isEmpty();
+	auto location = zip.findFile("level.dat");
+	is_valid = !location.isNull();
 	if (!is_valid)
 	{
 		return;
 	}
 	m_containerOffsetPath = location;
-	QuaZipFile zippedFile(&zip);
-	// read the install profile
-	is_valid = zip.setCurrentFile(location + "level.dat");
+	auto levelDat = zip.find(location + "level.dat");
+	QByteArray data;
+	is_valid = levelDat && zip.read(*levelDat, data);
 	if (!is_valid)
 	{
 		return;
 	}
-	is_valid = zippedFile.open(QIODevice::ReadOnly);
-	QuaZipFileInfo64 levelDatInfo;
-	zippedFile.getFileInfo(&levelDatInfo);
-	auto modTime = levelDatInfo.getNTFSmTime();
-	if(!modTime.isValid())
-	{
-		modTime = levelDatInfo.dateTime;
-	}
-	levelDatTime = modTime;
-	if (!is_valid)
-	{
-		return;
-	}
-	loadFromLevelDat(zippedFile.readAll());
-	zippedFile.close();
+	levelDatTime = levelDat->modified;
+	QBuffer buffer(&data);
+	buffer.open(QIODevice::ReadOnly);
+	loadFromLevelDat(&buffer);
+}
+
+void World::writeSummary(QDataStream &out) const
+{
+	out << is_valid << m_actualName << levelDatTime << m_lastPlayed << qint64(m_randomSeed);
+}
+
+void World::readSummary(QDataStream &in)
+{
+	qint64 seed = 0;
+	in >> is_valid >> m_actualName >> levelDatTime >> m_lastPlayed >> seed;
+	m_randomSeed = seed;
 }
 
 bool World::install(const QString &to, const QString &name)
@@ -251,99 +260,44 @@ bool World::rename(const QString &newName)
 	return true;
 }
 
-static QString read_string (nbt::value& parent, const char * name, const QString & fallback = QString())
+void World::loadFromLevelDat(QIODevice *levelDat)
 {
-	try
-	{
-		auto &namedValue = parent.at(name);
-		if(namedValue.get_type() != nbt::tag_type::String)
-		{
-			return fallback;
-		}
-		auto & tag_str = namedValue.as<nbt::tag_string>();
-		return QString::fromStdString(tag_str.get());
-	}
-	catch(std::out_of_range e)
-	{
-		// fallback for old world formats
-		qWarning() << "String NBT tag" << name << "could not be found. Defaulting to" << fallback;
-		return fallback;
-	}
-	catch(std::bad_cast e)
-	{
-		// type mismatch
-		qWarning() << "NBT tag" << name << "could not be converted to string. Defaulting to" << fallback;
-		return fallback;
+	// only these are needed, the rest of the file (player inventories, mod data, ...) is skipped
+	const QString data = "Data";
+	const QString levelName = "Data/LevelName";
+	const QString lastPlayed = "Data/LastPlayed";
+	const QString randomSeed = "Data/RandomSeed";
+
+	QVariantMap values;
+	NBTReader reader(levelDat);
+	// a world needs the Data compound, everything in it is optional
+	is_valid = reader.read({data, levelName, lastPlayed, randomSeed}, values) &&
+			   values.value(data).type() == QVariant::Map;
+	if(!is_valid)
+	{
+		qWarning() << "Unable to load" << m_folderName << ": level.dat is broken or has no Data";
+		return;
 	}
-};
 
-static int64_t read_long (nbt::value& parent, const char * name, const int64_t & fallback = 0)
-{
-	try
-	{
-		auto &namedValue = parent.at(name);
-		if(namedValue.get_type() != nbt::tag_type::Long)
-		{
-			return fallback;
-		}
-		auto & tag_str = namedValue.as<nbt::tag_long>();
-		return tag_str.get();
-	}
-	catch(std::out_of_range e)
+	// fallback for old world formats
+	auto name = values.value(levelName);
+	m_actualName = name.type() == QVariant::String ? name.toString() : m_folderName;
+
+	qint64 temp = values.value(lastPlayed, 0).toLongLong();
+	if(temp == 0)
 	{
-		// fallback for old world formats
-		qWarning() << "Long NBT tag" << name << "could not be found. Defaulting to" << fallback;
-		return fallback;
+		m_lastPlayed = levelDatTime;
 	}
-	catch(std::bad_cast e)
+	else
 	{
-		// type mismatch
-		qWarning() << "NBT tag" << name << "could not be converted to long. Defaulting to" << fallback;
-		return fallback;
+		m_lastPlayed = QDateTime::fromMSecsSinceEpoch(temp);
 	}
-};
-
-void World::loadFromLevelDat(QByteArray data)
-{
-	try
-	{
-		auto levelData = parseLevelDat(data);
-		if(!levelData)
-		{
-			is_valid = false;
-			return;
-		}
-
-		auto &val = levelData->at("Data");
-		is_valid = val.get_type() == nbt::tag_type::Compound;
-		if(!is_valid)
-			return;
 
-		m_actualName = read_string(val, "LevelName", m_folderName);
+	m_randomSeed = values.value(randomSeed, 0).toLongLong();
 
-
-		int64_t temp = read_long(val, "LastPlayed", 0);
-		if(temp == 0)
-		{
-			m_lastPlayed = levelDatTime;
-		}
-		else
-		{
-			m_lastPlayed = QDateTime::fromMSecsSinceEpoch(temp);
-		}
-
-		m_randomSeed = read_long(val, "RandomSeed", 0);
-
-		qDebug() << "World Name:" << m_actualName;
-		qDebug() << "Last Played:" << m_lastPlayed.toString();
-		qDebug() << "Seed:" << m_randomSeed;
-	}
-	catch (nbt::io::input_error e)
-	{
-		qWarning() << "Unable to load" << m_folderName << ":" << e.what();
-		is_valid = false;
-		return;
-	}
+	qDebug() << "World Name:" << m_actualName;
+	qDebug() << "Last Played:" << m_lastPlayed.toString();
+	qDebug() << "Seed:" << m_randomSeed;
 }
 
 bool World::replace(World &with)
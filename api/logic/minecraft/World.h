@@ -16,13 +16,17 @@
 #pragma once
 #include <QFileInfo>
 #include <QDateTime>
+#include <QDataStream>
+#include <QIODevice>
 
 #include "multimc_logic_export.h"
 
 class MULTIMC_LOGIC_EXPORT World
 {
 public:
-	World(const QFileInfo &file);
+	World() = default;
+	/// readContents = false skips reading the level.dat, for when the summary comes from elsewhere
+	World(const QFileInfo &file, bool readContents = true);
 	QString folderName() const
 	{
 		return m_folderName;
@@ -56,7 +60,11 @@ public:
 	// replace this world with a copy of the other
 	bool replace(World &with);
 	// change the world's filesystem path (used by world lists for *MAGIC* purposes)
-	void repath(const QFileInfo &file);
+	void repath(const QFileInfo &file, bool readContents = true);
+
+	// save and restore what was read from the level.dat (used by WorldSummaryCache)
+	void writeSummary(QDataStream &out) const;
+	void readSummary(QDataStream &in);
 
 	bool rename(const QString &to);
 	bool install(const QString &to, const QString &name= QString());
@@ -68,7 +76,7 @@ public:
 private:
 	void readFromZip(const QFileInfo &file);
 	void readFromFS(const QFileInfo &file);
-	void loadFromLevelDat(QByteArray data);
+	void loadFromLevelDat(QIODevice *levelDat);
 
 protected:
 
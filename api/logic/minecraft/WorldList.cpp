@@ -14,6 +14,8 @@
  */
 
 #include "WorldList.h"
+#include "WorldSummaryCache.h"
+#include <Env.h>
 #include <FileSystem.h>
 #include <QMimeData>
 #include <QUrl>
@@ -23,7 +25,10 @@
 #include <QDebug>
 
 WorldList::WorldList(const QString &dir)
-	: QAbstractListModel(), m_dir(dir)
+	: QAbstractListModel(), m_dir(dir),
+	  m_scan(this, m_dir, worlds, {&WorldList::worldKey, &WorldList::sameWorld, &WorldList::worldLessThan,
+								   &WorldList::isFolder, &WorldList::needsScan, &WorldList::scanWorld,
+								   &WorldList::isWorld})
 {
 	FS::ensureFolderPathExists(m_dir.absolutePath());
 	m_dir.setFilter(QDir::Readable | QDir::NoDotAndDotDot | QDir::Files | QDir::Dirs |
@@ -33,11 +38,16 @@ WorldList::WorldList(const QString &dir)
 	is_watching = false;
 	connect(m_watcher, SIGNAL(directoryChanged(QString)), this,
 			SLOT(directoryChanged(QString)));
+	setupFolderSettleTimer(m_updateTimer, this, SLOT(directorySettled()));
+	m_scan.onChanged([this]()
+	{
+		emit changed();
+	});
 }
 
 void WorldList::startWatching()
 {
-	update();
+	updateAsync();
 	is_watching = m_watcher->addPath(m_dir.absolutePath());
 	if (is_watching)
 	{
@@ -62,35 +72,69 @@ void WorldList::stopWatching()
 	}
 }
 
+bool WorldList::worldLessThan(const World &left, const World &right)
+{
+	// same order as the folder listing
+	return left.folderName().toLower().localeAwareCompare(right.folderName().toLower()) < 0;
+}
+
+QString WorldList::worldKey(const World &world)
+{
+	return world.container().filePath();
+}
+
+bool WorldList::sameWorld(const World &left, const World &right)
+{
+	return left.strongCompare(right) && left.name() == right.name() && left.lastPlayed() == right.lastPlayed();
+}
+
+World WorldList::scanWorld(const QFileInfo &folder)
+{
+	return ENV.worldSummaries()->get(folder);
+}
+
+bool WorldList::needsScan(const QFileInfo &folder)
+{
+	return ENV.worldSummaries()->needsScan(folder);
+}
+
+bool WorldList::isFolder(const QFileInfo &entry)
+{
+	return entry.isDir();
+}
+
+bool WorldList::isWorld(const World &world)
+{
+	return world.isValid();
+}
+
 bool WorldList::update()
 {
 	if (!isValid())
 		return false;
 
-	QList<World> newWorlds;
-	m_dir.refresh();
-	auto folderContents = m_dir.entryInfoList();
-	// if there are any untracked files...
-	for (QFileInfo entry : folderContents)
-	{
-		if(!entry.isDir())
-			continue;
-
-		World w(entry);
-		if(w.isValid())
-		{
-			newWorlds.append(w);
-		}
-	}
-	beginResetModel();
-	worlds.swap(newWorlds);
-	endResetModel();
+	m_updateTimer.stop();
+	m_scan.update();
 	return true;
 }
 
+void WorldList::updateAsync()
+{
+	if (!isValid())
+		return;
+
+	m_updateTimer.stop();
+	m_scan.updateAsync();
+}
+
 void WorldList::directoryChanged(QString path)
 {
-	update();
+	m_updateTimer.start();
+}
+
+void WorldList::directorySettled()
+{
+	updateAsync();
 }
 
 bool WorldList::isValid()
@@ -20,7 +20,9 @@
 #include <QDir>
 #include <QAbstractListModel>
 #include <QMimeData>
+#include <QTimer>
 #include "minecraft/World.h"
+#include "FolderModelScan.h"
 
 #include "multimc_logic_export.h"
 
@@ -29,6 +31,7 @@ class QFileSystemWatcher;
 class MULTIMC_LOGIC_EXPORT WorldList : public QAbstractListModel
 {
 	Q_OBJECT
+	friend class ListModelDiff;
 public:
 	enum Columns
 	{
@@ -73,6 +76,12 @@ public:
 	/// Reloads the mod list and returns true if the list changed.
 	virtual bool update();
 
+	/**
+	 * Reloads the world list in the background.
+	 * Worlds that didn't change since they were last seen show up right away, the rest as they are read.
+	 */
+	void updateAsync();
+
 	/// Install a world from location
 	void installWorld(QFileInfo filename);
 
@@ -111,15 +120,27 @@ public:
 		return worlds;
 	}
 
+private:
+	static bool worldLessThan(const World &left, const World &right);
+	static QString worldKey(const World &world);
+	static bool sameWorld(const World &left, const World &right);
+	static World scanWorld(const QFileInfo &folder);
+	static bool needsScan(const QFileInfo &folder);
+	static bool isFolder(const QFileInfo &entry);
+	static bool isWorld(const World &world);
+
 private slots:
 	void directoryChanged(QString path);
+	void directorySettled();
 
 signals:
 	void changed();
 
 protected:
 	QFileSystemWatcher *m_watcher;
+	QTimer m_updateTimer;
 	bool is_watching;
 	QDir m_dir;
 	QList<World> worlds;
+	FolderModelScan<WorldList, World> m_scan;
 };
@@ -0,0 +1,85 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "WorldSummaryCache.h"
+
+#include <QDir>
+#include <QDataStream>
+
+namespace
+{
+// "MMCW"
+const quint32 indexMagic = 0x4d4d4357;
+// 2: records have an inode
+const quint32 indexVersion = 2;
+}
+
+WorldSummaryCache::WorldSummaryCache(const QString &indexPath) : m_cache(indexMagic, indexVersion, indexPath)
+{
+}
+
+QFileInfo WorldSummaryCache::levelDat(const QFileInfo &folder)
+{
+	if (!folder.isDir())
+	{
+		return QFileInfo();
+	}
+	QFileInfo file(QDir(folder.absoluteFilePath()).absoluteFilePath("level.dat"));
+	if (!file.isFile())
+	{
+		return QFileInfo();
+	}
+	return file;
+}
+
+bool WorldSummaryCache::needsScan(const QFileInfo &folder)
+{
+	auto file = levelDat(folder);
+	QByteArray summary;
+	return file.exists() && !m_cache.find(file.absoluteFilePath(), summary);
+}
+
+World WorldSummaryCache::get(const QFileInfo &folder)
+{
+	auto file = levelDat(folder);
+	if (!file.exists())
+	{
+		// not a world, nothing to read
+		return World(folder);
+	}
+
+	World world(folder, false);
+	bool read = false;
+	QByteArray summary;
+	bool found = m_cache.get(file.absoluteFilePath(), summary, [&](QByteArray &out)
+	{
+		world = World(folder);
+		read = true;
+		QDataStream stream(&out, QIODevice::WriteOnly);
+		world.writeSummary(stream);
+		return true;
+	});
+	if (!found)
+	{
+		// gone in the meantime
+		return World(folder);
+	}
+	if (!read)
+	{
+		QDataStream in(summary);
+		world.readSummary(in);
+	}
+	return world;
+}
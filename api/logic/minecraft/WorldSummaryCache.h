@@ -0,0 +1,59 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+
+#include "PersistentFileCache.h"
+#include "minecraft/World.h"
+
+#include "multimc_logic_export.h"
+
+/*
+ * Remembers what was found in the level.dat of world folders (name, last played time, seed).
+ *
+ * Results are kept in a PersistentFileCache keyed by the level.dat, so it is only read again
+ * when it changes.
+ *
+ * All the methods are thread safe.
+ */
+class MULTIMC_LOGIC_EXPORT WorldSummaryCache
+{
+public:
+	/// supply path to the index file, or nothing for a cache that only lives in memory
+	explicit WorldSummaryCache(const QString &indexPath = QString());
+
+	/// get the world in a folder, reading its level.dat only if it's not known or changed
+	World get(const QFileInfo &folder);
+
+	/// true if get() would have to read the level.dat
+	bool needsScan(const QFileInfo &folder);
+
+	void load()
+	{
+		m_cache.load();
+	}
+	void save()
+	{
+		m_cache.save();
+	}
+
+private:
+	static QFileInfo levelDat(const QFileInfo &folder);
+
+	PersistentFileCache<QByteArray> m_cache;
+};
@@ -0,0 +1,99 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include "TestUtil.h"
+
+#include "minecraft/WorldSummaryCache.h"
+#include "minecraft/NBTTestUtil.h"
+#include "GZip.h"
+#include <FileSystem.h>
+
+class WorldSummaryCacheTest : public QObject, private NBTTestUtil
+{
+	Q_OBJECT
+
+	QString makeWorld(const QString &root, const QString &folder, const QByteArray &name)
+	{
+		QByteArray nbt;
+		putName(nbt, 10, "");
+		putName(nbt, 10, "Data");
+		putString(nbt, "LevelName", name);
+		putName(nbt, 4, "LastPlayed");
+		putLong(nbt, 1450000000000);
+		putName(nbt, 4, "RandomSeed");
+		putLong(nbt, -42);
+		nbt.append(char(0));
+		nbt.append(char(0));
+		QByteArray compressed;
+		GZip::zip(nbt, compressed);
+		QString path = FS::PathCombine(root, folder);
+		FS::write(FS::PathCombine(path, "level.dat"), compressed);
+		return path;
+	}
+
+private
+slots:
+	void test_Cache()
+	{
+		QTemporaryDir dir;
+		auto path = makeWorld(dir.path(), "world", "Test World");
+		QString index = FS::PathCombine(dir.path(), "worldcache");
+		{
+			WorldSummaryCache cache(index);
+			QVERIFY(cache.needsScan(QFileInfo(path)));
+			auto world = cache.get(QFileInfo(path));
+			QVERIFY(world.isValid());
+			QCOMPARE(world.name(), QString("Test World"));
+			QCOMPARE(world.seed(), int64_t(-42));
+			QVERIFY(!cache.needsScan(QFileInfo(path)));
+		}
+		QVERIFY(QFile::exists(index));
+
+		WorldSummaryCache cache(index);
+		cache.load();
+		QVERIFY(!cache.needsScan(QFileInfo(path)));
+		auto world = cache.get(QFileInfo(path));
+		QVERIFY(world.isValid());
+		QCOMPARE(world.name(), QString("Test World"));
+		QCOMPARE(world.folderName(), QString("world"));
+		QCOMPARE(world.lastPlayed(), QDateTime::fromMSecsSinceEpoch(1450000000000));
+		QCOMPARE(world.seed(), int64_t(-42));
+
+		// a changed level.dat gets read again
+		QTest::qWait(1100);
+		makeWorld(dir.path(), "world", "Renamed World!");
+		QVERIFY(cache.needsScan(QFileInfo(path)));
+		QCOMPARE(cache.get(QFileInfo(path)).name(), QString("Renamed World!"));
+	}
+
+	void test_EmptyData()
+	{
+		// old worlds can have a Data compound without a name, they use the folder name
+		QTemporaryDir dir;
+		QByteArray nbt;
+		putName(nbt, 10, "");
+		putName(nbt, 10, "Data");
+		nbt.append(char(0));
+		nbt.append(char(0));
+		QByteArray compressed;
+		GZip::zip(nbt, compressed);
+		QString path = FS::PathCombine(dir.path(), "old world");
+		FS::write(FS::PathCombine(path, "level.dat"), compressed);
+
+		WorldSummaryCache cache;
+		auto world = cache.get(QFileInfo(path));
+		QVERIFY(world.isValid());
+		QCOMPARE(world.name(), QString("old world"));
+	}
+
+	void test_NotAWorld()
+	{
+		QTemporaryDir dir;
+		WorldSummaryCache cache;
+		QVERIFY(!cache.needsScan(QFileInfo(dir.path())));
+		QVERIFY(!cache.get(QFileInfo(dir.path())).isValid());
+	}
+};
+
+QTEST_GUILESS_MAIN(WorldSummaryCacheTest)
+
+#include "WorldSummaryCache_test.moc"
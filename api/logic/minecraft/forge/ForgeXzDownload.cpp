@@ -16,8 +16,8 @@
 #include "Env.h"
 #include "ForgeXzDownload.h"
 #include <FileSystem.h>
+#include "FileHashCache.h"
 
-#include <QCryptographicHash>
 #include <QFileInfo>
 #include <QDateTime>
 #include <QDir>
@@ -27,15 +27,20 @@ ForgeXzDownload::ForgeXzDownload(QString relative_path, MetaEntryPtr entry) : Ne
 {
 	m_entry = entry;
 	m_target_path = entry->getFullPath();
-	m_pack200_xz_file.setFileTemplate("./dl_temp.XXXXXX");
 	m_status = Job_NotStarted;
 	m_url_path = relative_path;
 	m_url = "http://files.minecraftforge.net/maven/" + m_url_path + ".pack.xz";
 }
 
+ForgeXzDownload::~ForgeXzDownload()
+{
+	resetDecoder();
+}
+
 void ForgeXzDownload::start()
 {
 	m_status = Job_InProgress;
+	resetDecoder();
 	if (!m_entry->isStale())
 	{
 		m_status = Job_Finished;
@@ -94,17 +99,18 @@ void ForgeXzDownload::downloadFinished()
 	{
 		// nothing went wrong...
 		m_status = Job_Finished;
-		if (m_pack200_xz_file.isOpen())
+		if (m_xz_finished)
 		{
-			// we actually downloaded something! process and isntall it
-			decompressAndInstall();
+			// we actually downloaded something! process and install it
+			unpackAndInstall();
 			return;
 		}
 		else
 		{
-			// something bad happened -- on the local machine!
+			// nothing or not enough arrived
+			qCritical() << "Incomplete xz stream from" << m_url.toString();
 			m_status = Job_Failed;
-			m_pack200_xz_file.remove();
+			resetDecoder();
 			m_reply.reset();
 			emit failed(m_index_within_job);
 			return;
@@ -114,8 +120,7 @@ void ForgeXzDownload::downloadFinished()
 	else
 	{
 		m_status = Job_Failed;
-		m_pack200_xz_file.close();
-		m_pack200_xz_file.remove();
+		resetDecoder();
 		m_reply.reset();
 		failAndTryNextMirror();
 		return;
@@ -124,228 +129,160 @@ void ForgeXzDownload::downloadFinished()
 
 void ForgeXzDownload::downloadReadyRead()
 {
-
-	if (!m_pack200_xz_file.isOpen())
+	if (m_status == Job_Failed)
 	{
-		if (!m_pack200_xz_file.open())
-		{
-			/*
-			* Can't open the file... the job failed
-			*/
-			m_reply->abort();
-			emit failed(m_index_within_job);
-			return;
-		}
+		return;
+	}
+	if (!decompressChunk(m_reply->readAll()))
+	{
+		// the failure is reported when the reply finishes
+		m_status = Job_Failed;
+		m_reply->abort();
 	}
-	m_pack200_xz_file.write(m_reply->readAll());
 }
 
 #include "xz.h"
 #include "unpack200.h"
 #include <stdexcept>
-#include <unistd.h>
 
 const size_t buffer_size = 8196;
 
-void ForgeXzDownload::decompressAndInstall()
+void ForgeXzDownload::resetDecoder()
 {
-	// rewind the downloaded temp file
-	m_pack200_xz_file.seek(0);
-	// de-xz'd file
-	QTemporaryFile pack200_file("./dl_temp.XXXXXX");
-	pack200_file.open();
+	if (m_xz_decoder)
+	{
+		xz_dec_end(m_xz_decoder);
+		m_xz_decoder = nullptr;
+	}
+	m_xz_finished = false;
+	m_pack200_data.clear();
+}
 
-	bool xz_success = false;
-	// first, de-xz
+bool ForgeXzDownload::decompressChunk(const QByteArray &data)
+{
+	if (m_xz_finished)
+	{
+		// anything after the end of the stream is ignored
+		return true;
+	}
+	if (!m_xz_decoder)
 	{
-		uint8_t in[buffer_size];
-		uint8_t out[buffer_size];
-		struct xz_buf b;
-		struct xz_dec *s;
-		enum xz_ret ret;
 		xz_crc32_init();
 		xz_crc64_init();
-		s = xz_dec_init(XZ_DYNALLOC, 1 << 26);
-		if (s == nullptr)
+		m_xz_decoder = xz_dec_init(XZ_DYNALLOC, 1 << 26);
+		if (m_xz_decoder == nullptr)
 		{
-			xz_dec_end(s);
-			failAndTryNextMirror();
-			return;
+			qCritical() << "Memory allocation failed\n";
+			return false;
 		}
-		b.in = in;
-		b.in_pos = 0;
-		b.in_size = 0;
-		b.out = out;
-		b.out_pos = 0;
-		b.out_size = buffer_size;
-		while (!xz_success)
-		{
-			if (b.in_pos == b.in_size)
-			{
-				b.in_size = m_pack200_xz_file.read((char *)in, sizeof(in));
-				b.in_pos = 0;
-			}
-
-			ret = xz_dec_run(s, &b);
-
-			if (b.out_pos == sizeof(out))
-			{
-				if (pack200_file.write((char *)out, b.out_pos) != b.out_pos)
-				{
-					// msg = "Write error\n";
-					xz_dec_end(s);
-					failAndTryNextMirror();
-					return;
-				}
-
-				b.out_pos = 0;
-			}
-
-			if (ret == XZ_OK)
-				continue;
-
-			if (ret == XZ_UNSUPPORTED_CHECK)
-			{
-				// unsupported check. this is OK, but we should log this
-				continue;
-			}
+	}
 
-			if (pack200_file.write((char *)out, b.out_pos) != b.out_pos)
-			{
-				// write error
-				pack200_file.close();
-				xz_dec_end(s);
-				return;
-			}
+	uint8_t out[buffer_size];
+	struct xz_buf b;
+	b.in = (const uint8_t *)data.constData();
+	b.in_pos = 0;
+	b.in_size = data.size();
+	b.out = out;
+	b.out_pos = 0;
+	b.out_size = buffer_size;
+	while (true)
+	{
+		enum xz_ret ret = xz_dec_run(m_xz_decoder, &b);
+		bool outputFull = b.out_pos == b.out_size;
+		m_pack200_data.append((char *)out, (int)b.out_pos);
+		b.out_pos = 0;
 
-			switch (ret)
+		switch (ret)
+		{
+		case XZ_OK:
+		case XZ_UNSUPPORTED_CHECK:
+			// unsupported check is OK, but we should log this
+			// wait for more data if this chunk is used up
+			if (b.in_pos == b.in_size && !outputFull)
 			{
-			case XZ_STREAM_END:
-				xz_dec_end(s);
-				xz_success = true;
-				break;
-
-			case XZ_MEM_ERROR:
-				qCritical() << "Memory allocation failed\n";
-				xz_dec_end(s);
-				failAndTryNextMirror();
-				return;
-
-			case XZ_MEMLIMIT_ERROR:
-				qCritical() << "Memory usage limit reached\n";
-				xz_dec_end(s);
-				failAndTryNextMirror();
-				return;
-
-			case XZ_FORMAT_ERROR:
-				qCritical() << "Not a .xz file\n";
-				xz_dec_end(s);
-				failAndTryNextMirror();
-				return;
-
-			case XZ_OPTIONS_ERROR:
-				qCritical() << "Unsupported options in the .xz headers\n";
-				xz_dec_end(s);
-				failAndTryNextMirror();
-				return;
-
-			case XZ_DATA_ERROR:
-			case XZ_BUF_ERROR:
-				qCritical() << "File is corrupt\n";
-				xz_dec_end(s);
-				failAndTryNextMirror();
-				return;
-
-			default:
-				qCritical() << "Bug!\n";
-				xz_dec_end(s);
-				failAndTryNextMirror();
-				return;
+				return true;
 			}
+			continue;
+
+		case XZ_STREAM_END:
+			xz_dec_end(m_xz_decoder);
+			m_xz_decoder = nullptr;
+			m_xz_finished = true;
+			return true;
+
+		case XZ_MEM_ERROR:
+			qCritical() << "Memory allocation failed\n";
+			return false;
+
+		case XZ_MEMLIMIT_ERROR:
+			qCritical() << "Memory usage limit reached\n";
+			return false;
+
+		case XZ_FORMAT_ERROR:
+			qCritical() << "Not a .xz file\n";
+			return false;
+
+		case XZ_OPTIONS_ERROR:
+			qCritical() << "Unsupported options in the .xz headers\n";
+			return false;
+
+		case XZ_DATA_ERROR:
+		case XZ_BUF_ERROR:
+			qCritical() << "File is corrupt\n";
+			return false;
+
+		default:
+			qCritical() << "Bug!\n";
+			return false;
 		}
 	}
-	m_pack200_xz_file.remove();
+}
 
-	// revert pack200
-	pack200_file.seek(0);
-	int handle_in = pack200_file.handle();
-	// FIXME: dispose of file handles, pointers and the like. Ideally wrap in objects.
-	if(handle_in == -1)
-	{
-		qCritical() << "Error reopening " << pack200_file.fileName();
-		failAndTryNextMirror();
-		return;
-	}
-	int handle_in_dup = dup (handle_in);
-	if(handle_in_dup == -1)
-	{
-		qCritical() << "Error reopening " << pack200_file.fileName();
-		failAndTryNextMirror();
-		return;
-	}
-	FILE *file_in = fdopen (handle_in_dup, "rb");
-	if(!file_in)
-	{
-		qCritical() << "Error reopening " << pack200_file.fileName();
-		failAndTryNextMirror();
-		return;
-	}
+namespace
+{
+int64_t writeToFile(void *context, const void *buf, int64_t len)
+{
+	return ((QFile *)context)->write((const char *)buf, len);
+}
+}
+
+void ForgeXzDownload::unpackAndInstall()
+{
 	QFile qfile_out(m_target_path);
 	if(!qfile_out.open(QIODevice::WriteOnly))
 	{
 		qCritical() << "Error opening " << qfile_out.fileName();
-		failAndTryNextMirror();
-		return;
-	}
-	int handle_out = qfile_out.handle();
-	if(handle_out == -1)
-	{
-		qCritical() << "Error opening " << qfile_out.fileName();
-		failAndTryNextMirror();
-		return;
-	}
-	int handle_out_dup = dup (handle_out);
-	if(handle_out_dup == -1)
-	{
-		qCritical() << "Error reopening " << qfile_out.fileName();
-		failAndTryNextMirror();
-		return;
-	}
-	FILE *file_out = fdopen (handle_out_dup, "wb");
-	if(!file_out)
-	{
-		qCritical() << "Error opening " << qfile_out.fileName();
+		resetDecoder();
 		failAndTryNextMirror();
 		return;
 	}
 	try
 	{
-		// NOTE: this takes ownership of both FILE pointers. That's why we duplicate them above.
-		unpack_200(file_in, file_out);
+		unpack_200(m_pack200_data.constData(), m_pack200_data.size(), writeToFile, &qfile_out);
 	}
 	catch (std::runtime_error &err)
 	{
 		m_status = Job_Failed;
-		qCritical() << "Error unpacking " << pack200_file.fileName() << " : " << err.what();
+		qCritical() << "Error unpacking " << m_url.toString() << " : " << err.what();
+		qfile_out.close();
 		QFile f(m_target_path);
 		if (f.exists())
 			f.remove();
+		resetDecoder();
 		failAndTryNextMirror();
 		return;
 	}
-	pack200_file.remove();
-
-	QFile jar_file(m_target_path);
+	qfile_out.close();
+	resetDecoder();
 
-	if (!jar_file.open(QIODevice::ReadOnly))
+	auto hashes = ENV.fileHashes()->hash(m_target_path);
+	if (!hashes.isValid())
 	{
-		jar_file.remove();
+		QFile::remove(m_target_path);
 		failAndTryNextMirror();
 		return;
 	}
-	auto hash = QCryptographicHash::hash(jar_file.readAll(), QCryptographicHash::Md5);
-	m_entry->setMD5Sum(hash.toHex().constData());
-	jar_file.close();
+	m_entry->setMD5Sum(hashes.md5.toHex().constData());
 
 	QFileInfo output_file_info(m_target_path);
 	m_entry->setETag(m_reply->rawHeader("ETag").constData());
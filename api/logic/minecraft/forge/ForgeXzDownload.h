@@ -18,7 +18,9 @@
 #include "net/NetAction.h"
 #include "net/HttpMetaCache.h"
 #include <QFile>
-#include <QTemporaryFile>
+#include <QByteArray>
+
+struct xz_dec;
 
 typedef std::shared_ptr<class ForgeXzDownload> ForgeXzDownloadPtr;
 
@@ -29,8 +31,12 @@ public:
 	MetaEntryPtr m_entry;
 	/// if saving to file, use the one specified in this string
 	QString m_target_path;
-	/// this is the output file, if any
-	QTemporaryFile m_pack200_xz_file;
+	/// the xz decoder, fed as the data arrives
+	xz_dec *m_xz_decoder = nullptr;
+	/// did the decoder see the end of the xz stream?
+	bool m_xz_finished = false;
+	/// the decompressed pack200 data
+	QByteArray m_pack200_data;
 	/// path relative to the mirror base
 	QString m_url_path;
 
@@ -40,7 +46,7 @@ public:
 	{
 		return ForgeXzDownloadPtr(new ForgeXzDownload(relative_path, entry));
 	}
-	virtual ~ForgeXzDownload(){};
+	virtual ~ForgeXzDownload();
 
 protected
 slots:
@@ -54,6 +60,8 @@ slots:
 	virtual void start();
 
 private:
-	void decompressAndInstall();
+	bool decompressChunk(const QByteArray &data);
+	void resetDecoder();
+	void unpackAndInstall();
 	void failAndTryNextMirror();
 };
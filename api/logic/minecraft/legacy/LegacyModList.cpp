@@ -14,6 +14,8 @@
  */
 
 #include "LegacyModList.h"
+#include "ListModelDiff.h"
+#include "FolderModelScan.h"
 #include <FileSystem.h>
 #include <QMimeData>
 #include <QUrl>
@@ -34,6 +36,7 @@ LegacyModList::LegacyModList(const QString &dir, const QString &list_file)
 	is_watching = false;
 	connect(m_watcher, SIGNAL(directoryChanged(QString)), this,
 			SLOT(directoryChanged(QString)));
+	setupFolderSettleTimer(m_updateTimer, this, SLOT(directorySettled()));
 }
 
 void LegacyModList::startWatching()
@@ -81,6 +84,7 @@ bool LegacyModList::update()
 	if (!isValid())
 		return false;
 
+	m_updateTimer.stop();
 	QList<Mod> orderedMods;
 	QList<Mod> newMods;
 	m_dir.refresh();
@@ -157,9 +161,15 @@ bool LegacyModList::update()
 				}
 			}
 	}
-	beginResetModel();
-	mods.swap(orderedMods);
-	endResetModel();
+	auto key = [](const Mod &mod)
+	{
+		return mod.filename().filePath();
+	};
+	auto same = [](const Mod &left, const Mod &right)
+	{
+		return left.strongCompare(right) && left.name() == right.name() && left.enabled() == right.enabled();
+	};
+	ListModelDiff::apply(this, mods, orderedMods, key, same);
 	if (orderOrStateChanged && !m_list_file.isEmpty())
 	{
 		qDebug() << "Mod list " << m_list_file << " changed!";
@@ -170,6 +180,11 @@ bool LegacyModList::update()
 }
 
 void LegacyModList::directoryChanged(QString path)
+{
+	m_updateTimer.start();
+}
+
+void LegacyModList::directorySettled()
 {
 	update();
 }
@@ -19,6 +19,7 @@
 #include <QString>
 #include <QDir>
 #include <QAbstractListModel>
+#include <QTimer>
 
 #include "minecraft/Mod.h"
 
@@ -35,6 +36,7 @@ class QFileSystemWatcher;
 class MULTIMC_LOGIC_EXPORT LegacyModList : public QAbstractListModel
 {
 	Q_OBJECT
+	friend class ListModelDiff;
 public:
 	enum Columns
 	{
@@ -146,12 +148,14 @@ private:
 private
 slots:
 	void directoryChanged(QString path);
+	void directorySettled();
 
 signals:
 	void changed();
 
 protected:
 	QFileSystemWatcher *m_watcher;
+	QTimer m_updateTimer;
 	bool is_watching;
 	QDir m_dir;
 	QString m_list_file;
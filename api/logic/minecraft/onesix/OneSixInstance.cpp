@@ -34,6 +34,7 @@
 
 #include "minecraft/AssetsUtils.h"
 #include "minecraft/WorldList.h"
+#include "minecraft/ModdedJarCache.h"
 #include <FileSystem.h>
 
 OneSixInstance::OneSixInstance(SettingsObjectPtr globalSettings, SettingsObjectPtr settings, const QString &rootDir)
@@ -357,7 +358,9 @@ std::shared_ptr<Task> OneSixInstance::createJarModdingTask()
 				auto metacache = ENV.metacache();
 				auto entry = metacache->resolveEntry("versions", localPath);
 				QString fullJarPath = entry->getFullPath();
-				if(!MMCZip::createModdedJar(sourceJarPath, finalJarPath, jarMods))
+				// the same set of jar mods gives the same jar, so reuse it when we can
+				ModdedJarCache cache(QDir("cache/jars").absolutePath());
+				if(!cache.install(sourceJarPath, jarMods, finalJarPath))
 				{
 					emitFailed(tr("Failed to create the custom Minecraft jar file."));
 					return;
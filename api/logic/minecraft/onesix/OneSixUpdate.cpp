@@ -61,17 +61,17 @@ void OneSixUpdate::executeTask()
 	if (m_inst->providesVersionFile() || !targetVersion->needsUpdate())
 	{
 		qDebug() << "Instance either provides a version file or doesn't need an update.";
-		jarlibStart();
+		stagesStart();
 		return;
 	}
 	versionUpdateTask = std::dynamic_pointer_cast<MinecraftVersionList>(ENV.getVersionList("net.minecraft"))->createUpdateTask(m_inst->intendedVersionId());
 	if (!versionUpdateTask)
 	{
 		qDebug() << "Didn't spawn an update task.";
-		jarlibStart();
+		stagesStart();
 		return;
 	}
-	connect(versionUpdateTask.get(), SIGNAL(succeeded()), SLOT(jarlibStart()));
+	connect(versionUpdateTask.get(), SIGNAL(succeeded()), SLOT(stagesStart()));
 	connect(versionUpdateTask.get(), &NetJob::failed, this, &OneSixUpdate::versionUpdateFailed);
 	connect(versionUpdateTask.get(), SIGNAL(progress(qint64, qint64)), SIGNAL(progress(qint64, qint64)));
 	setStatus(tr("Getting the version files from Mojang..."));
@@ -83,9 +83,120 @@ void OneSixUpdate::versionUpdateFailed(QString reason)
 	emitFailed(reason);
 }
 
+void OneSixUpdate::stagesStart()
+{
+	if (!isRunning())
+	{
+		return;
+	}
+	OneSixInstance *inst = (OneSixInstance *)m_inst;
+	inst->reloadProfile();
+	if(inst->flags() & BaseInstance::VersionBrokenFlag)
+	{
+		emitFailed(tr("Failed to load the version description files - check the instance for errors."));
+		return;
+	}
+
+	// the stages only depend on the profile, so they all run at once
+	setStatus(tr("Getting the game files from Mojang..."));
+	m_pendingStages = Stage_Count;
+	for (auto &item : m_stageProgress)
+	{
+		item = StageProgress();
+	}
+	// a stage can fail right away, then the others don't start at all
+	jarlibStart();
+	if (isRunning())
+	{
+		fmllibsStart();
+	}
+	if (isRunning())
+	{
+		assetIndexStart();
+	}
+}
+
+void OneSixUpdate::trackProgress(Task *task, Stage stage)
+{
+	connect(task, &Task::progress, this, [this, stage](qint64 current, qint64 total)
+	{
+		stageProgress(stage, current, total);
+	});
+}
+
+void OneSixUpdate::stageProgress(Stage stage, qint64 current, qint64 total)
+{
+	auto &item = m_stageProgress[stage];
+	item.current = current;
+	item.total = total;
+	qint64 sumCurrent = 0;
+	qint64 sumTotal = 0;
+	for (auto &item : m_stageProgress)
+	{
+		sumCurrent += item.current;
+		sumTotal += item.total;
+	}
+	setProgress(sumCurrent, sumTotal);
+}
+
+void OneSixUpdate::stageFinished(Stage stage)
+{
+	if (!isRunning())
+	{
+		return;
+	}
+	// mark the stage as complete
+	auto &item = m_stageProgress[stage];
+	stageProgress(stage, item.total, item.total);
+	m_pendingStages--;
+	if (m_pendingStages == 0)
+	{
+		emitSucceeded();
+	}
+}
+
+void OneSixUpdate::stageFailed(QString reason)
+{
+	// the first failure wins
+	if (!isRunning())
+	{
+		return;
+	}
+	abortStages();
+	emitFailed(reason);
+}
+
+void OneSixUpdate::abortStages()
+{
+	if (versionUpdateTask)
+	{
+		versionUpdateTask->disconnect(this);
+		versionUpdateTask->abort();
+	}
+	for (auto job : {jarlibDownloadJob, legacyDownloadJob, assetsDownloadJob})
+	{
+		if (job)
+		{
+			job->disconnect(this);
+			job->abort();
+		}
+	}
+}
+
+bool OneSixUpdate::abort()
+{
+	if (!isRunning())
+	{
+		return false;
+	}
+	abortStages();
+	emitFailed(tr("Aborted."));
+	return true;
+}
+
 void OneSixUpdate::assetIndexStart()
 {
-	setStatus(tr("Updating assets index..."));
+	qDebug() << m_inst->name() << ": Starting asset index download";
 	OneSixInstance *inst = (OneSixInstance *)m_inst;
 	auto profile = inst->getMinecraftProfile();
 	auto assets = profile->getMinecraftAssets();
@@ -96,19 +207,26 @@ void OneSixUpdate::assetIndexStart()
 	auto metacache = ENV.metacache();
 	auto entry = metacache->resolveEntry("asset_indexes", localPath);
 	entry->setStale(true);
-	job->addNetAction(CacheDownload::make(indexUrl, entry));
-	jarlibDownloadJob.reset(job);
-
-	connect(jarlibDownloadJob.get(), SIGNAL(succeeded()), SLOT(assetIndexFinished()));
-	connect(jarlibDownloadJob.get(), &NetJob::failed, this, &OneSixUpdate::assetIndexFailed);
-	connect(jarlibDownloadJob.get(), SIGNAL(progress(qint64, qint64)), SIGNAL(progress(qint64, qint64)));
-
-	qDebug() << m_inst->name() << ": Starting asset index download";
-	jarlibDownloadJob->start();
+	auto indexDownload = CacheDownload::make(indexUrl, entry);
+	indexDownload->setPriority(Priority_High);
+	indexDownload->setSizeHint(assets->size);
+	indexDownload->setExpectedSha1(assets->sha1);
+	job->addNetAction(indexDownload);
+	assetsDownloadJob.reset(job);
+
+	connect(assetsDownloadJob.get(), SIGNAL(succeeded()), SLOT(assetIndexFinished()));
+	connect(assetsDownloadJob.get(), &NetJob::failed, this, &OneSixUpdate::assetIndexFailed);
+	trackProgress(assetsDownloadJob.get(), Stage_Assets);
+
+	assetsDownloadJob->start();
 }
 
 void OneSixUpdate::assetIndexFinished()
 {
+	if (!isRunning())
+	{
+		return;
+	}
 	AssetsIndex index;
 	qDebug() << m_inst->name() << ": Finished asset index download";
 
@@ -123,18 +241,19 @@ void OneSixUpdate::assetIndexFinished()
 		auto metacache = ENV.metacache();
 		auto entry = metacache->resolveEntry("asset_indexes", assets->id + ".json");
 		metacache->evictEntry(entry);
-		emitFailed(tr("Failed to read the assets index!"));
+		stageFailed(tr("Failed to read the assets index!"));
+		return;
 	}
 
 	auto job = index.getDownloadJob();
 	if(job)
 	{
-		setStatus(tr("Getting the assets files from Mojang..."));
-		jarlibDownloadJob = job;
-		connect(jarlibDownloadJob.get(), SIGNAL(succeeded()), SLOT(assetsFinished()));
-		connect(jarlibDownloadJob.get(), &NetJob::failed, this, &OneSixUpdate::assetsFailed);
-		connect(jarlibDownloadJob.get(), SIGNAL(progress(qint64, qint64)), SIGNAL(progress(qint64, qint64)));
-		jarlibDownloadJob->start();
+		qDebug() << m_inst->name() << ": Starting assets download";
+		assetsDownloadJob = job;
+		connect(assetsDownloadJob.get(), SIGNAL(succeeded()), SLOT(assetsFinished()));
+		connect(assetsDownloadJob.get(), &NetJob::failed, this, &OneSixUpdate::assetsFailed);
+		trackProgress(assetsDownloadJob.get(), Stage_Assets);
+		assetsDownloadJob->start();
 		return;
 	}
 	assetsFinished();
@@ -143,30 +262,24 @@ void OneSixUpdate::assetIndexFinished()
 void OneSixUpdate::assetIndexFailed(QString reason)
 {
 	qDebug() << m_inst->name() << ": Failed asset index download";
-	emitFailed(tr("Failed to download the assets index:\n%1").arg(reason));
+	stageFailed(tr("Failed to download the assets index:\n%1").arg(reason));
 }
 
 void OneSixUpdate::assetsFinished()
 {
-	emitSucceeded();
+	qDebug() << m_inst->name() << ": Finished assets download";
+	stageFinished(Stage_Assets);
 }
 
 void OneSixUpdate::assetsFailed(QString reason)
 {
-	emitFailed(tr("Failed to download assets:\n%1").arg(reason));
+	stageFailed(tr("Failed to download assets:\n%1").arg(reason));
 }
 
 void OneSixUpdate::jarlibStart()
 {
-	setStatus(tr("Getting the library files from Mojang..."));
 	qDebug() << m_inst->name() << ": downloading libraries";
 	OneSixInstance *inst = (OneSixInstance *)m_inst;
-	inst->reloadProfile();
-	if(inst->flags() & BaseInstance::VersionBrokenFlag)
-	{
-		emitFailed(tr("Failed to load the version description files - check the instance for errors."));
-		return;
-	}
 
 	// Build a list of URLs that will need to be downloaded.
 	std::shared_ptr<MinecraftProfile> profile = inst->getMinecraftProfile();
@@ -180,7 +293,10 @@ void OneSixUpdate::jarlibStart()
 
 		auto metacache = ENV.metacache();
 		auto entry = metacache->resolveEntry("versions", localPath);
-		job->addNetAction(CacheDownload::make(QUrl(urlstr), entry));
+		auto jarDownload = CacheDownload::make(QUrl(urlstr), entry);
+		jarDownload->setExpectedSha1(profile->getMainJarSha1());
+		jarDownload->setPriority(Priority_High);
+		job->addNetAction(jarDownload);
 		jarlibDownloadJob.reset(job);
 	}
 
@@ -203,7 +319,7 @@ void OneSixUpdate::jarlibStart()
 		jarlibDownloadJob.reset();
 
 		QString failed_all = failedFiles.join("\n");
-		emitFailed(tr("Some libraries marked as 'local' are missing their jar "
+		stageFailed(tr("Some libraries marked as 'local' are missing their jar "
 					  "files:\n%1\n\nYou'll have to correct this problem manually. If this is "
 					  "an externally tracked instance, make sure to run it at least once "
 					  "outside of MultiMC.").arg(failed_all));
@@ -212,32 +328,22 @@ void OneSixUpdate::jarlibStart()
 
 	connect(jarlibDownloadJob.get(), SIGNAL(succeeded()), SLOT(jarlibFinished()));
 	connect(jarlibDownloadJob.get(), &NetJob::failed, this, &OneSixUpdate::jarlibFailed);
-	connect(jarlibDownloadJob.get(), SIGNAL(progress(qint64, qint64)),
-			SIGNAL(progress(qint64, qint64)));
+	trackProgress(jarlibDownloadJob.get(), Stage_JarLib);
 
 	jarlibDownloadJob->start();
 }
 
 void OneSixUpdate::jarlibFinished()
 {
-	OneSixInstance *inst = (OneSixInstance *)m_inst;
-	std::shared_ptr<MinecraftProfile> profile = inst->getMinecraftProfile();
-
-	if (profile->hasTrait("legacyFML"))
-	{
-		fmllibsStart();
-	}
-	else
-	{
-		assetIndexStart();
-	}
+	qDebug() << m_inst->name() << ": Finished library download";
+	stageFinished(Stage_JarLib);
 }
 
 void OneSixUpdate::jarlibFailed(QString reason)
 {
 	QStringList failed = jarlibDownloadJob->getFailedFiles();
 	QString failed_all = failed.join("\n");
-	emitFailed(
+	stageFailed(
 		tr("Failed to download the following files:\n%1\n\nReason:%2\nPlease try again.").arg(failed_all, reason));
 }
 
@@ -248,27 +354,33 @@ void OneSixUpdate::fmllibsStart()
 	std::shared_ptr<MinecraftProfile> profile = inst->getMinecraftProfile();
 	bool forge_present = false;
 
+	if (!profile->hasTrait("legacyFML"))
+	{
+		stageFinished(Stage_FMLLibs);
+		return;
+	}
+
 	QString version = inst->intendedVersionId();
 	auto &fmlLibsMapping = g_VersionFilterData.fmlLibsMapping;
 	if (!fmlLibsMapping.contains(version))
 	{
-		assetIndexStart();
+		stageFinished(Stage_FMLLibs);
 		return;
 	}
 
 	auto &libList = fmlLibsMapping[version];
 
 	// determine if we need some libs for FML or forge
-	setStatus(tr("Checking for FML libraries..."));
 	forge_present = (profile->versionPatch("net.minecraftforge") != nullptr);
 	// we don't...
 	if (!forge_present)
 	{
-		assetIndexStart();
+		stageFinished(Stage_FMLLibs);
 		return;
 	}
 
 	// now check the lib folder inside the instance for files.
+	fmlLibsToProcess.clear();
 	for (auto &lib : libList)
 	{
 		QFileInfo libInfo(FS::PathCombine(inst->libDir(), lib.filename));
@@ -280,12 +392,12 @@ void OneSixUpdate::fmllibsStart()
 	// if everything is in place, there's nothing to do here...
 	if (fmlLibsToProcess.isEmpty())
 	{
-		assetIndexStart();
+		stageFinished(Stage_FMLLibs);
 		return;
 	}
 
 	// download missing libs to our place
-	setStatus(tr("Dowloading FML libraries..."));
+	qDebug() << m_inst->name() << ": downloading FML libraries";
 	auto dljob = new NetJob("FML libraries");
 	auto metacache = ENV.metacache();
 	for (auto &lib : fmlLibsToProcess)
@@ -298,7 +410,7 @@ void OneSixUpdate::fmllibsStart()
 
 	connect(dljob, SIGNAL(succeeded()), SLOT(fmllibsFinished()));
 	connect(dljob, &NetJob::failed, this, &OneSixUpdate::fmllibsFailed);
-	connect(dljob, SIGNAL(progress(qint64, qint64)), SIGNAL(progress(qint64, qint64)));
+	trackProgress(dljob, Stage_FMLLibs);
 	legacyDownloadJob.reset(dljob);
 	legacyDownloadJob->start();
 }
@@ -306,37 +418,36 @@ void OneSixUpdate::fmllibsStart()
 void OneSixUpdate::fmllibsFinished()
 {
 	legacyDownloadJob.reset();
+	if (!isRunning())
+	{
+		return;
+	}
 	if (!fmlLibsToProcess.isEmpty())
 	{
-		setStatus(tr("Copying FML libraries into the instance..."));
+		qDebug() << m_inst->name() << ": copying FML libraries into the instance";
 		OneSixInstance *inst = (OneSixInstance *)m_inst;
 		auto metacache = ENV.metacache();
-		int index = 0;
 		for (auto &lib : fmlLibsToProcess)
 		{
-			progress(index, fmlLibsToProcess.size());
 			auto entry = metacache->resolveEntry("fmllibs", lib.filename);
 			auto path = FS::PathCombine(inst->libDir(), lib.filename);
 			if (!FS::ensureFilePathExists(path))
 			{
-				emitFailed(tr("Failed creating FML library folder inside the instance."));
+				stageFailed(tr("Failed creating FML library folder inside the instance."));
 				return;
 			}
 			if (!QFile::copy(entry->getFullPath(), FS::PathCombine(inst->libDir(), lib.filename)))
 			{
-				emitFailed(tr("Failed copying Forge/FML library: %1.").arg(lib.filename));
+				stageFailed(tr("Failed copying Forge/FML library: %1.").arg(lib.filename));
 				return;
 			}
-			index++;
 		}
-		progress(index, fmlLibsToProcess.size());
 	}
-	assetIndexStart();
+	stageFinished(Stage_FMLLibs);
 }
 
 void OneSixUpdate::fmllibsFailed(QString reason)
 {
-	emitFailed(tr("Game update failed: it was impossible to fetch the required FML libraries.\nReason:\n%1").arg(reason));
+	stageFailed(tr("Game update failed: it was impossible to fetch the required FML libraries.\nReason:\n%1").arg(reason));
 	return;
 }
-
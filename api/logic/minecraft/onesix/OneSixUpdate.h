@@ -27,6 +27,16 @@
 class MinecraftVersion;
 class OneSixInstance;
 
+/*
+ * Updates a OneSix instance.
+ *
+ * After the version files are up to date, the independent stages run at the same time:
+ *  - the minecraft jar and the libraries
+ *  - the legacy FML libraries
+ *  - the asset index, followed by the asset objects
+ * Progress of all the stages is summed up into the progress of the whole task.
+ * The first stage that fails stops the others.
+ */
 class OneSixUpdate : public Task
 {
 	Q_OBJECT
@@ -34,10 +44,20 @@ public:
 	explicit OneSixUpdate(OneSixInstance *inst, QObject *parent = 0);
 	virtual void executeTask();
 
+	bool canAbort() const override
+	{
+		return true;
+	}
+
+public slots:
+	bool abort() override;
+
 private
 slots:
 	void versionUpdateFailed(QString reason);
 
+	void stagesStart();
+
 	void jarlibStart();
 	void jarlibFinished();
 	void jarlibFailed(QString reason);
@@ -53,9 +73,25 @@ slots:
 	void assetsFinished();
 	void assetsFailed(QString reason);
 
+private:
+	enum Stage
+	{
+		Stage_JarLib,
+		Stage_FMLLibs,
+		Stage_Assets,
+		Stage_Count
+	};
+	void trackProgress(Task *task, Stage stage);
+	void stageProgress(Stage stage, qint64 current, qint64 total);
+	void stageFinished(Stage stage);
+	void stageFailed(QString reason);
+	/// stop everything that is still running, without hearing back from it
+	void abortStages();
+
 private:
 	NetJobPtr jarlibDownloadJob;
 	NetJobPtr legacyDownloadJob;
+	NetJobPtr assetsDownloadJob;
 
 	/// target version, determined during this task
 	std::shared_ptr<MinecraftVersion> targetVersion;
@@ -64,4 +100,13 @@ private:
 
 	OneSixInstance *m_inst = nullptr;
 	QList<FMLlib> fmlLibsToProcess;
+
+	/// stages that are still running
+	int m_pendingStages = 0;
+	struct StageProgress
+	{
+		qint64 current = 0;
+		qint64 total = 0;
+	};
+	StageProgress m_stageProgress[Stage_Count];
 };
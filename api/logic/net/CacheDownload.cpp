@@ -23,7 +23,7 @@
 #include <FileSystem.h>
 
 CacheDownload::CacheDownload(QUrl url, MetaEntryPtr entry)
-	: NetAction(), md5sum(QCryptographicHash::Md5)
+	: NetAction(), md5sum(QCryptographicHash::Md5), sha1sum(QCryptographicHash::Sha1)
 {
 	m_url = url;
 	m_entry = entry;
@@ -42,6 +42,9 @@ void CacheDownload::start()
 	}
 	// create a new save file
 	m_output_file.reset(new QSaveFile(m_target_path));
+	md5sum.reset();
+	sha1sum.reset();
+	wroteAnyData = false;
 
 	// if there already is a file and md5 checking is in effect and it can be opened
 	if (!FS::ensureFilePathExists(m_target_path))
@@ -134,6 +137,22 @@ void CacheDownload::downloadFinished()
 	// if we wrote any data to the save file, we try to commit the data to the real file.
 	if (wroteAnyData)
 	{
+		// but only if it is what we asked for
+		if (!m_expected_sha1.isEmpty())
+		{
+			auto sha1 = QString::fromLatin1(sha1sum.result().toHex());
+			if (sha1.compare(m_expected_sha1, Qt::CaseInsensitive) != 0)
+			{
+				qCritical() << "SHA-1 mismatch for" << m_url.toString() << ": expected"
+							<< m_expected_sha1 << "got" << sha1;
+				m_output_file->cancelWriting();
+				m_output_file.reset();
+				m_reply.reset();
+				m_status = Job_Failed;
+				emit failed(m_index_within_job);
+				return;
+			}
+		}
 		// nothing went wrong...
 		if (m_output_file->commit())
 		{
@@ -178,6 +197,7 @@ void CacheDownload::downloadReadyRead()
 {
 	QByteArray ba = m_reply->readAll();
 	md5sum.addData(ba);
+	sha1sum.addData(ba);
 	if (m_output_file->write(ba) != ba.size())
 	{
 		qCritical() << "Failed writing into " + m_target_path;
@@ -36,6 +36,10 @@ private:
 
 	/// the hash-as-you-download
 	QCryptographicHash md5sum;
+	QCryptographicHash sha1sum;
+
+	/// the expected sha1 checksum, if known
+	QString m_expected_sha1;
 
 	bool wroteAnyData = false;
 
@@ -50,6 +54,11 @@ public:
 	{
 		return m_target_path;
 	}
+	/// downloaded data that doesn't match the hex encoded checksum will be discarded
+	void setExpectedSha1(const QString &sha1)
+	{
+		m_expected_sha1 = sha1;
+	}
 protected
 slots:
 	virtual void downloadProgress(qint64 bytesReceived, qint64 bytesTotal);
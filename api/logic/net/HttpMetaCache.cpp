@@ -16,17 +16,49 @@
 #include "Env.h"
 #include "HttpMetaCache.h"
 #include "FileSystem.h"
+#include "FileHashCache.h"
 
 #include <QFileInfo>
 #include <QFile>
 #include <QDateTime>
-#include <QCryptographicHash>
 
 #include <QDebug>
 
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QDataStream>
+
+#include <cstring>
+
+namespace
+{
+// "MMCJ"
+const quint32 journalMagic = 0x4d4d434a;
+const quint32 journalVersion = 3;
+// dead records allowed in the journal on top of the live ones before it gets compacted
+const int journalSlack = 1024;
+
+enum JournalOperation : quint8
+{
+	Journal_Put = 1,
+	Journal_Remove = 2
+};
+
+bool md5FromHex(const QString &hex, std::array<quint8, 16> &out)
+{
+	auto raw = QByteArray::fromHex(hex.toLatin1());
+	if (raw.size() != int(out.size()))
+		return false;
+	std::memcpy(out.data(), raw.constData(), out.size());
+	return true;
+}
+
+QString md5ToHex(const std::array<quint8, 16> &md5)
+{
+	return QString::fromLatin1(QByteArray::fromRawData((const char *)md5.data(), md5.size()).toHex());
+}
+}
 
 QString MetaEntry::getFullPath()
 {
@@ -34,9 +66,40 @@ QString MetaEntry::getFullPath()
 	return FS::PathCombine(basePath, relativePath);
 }
 
+int HttpMetaCache::EntryTable::insert(const QString &path)
+{
+	int row = find(path);
+	if (row != -1)
+		return row;
+	row = records.size();
+	rows.insert(path, row);
+	paths.append(path);
+	records.append(EntryRecord());
+	return row;
+}
+
+void HttpMetaCache::EntryTable::remove(int row)
+{
+	// move the last row into the hole
+	int last = records.size() - 1;
+	rows.remove(paths[row]);
+	if (row != last)
+	{
+		paths[row] = paths[last];
+		records[row] = records[last];
+		rows[paths[row]] = row;
+	}
+	paths.removeLast();
+	records.removeLast();
+}
+
 HttpMetaCache::HttpMetaCache(QString path) : QObject()
 {
 	m_index_file = path;
+	if (!path.isNull())
+	{
+		m_journal_file = path + ".journal";
+	}
 	saveBatchingTimer.setSingleShot(true);
 	saveBatchingTimer.setTimerType(Qt::VeryCoarseTimer);
 	connect(&saveBatchingTimer, SIGNAL(timeout()), SLOT(SaveNow()));
@@ -48,77 +111,121 @@ HttpMetaCache::~HttpMetaCache()
 	SaveNow();
 }
 
+MetaEntryPtr HttpMetaCache::materialize(const QString &base, const EntryTable &table, int row)
+{
+	auto &record = table.records[row];
+	auto entry = MetaEntryPtr(new MetaEntry());
+	entry->baseId = base;
+	entry->basePath = table.base_path;
+	entry->relativePath = table.paths[row];
+	if (record.has_md5)
+	{
+		entry->md5sum = md5ToHex(record.md5);
+	}
+	entry->etag = QString::fromUtf8(record.etag);
+	entry->local_changed_timestamp = record.local_changed_timestamp;
+	entry->remote_changed_timestamp = QString::fromLatin1(record.remote_changed_timestamp);
+	entry->stale = false;
+	return entry;
+}
+
 MetaEntryPtr HttpMetaCache::getEntry(QString base, QString resource_path)
 {
+	auto iter = m_entries.constFind(base);
 	// no base. no base path. can't store
-	if (!m_entries.contains(base))
+	if (iter == m_entries.constEnd())
 	{
 		// TODO: log problem
 		return MetaEntryPtr();
 	}
-	EntryMap &map = m_entries[base];
-	if (map.entry_list.contains(resource_path))
+	int row = iter->find(resource_path);
+	if (row == -1)
 	{
-		return map.entry_list[resource_path];
+		return MetaEntryPtr();
 	}
-	return MetaEntryPtr();
+	return materialize(iter.key(), *iter, row);
 }
 
-MetaEntryPtr HttpMetaCache::resolveEntry(QString base, QString resource_path, QString expected_etag)
+int HttpMetaCache::resolveRow(const QString &base, const QString &resource_path,
+							  const QString &expected_etag)
 {
-	auto entry = getEntry(base, resource_path);
-	// it's not present? generate a default stale entry
-	if (!entry)
+	auto iter = m_entries.find(base);
+	if (iter == m_entries.end())
 	{
-		return staleEntry(base, resource_path);
+		return -1;
+	}
+	auto &table = *iter;
+	int row = table.find(resource_path);
+	if (row == -1)
+	{
+		return -1;
 	}
 
-	auto &selected_base = m_entries[base];
-	QString real_path = FS::PathCombine(selected_base.base_path, resource_path);
+	QString real_path = FS::PathCombine(table.base_path, resource_path);
 	QFileInfo finfo(real_path);
 
 	// is the file really there? if not -> stale
 	if (!finfo.isFile() || !finfo.isReadable())
 	{
 		// if the file doesn't exist, we disown the entry
-		selected_base.entry_list.remove(resource_path);
-		return staleEntry(base, resource_path);
+		table.remove(row);
+		markDirty(base, resource_path);
+		return -1;
 	}
 
-	if (!expected_etag.isEmpty() && expected_etag != entry->etag)
+	auto &record = table.records[row];
+	if (!expected_etag.isEmpty() && expected_etag.toUtf8() != record.etag)
 	{
 		// if the etag doesn't match expected, we disown the entry
-		selected_base.entry_list.remove(resource_path);
-		return staleEntry(base, resource_path);
+		table.remove(row);
+		markDirty(base, resource_path);
+		return -1;
 	}
 
 	// if the file changed, check md5sum
 	qint64 file_last_changed = finfo.lastModified().toUTC().toMSecsSinceEpoch();
-	if (file_last_changed != entry->local_changed_timestamp)
-	{
-		QFile input(real_path);
-		input.open(QIODevice::ReadOnly);
-		QString md5sum = QCryptographicHash::hash(input.readAll(), QCryptographicHash::Md5)
-							 .toHex()
-							 .constData();
-		if (entry->md5sum != md5sum)
+	if (file_last_changed != record.local_changed_timestamp)
+	{
+		auto md5sum = ENV.fileHashes()->hash(real_path).md5;
+		if (!record.has_md5 || md5sum.size() != int(record.md5.size()) ||
+			std::memcmp(md5sum.constData(), record.md5.data(), record.md5.size()) != 0)
 		{
-			selected_base.entry_list.remove(resource_path);
-			return staleEntry(base, resource_path);
+			table.remove(row);
+			markDirty(base, resource_path);
+			return -1;
 		}
 		// md5sums matched... keep entry and save the new state to file
-		entry->local_changed_timestamp = file_last_changed;
+		record.local_changed_timestamp = file_last_changed;
+		markDirty(base, resource_path);
 		SaveEventually();
 	}
 
 	// entry passed all the checks we cared about.
-	entry->basePath = getBasePath(base);
-	return entry;
+	return row;
+}
+
+bool HttpMetaCache::checkEntry(const QString &base, const QString &resource_path,
+							   const QString &expected_etag)
+{
+	return resolveRow(base, resource_path, expected_etag) != -1;
+}
+
+MetaEntryPtr HttpMetaCache::resolveEntry(QString base, QString resource_path, QString expected_etag)
+{
+	int row = resolveRow(base, resource_path, expected_etag);
+	// it's not present or not usable? generate a default stale entry
+	if (row == -1)
+	{
+		return staleEntry(base, resource_path);
+	}
+	auto iter = m_entries.constFind(base);
+	return materialize(iter.key(), *iter, row);
 }
 
 bool HttpMetaCache::updateEntry(MetaEntryPtr stale_entry)
 {
-	if (!m_entries.contains(stale_entry->baseId))
+	auto iter = m_entries.find(stale_entry->baseId);
+	if (iter == m_entries.end())
 	{
 		qCritical() << "Cannot add entry with unknown base: "
 					 << stale_entry->baseId.toLocal8Bit();
@@ -129,7 +236,13 @@ bool HttpMetaCache::updateEntry(MetaEntryPtr stale_entry)
 		qCritical() << "Cannot add stale entry: " << stale_entry->getFullPath().toLocal8Bit();
 		return false;
 	}
-	m_entries[stale_entry->baseId].entry_list[stale_entry->relativePath] = stale_entry;
+	auto &table = *iter;
+	auto &record = table.records[table.insert(stale_entry->relativePath)];
+	record.has_md5 = md5FromHex(stale_entry->md5sum, record.md5);
+	record.etag = stale_entry->etag.toUtf8();
+	record.local_changed_timestamp = stale_entry->local_changed_timestamp;
+	record.remote_changed_timestamp = stale_entry->remote_changed_timestamp.toLatin1();
+	markDirty(stale_entry->baseId, stale_entry->relativePath);
 	SaveEventually();
 	return true;
 }
@@ -139,6 +252,16 @@ bool HttpMetaCache::evictEntry(MetaEntryPtr entry)
 	if(entry)
 	{
 		entry->stale = true;
+		auto iter = m_entries.find(entry->baseId);
+		if (iter != m_entries.end())
+		{
+			int row = iter->find(entry->relativePath);
+			if (row != -1)
+			{
+				iter->remove(row);
+			}
+		}
+		markDirty(entry->baseId, entry->relativePath);
 		SaveEventually();
 		return true;
 	}
@@ -161,25 +284,154 @@ void HttpMetaCache::addBase(QString base, QString base_root)
 	if (m_entries.contains(base))
 		return;
 	// TODO: check if the base path is valid
-	EntryMap foo;
+	EntryTable foo;
 	foo.base_path = base_root;
 	m_entries[base] = foo;
 }
 
 QString HttpMetaCache::getBasePath(QString base)
 {
-	if (m_entries.contains(base))
+	auto iter = m_entries.constFind(base);
+	if (iter != m_entries.constEnd())
 	{
-		return m_entries[base].base_path;
+		return iter->base_path;
 	}
 	return QString();
 }
 
+void HttpMetaCache::markDirty(const QString &base, const QString &resource_path)
+{
+	m_dirty.insert(qMakePair(base, resource_path));
+}
+
 void HttpMetaCache::Load()
 {
 	if(m_index_file.isNull())
 		return;
 
+	if (loadJournal())
+		return;
+
+	// no usable journal. import the old JSON index and write it out as a journal on the next save.
+	loadJson();
+	m_needs_compaction = true;
+	SaveEventually();
+}
+
+bool HttpMetaCache::loadJournal()
+{
+	QFile journal(m_journal_file);
+	if (!journal.open(QIODevice::ReadOnly))
+		return false;
+
+	qint64 size = journal.size();
+	uchar *mapped = journal.map(0, size);
+	QByteArray data;
+	if (mapped)
+	{
+		data = QByteArray::fromRawData((const char *)mapped, size);
+	}
+	else
+	{
+		data = journal.readAll();
+	}
+
+	QDataStream in(data);
+	quint32 magic = 0;
+	quint32 version = 0;
+	in >> magic >> version;
+	if (in.status() != QDataStream::Ok || magic != journalMagic || version != journalVersion)
+	{
+		qWarning() << "Ignoring unknown metacache journal format in" << m_journal_file;
+		if (mapped)
+			journal.unmap(mapped);
+		return false;
+	}
+
+	m_journal_records = 0;
+	m_needs_compaction = false;
+	while (!in.atEnd())
+	{
+		QByteArray record;
+		in >> record;
+		// a torn record at the end means we crashed while appending. drop it and rewrite the file.
+		if (in.status() != QDataStream::Ok)
+		{
+			qWarning() << "Metacache journal" << m_journal_file << "is truncated, it will be compacted.";
+			m_needs_compaction = true;
+			SaveEventually();
+			break;
+		}
+		readRecord(record);
+		m_journal_records++;
+	}
+	if (mapped)
+		journal.unmap(mapped);
+	return true;
+}
+
+void HttpMetaCache::readRecord(const QByteArray &record)
+{
+	QDataStream in(record);
+	quint8 operation = 0;
+	QByteArray base, path;
+	in >> operation >> base >> path;
+	auto iter = m_entries.find(QString::fromUtf8(base));
+	if (iter == m_entries.end())
+		return;
+	auto &table = *iter;
+	QString relativePath = QString::fromUtf8(path);
+	if (operation == Journal_Remove)
+	{
+		int row = table.find(relativePath);
+		if (row != -1)
+			table.remove(row);
+		return;
+	}
+	if (operation != Journal_Put)
+		return;
+
+	QByteArray md5, etag, remote_changed_timestamp;
+	qint64 local_changed_timestamp = 0;
+	in >> md5 >> etag >> local_changed_timestamp >> remote_changed_timestamp;
+	if (in.status() != QDataStream::Ok)
+		return;
+	auto &entry = table.records[table.insert(relativePath)];
+	entry.has_md5 = md5.size() == int(entry.md5.size());
+	if (entry.has_md5)
+	{
+		std::memcpy(entry.md5.data(), md5.constData(), entry.md5.size());
+	}
+	entry.etag = etag;
+	entry.local_changed_timestamp = local_changed_timestamp;
+	entry.remote_changed_timestamp = remote_changed_timestamp;
+}
+
+QByteArray HttpMetaCache::putRecord(const QString &base, const QString &resource_path,
+									const EntryRecord &entry)
+{
+	QByteArray record;
+	QDataStream out(&record, QIODevice::WriteOnly);
+	QByteArray md5;
+	if (entry.has_md5)
+	{
+		md5 = QByteArray((const char *)entry.md5.data(), entry.md5.size());
+	}
+	out << quint8(Journal_Put) << base.toUtf8() << resource_path.toUtf8() << md5 << entry.etag
+		<< entry.local_changed_timestamp << entry.remote_changed_timestamp;
+	return record;
+}
+
+QByteArray HttpMetaCache::removeRecord(const QString &base, const QString &resource_path)
+{
+	QByteArray record;
+	QDataStream out(&record, QIODevice::WriteOnly);
+	out << quint8(Journal_Remove) << base.toUtf8() << resource_path.toUtf8();
+	return record;
+}
+
+void HttpMetaCache::loadJson()
+{
 	QFile index(m_index_file);
 	if (!index.open(QIODevice::ReadOnly))
 		return;
@@ -206,20 +458,17 @@ void HttpMetaCache::Load()
 			return;
 		auto element_obj = element.toObject();
 		QString base = element_obj.value("base").toString();
-		if (!m_entries.contains(base))
+		auto iter = m_entries.find(base);
+		if (iter == m_entries.end())
 			continue;
-		auto &entrymap = m_entries[base];
-		auto foo = new MetaEntry();
-		foo->baseId = base;
-		QString path = foo->relativePath = element_obj.value("path").toString();
-		foo->md5sum = element_obj.value("md5sum").toString();
-		foo->etag = element_obj.value("etag").toString();
-		foo->local_changed_timestamp = element_obj.value("last_changed_timestamp").toDouble();
-		foo->remote_changed_timestamp =
-			element_obj.value("remote_changed_timestamp").toString();
-		// presumed innocent until closer examination
-		foo->stale = false;
-		entrymap.entry_list[path] = MetaEntryPtr(foo);
+		auto &table = *iter;
+		QString path = element_obj.value("path").toString();
+		auto &entry = table.records[table.insert(path)];
+		entry.has_md5 = md5FromHex(element_obj.value("md5sum").toString(), entry.md5);
+		entry.etag = element_obj.value("etag").toString().toUtf8();
+		entry.local_changed_timestamp = element_obj.value("last_changed_timestamp").toDouble();
+		entry.remote_changed_timestamp =
+			element_obj.value("remote_changed_timestamp").toString().toLatin1();
 	}
 }
 
@@ -234,40 +483,93 @@ void HttpMetaCache::SaveNow()
 {
 	if(m_index_file.isNull())
 		return;
-	QJsonObject toplevel;
-	toplevel.insert("version", QJsonValue(QString("1")));
-	QJsonArray entriesArr;
-	for (auto group : m_entries)
+
+	if (!m_needs_compaction && !QFile::exists(m_journal_file))
+	{
+		m_needs_compaction = true;
+	}
+	if (!m_needs_compaction)
 	{
-		for (auto entry : group.entry_list)
+		int live = 0;
+		for (auto &table : m_entries)
 		{
-			// do not save stale entries. they are dead.
-			if(entry->stale)
-			{
-				continue;
-			}
-			QJsonObject entryObj;
-			entryObj.insert("base", QJsonValue(entry->baseId));
-			entryObj.insert("path", QJsonValue(entry->relativePath));
-			entryObj.insert("md5sum", QJsonValue(entry->md5sum));
-			entryObj.insert("etag", QJsonValue(entry->etag));
-			entryObj.insert("last_changed_timestamp",
-							QJsonValue(double(entry->local_changed_timestamp)));
-			if (!entry->remote_changed_timestamp.isEmpty())
-				entryObj.insert("remote_changed_timestamp",
-								QJsonValue(entry->remote_changed_timestamp));
-			entriesArr.append(entryObj);
+			live += table.records.size();
+		}
+		m_needs_compaction = m_journal_records > 2 * live + journalSlack;
+	}
+
+	if (m_needs_compaction)
+	{
+		compactJournal();
+	}
+	else
+	{
+		appendJournal();
+	}
+}
+
+void HttpMetaCache::appendJournal()
+{
+	if (m_dirty.isEmpty())
+		return;
+
+	QByteArray data;
+	QDataStream out(&data, QIODevice::WriteOnly);
+	int records = 0;
+	for (auto &key : m_dirty)
+	{
+		auto iter = m_entries.constFind(key.first);
+		int row = iter == m_entries.constEnd() ? -1 : iter->find(key.second);
+		if (row != -1)
+		{
+			out << putRecord(key.first, key.second, iter->records[row]);
+		}
+		else
+		{
+			out << removeRecord(key.first, key.second);
+		}
+		records++;
+	}
+
+	QFile journal(m_journal_file);
+	if (!journal.open(QIODevice::WriteOnly | QIODevice::Append) || journal.write(data) != data.size())
+	{
+		qWarning() << "Failed to append to" << m_journal_file << ":" << journal.errorString();
+		// we don't know what made it to the disk. start over.
+		m_needs_compaction = true;
+		SaveEventually();
+		return;
+	}
+	m_journal_records += records;
+	m_dirty.clear();
+}
+
+void HttpMetaCache::compactJournal()
+{
+	QByteArray data;
+	QDataStream out(&data, QIODevice::WriteOnly);
+	out << journalMagic << journalVersion;
+	int records = 0;
+	for (auto iter = m_entries.constBegin(); iter != m_entries.constEnd(); iter++)
+	{
+		auto &table = *iter;
+		for (int row = 0; row < table.records.size(); row++)
+		{
+			out << putRecord(iter.key(), table.paths[row], table.records[row]);
+			records++;
 		}
 	}
-	toplevel.insert("entries", entriesArr);
 
-	QJsonDocument doc(toplevel);
 	try
 	{
-		FS::write(m_index_file, doc.toJson());
+		FS::write(m_journal_file, data);
 	}
 	catch (Exception & e)
 	{
 		qWarning() << e.what();
+		return;
 	}
+	m_journal_records = records;
+	m_needs_compaction = false;
+	m_dirty.clear();
 }
@@ -15,14 +15,22 @@
 
 #pragma once
 #include <QString>
-#include <QMap>
+#include <QHash>
+#include <QVector>
+#include <QSet>
+#include <QPair>
 #include <qtimer.h>
 #include <memory>
+#include <array>
 
 #include "multimc_logic_export.h"
 
 class HttpMetaCache;
 
+/*
+ * A handle to a cache entry, detached from the cache.
+ * Changes made to it are stored back by HttpMetaCache::updateEntry
+ */
 class MULTIMC_LOGIC_EXPORT MetaEntry
 {
 friend class HttpMetaCache;
@@ -79,6 +87,12 @@ protected:
 
 typedef std::shared_ptr<MetaEntry> MetaEntryPtr;
 
+/*
+ * The cache index is stored as an append-only journal of binary records next to the legacy JSON
+ * index file. Changes are appended as they happen and the journal is rewritten from scratch
+ * (compacted) once it holds too many dead records. The JSON index is only read when there is no
+ * journal yet.
+ */
 class MULTIMC_LOGIC_EXPORT HttpMetaCache : public QObject
 {
 	Q_OBJECT
@@ -95,6 +109,11 @@ public:
 	MetaEntryPtr resolveEntry(QString base, QString resource_path,
 							  QString expected_etag = QString());
 
+	// verify the entry just like resolveEntry does, but without creating a handle for it.
+	// returns true if the cached file can be used as is.
+	bool checkEntry(const QString &base, const QString &resource_path,
+					const QString &expected_etag = QString());
+
 	// add a previously resolved stale entry
 	bool updateEntry(MetaEntryPtr stale_entry);
 
@@ -112,14 +131,62 @@ slots:
 	void SaveNow();
 
 private:
-	// create a new stale entry, given the parameters
-	MetaEntryPtr staleEntry(QString base, QString resource_path);
-	struct EntryMap
+	/// one cached file. digests and timestamps are kept in their binary form
+	struct EntryRecord
+	{
+		QByteArray etag;
+		qint64 local_changed_timestamp = 0;
+		/// the Last-Modified header exactly as the server sent it, sent back in If-Modified-Since
+		QByteArray remote_changed_timestamp;
+		std::array<quint8, 16> md5;
+		bool has_md5 = false;
+	};
+	/// all the entries of one base, as flat arrays indexed by row
+	struct EntryTable
 	{
 		QString base_path;
-		QMap<QString, MetaEntryPtr> entry_list;
+		QHash<QString, int> rows;
+		QVector<QString> paths;
+		QVector<EntryRecord> records;
+
+		int find(const QString &path) const
+		{
+			return rows.value(path, -1);
+		}
+		int insert(const QString &path);
+		void remove(int row);
 	};
-	QMap<QString, EntryMap> m_entries;
+
+	// create a new stale entry, given the parameters
+	MetaEntryPtr staleEntry(QString base, QString resource_path);
+
+	// create a handle for a row of the table
+	MetaEntryPtr materialize(const QString &base, const EntryTable &table, int row);
+
+	// verify the entry and return its row, or -1 if it's not usable
+	int resolveRow(const QString &base, const QString &resource_path,
+				   const QString &expected_etag);
+
+	// remember that an entry has to be written into the journal
+	void markDirty(const QString &base, const QString &resource_path);
+
+	bool loadJournal();
+	void loadJson();
+	void readRecord(const QByteArray &record);
+	QByteArray putRecord(const QString &base, const QString &resource_path, const EntryRecord &entry);
+	QByteArray removeRecord(const QString &base, const QString &resource_path);
+	void appendJournal();
+	void compactJournal();
+
+	QHash<QString, EntryTable> m_entries;
 	QString m_index_file;
+	QString m_journal_file;
 	QTimer saveBatchingTimer;
+
+	/// (base, path) of entries changed since the last save
+	QSet<QPair<QString, QString>> m_dirty;
+	/// number of records in the journal file, live or not
+	int m_journal_records = 0;
+	/// the journal has to be rewritten on the next save
+	bool m_needs_compaction = true;
 };
@@ -0,0 +1,229 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include "TestUtil.h"
+
+#include "net/HttpMetaCache.h"
+#include <FileSystem.h>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace
+{
+/// resident memory of the test process in bytes, if we know how to get it
+qint64 residentMemory()
+{
+#ifdef Q_OS_LINUX
+	QFile statm("/proc/self/statm");
+	if (statm.open(QIODevice::ReadOnly))
+	{
+		auto fields = statm.readAll().split(' ');
+		if (fields.size() > 1)
+		{
+			return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+		}
+	}
+#endif
+	return 0;
+}
+}
+
+class HttpMetaCacheTest : public QObject
+{
+	Q_OBJECT
+private:
+	QString entryPath(int i)
+	{
+		return QString("%1/%2").arg(i % 256, 2, 16, QChar('0')).arg(i);
+	}
+	void fill(HttpMetaCache &cache, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			auto entry = cache.resolveEntry("objects", entryPath(i));
+			entry->setMD5Sum(QString("%1").arg(i, 32, 16, QChar('0')));
+			entry->setETag(QString("\"%1\"").arg(i));
+			entry->setLocalChangedTimestamp(1400000000000LL + i);
+			entry->setRemoteChangedTimestamp("Tue, 15 Nov 1994 08:12:31 GMT");
+			entry->setStale(false);
+			cache.updateEntry(entry);
+		}
+	}
+
+private
+slots:
+	void test_JournalRoundTrip()
+	{
+		QTemporaryDir dir;
+		QString index = FS::PathCombine(dir.path(), "metacache");
+		{
+			HttpMetaCache cache(index);
+			cache.addBase("objects", FS::PathCombine(dir.path(), "objects"));
+			cache.Load();
+			fill(cache, 100);
+			cache.SaveNow();
+		}
+		QVERIFY(QFile::exists(index + ".journal"));
+		HttpMetaCache cache(index);
+		cache.addBase("objects", FS::PathCombine(dir.path(), "objects"));
+		cache.Load();
+		auto entry = cache.getEntry("objects", "2a/42");
+		QVERIFY(entry != nullptr);
+		QCOMPARE(entry->getMD5Sum(), QString("%1").arg(42, 32, 16, QChar('0')));
+		QCOMPARE(entry->getETag(), QString("\"42\""));
+		QCOMPARE(entry->getRemoteChangedTimestamp(), QString("Tue, 15 Nov 1994 08:12:31 GMT"));
+		QVERIFY(!entry->isStale());
+	}
+
+	void test_RemoteTimestampVerbatim()
+	{
+		QTemporaryDir dir;
+		QString index = FS::PathCombine(dir.path(), "metacache");
+		// RFC 850 and asctime dates are allowed by HTTP/1.1 and must be sent back untouched
+		QStringList dates = {"Sunday, 06-Nov-94 08:49:37 GMT", "Sun Nov  6 08:49:37 1994", "garbage"};
+		{
+			HttpMetaCache cache(index);
+			cache.addBase("objects", FS::PathCombine(dir.path(), "objects"));
+			cache.Load();
+			for (int i = 0; i < dates.size(); i++)
+			{
+				auto entry = cache.resolveEntry("objects", entryPath(i));
+				entry->setRemoteChangedTimestamp(dates[i]);
+				entry->setStale(false);
+				cache.updateEntry(entry);
+			}
+			cache.SaveNow();
+		}
+		HttpMetaCache cache(index);
+		cache.addBase("objects", FS::PathCombine(dir.path(), "objects"));
+		cache.Load();
+		for (int i = 0; i < dates.size(); i++)
+		{
+			auto entry = cache.getEntry("objects", entryPath(i));
+			QVERIFY(entry != nullptr);
+			QCOMPARE(entry->getRemoteChangedTimestamp(), dates[i]);
+		}
+	}
+
+	void test_AppendOnlyDelta()
+	{
+		QTemporaryDir dir;
+		QString index = FS::PathCombine(dir.path(), "metacache");
+		QString journal = index + ".journal";
+		{
+			HttpMetaCache cache(index);
+			cache.addBase("objects", FS::PathCombine(dir.path(), "objects"));
+			cache.Load();
+			fill(cache, 1000);
+			cache.SaveNow();
+		}
+		qint64 fullSize = QFileInfo(journal).size();
+		{
+			HttpMetaCache cache(index);
+			cache.addBase("objects", FS::PathCombine(dir.path(), "objects"));
+			cache.Load();
+			auto entry = cache.getEntry("objects", "01/1");
+			QVERIFY(entry != nullptr);
+			entry->setETag("\"changed\"");
+			cache.updateEntry(entry);
+			cache.evictEntry(cache.getEntry("objects", "02/2"));
+			cache.SaveNow();
+		}
+		qint64 deltaSize = QFileInfo(journal).size() - fullSize;
+		QVERIFY(deltaSize > 0);
+		QVERIFY(deltaSize < fullSize / 100);
+
+		HttpMetaCache cache(index);
+		cache.addBase("objects", FS::PathCombine(dir.path(), "objects"));
+		cache.Load();
+		QCOMPARE(cache.getEntry("objects", "01/1")->getETag(), QString("\"changed\""));
+		QVERIFY(cache.getEntry("objects", "02/2") == nullptr);
+		QVERIFY(cache.getEntry("objects", "03/3") != nullptr);
+	}
+
+	void test_JsonImport()
+	{
+		QTemporaryDir dir;
+		QString index = FS::PathCombine(dir.path(), "metacache");
+		FS::write(index, "{\"version\": \"1\", \"entries\": [{\"base\": \"objects\", \"path\": \"a/b\", "
+						 "\"md5sum\": \"d41d8cd98f00b204e9800998ecf8427e\", \"etag\": \"\\\"x\\\"\", "
+						 "\"last_changed_timestamp\": 1400000000000}]}");
+		{
+			HttpMetaCache cache(index);
+			cache.addBase("objects", FS::PathCombine(dir.path(), "objects"));
+			cache.Load();
+			auto entry = cache.getEntry("objects", "a/b");
+			QVERIFY(entry != nullptr);
+			QCOMPARE(entry->getMD5Sum(), QString("d41d8cd98f00b204e9800998ecf8427e"));
+		}
+		// the JSON file is not needed anymore once there is a journal
+		QVERIFY(QFile::remove(index));
+		HttpMetaCache cache(index);
+		cache.addBase("objects", FS::PathCombine(dir.path(), "objects"));
+		cache.Load();
+		auto entry = cache.getEntry("objects", "a/b");
+		QVERIFY(entry != nullptr);
+		QCOMPARE(entry->getETag(), QString("\"x\""));
+	}
+
+	void test_Lookup50k()
+	{
+		QTemporaryDir dir;
+		HttpMetaCache cache;
+		cache.addBase("objects", FS::PathCombine(dir.path(), "objects"));
+		qint64 before = residentMemory();
+		fill(cache, 50000);
+		qint64 after = residentMemory();
+		if (before && after)
+		{
+			qDebug() << "50000 entries take about" << (after - before) / 1024 << "KiB";
+		}
+		QStringList paths;
+		for (int i = 0; i < 50000; i++)
+		{
+			paths.append(entryPath(i));
+		}
+		QBENCHMARK
+		{
+			for (auto &path : paths)
+			{
+				cache.getEntry("objects", path);
+			}
+		}
+	}
+
+	void test_Benchmark50k()
+	{
+		QTemporaryDir dir;
+		QString index = FS::PathCombine(dir.path(), "metacache");
+		QElapsedTimer timer;
+		{
+			HttpMetaCache cache(index);
+			cache.addBase("objects", FS::PathCombine(dir.path(), "objects"));
+			cache.Load();
+			fill(cache, 50000);
+			timer.start();
+			cache.SaveNow();
+			qDebug() << "Full save of 50000 entries:" << timer.elapsed() << "ms";
+
+			auto entry = cache.getEntry("objects", "00/0");
+			entry->setETag("\"changed\"");
+			cache.updateEntry(entry);
+			timer.start();
+			cache.SaveNow();
+			qDebug() << "Saving one changed entry:" << timer.elapsed() << "ms";
+		}
+		QBENCHMARK
+		{
+			HttpMetaCache cache(index);
+			cache.addBase("objects", FS::PathCombine(dir.path(), "objects"));
+			cache.Load();
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN(HttpMetaCacheTest)
+
+#include "HttpMetaCache_test.moc"
@@ -16,10 +16,11 @@
 #include "Env.h"
 #include "MD5EtagDownload.h"
 #include <FileSystem.h>
-#include <QCryptographicHash>
+#include "FileHashCache.h"
 #include <QDebug>
 
-MD5EtagDownload::MD5EtagDownload(QUrl url, QString target_path) : NetAction()
+MD5EtagDownload::MD5EtagDownload(QUrl url, QString target_path)
+	: NetAction(), m_sha1sum(QCryptographicHash::Sha1)
 {
 	m_url = url;
 	m_target_path = target_path;
@@ -28,17 +29,32 @@ MD5EtagDownload::MD5EtagDownload(QUrl url, QString target_path) : NetAction()
 
 void MD5EtagDownload::start()
 {
-	QString filename = m_target_path;
-	m_output_file.setFileName(filename);
-	// if there already is a file and md5 checking is in effect and it can be opened
-	if (m_output_file.exists() && m_output_file.open(QIODevice::ReadOnly))
+	m_status = Job_InProgress;
+	// if there already is a file, get its md5 first. This can take a while, so it's not done here.
+	if (QFile::exists(m_target_path))
 	{
-		// get the md5 of the local file.
-		m_local_md5 =
-			QCryptographicHash::hash(m_output_file.readAll(), QCryptographicHash::Md5)
-				.toHex()
-				.constData();
-		m_output_file.close();
+		connect(&m_local_hash, SIGNAL(finished()), SLOT(localFileHashed()), Qt::UniqueConnection);
+		m_local_hash.setFuture(ENV.fileHashes()->hashAsync(m_target_path));
+		return;
+	}
+	startDownload();
+}
+
+void MD5EtagDownload::abort()
+{
+	// the hashing can't be interrupted, but nothing may start after it is done
+	disconnect(&m_local_hash, SIGNAL(finished()), this, SLOT(localFileHashed()));
+	m_local_hash.cancel();
+	m_status = Job_Failed;
+	NetAction::abort();
+}
+
+void MD5EtagDownload::localFileHashed()
+{
+	auto hashes = m_local_hash.result();
+	if (hashes.isValid())
+	{
+		m_local_md5 = hashes.md5.toHex().constData();
 		// if we are expecting some md5sum, compare it with the local one
 		if (!m_expected_md5.isEmpty())
 		{
@@ -46,6 +62,7 @@ void MD5EtagDownload::start()
 			if(m_local_md5 == m_expected_md5)
 			{
 				qDebug() << "Skipping " << m_url.toString() << ": md5 match.";
+				m_status = Job_Finished;
 				emit succeeded(m_index_within_job);
 				return;
 			}
@@ -55,8 +72,15 @@ void MD5EtagDownload::start()
 			// no expected md5. we use the local md5sum as an ETag
 		}
 	}
+	startDownload();
+}
+
+void MD5EtagDownload::startDownload()
+{
+	QString filename = m_target_path;
 	if (!FS::ensureFilePathExists(filename))
 	{
+		m_status = Job_Failed;
 		emit failed(m_index_within_job);
 		return;
 	}
@@ -71,14 +95,17 @@ void MD5EtagDownload::start()
 	}
 	if(!m_expected_md5.isEmpty())
 		qDebug() << "Expecting " << m_expected_md5;
+	m_sha1sum.reset();
 
 	request.setHeader(QNetworkRequest::UserAgentHeader, "MultiMC/5.0 (Uncached)");
 
 	// Go ahead and try to open the file.
 	// If we don't do this, empty files won't be created, which breaks the updater.
 	// Plus, this way, we don't end up starting a download for a file we can't open.
-	if (!m_output_file.open(QIODevice::WriteOnly))
+	m_output_file.reset(new QSaveFile(filename));
+	if (!m_output_file->open(QIODevice::WriteOnly))
 	{
+		m_status = Job_Failed;
 		emit failed(m_index_within_job);
 		return;
 	}
@@ -111,12 +138,45 @@ void MD5EtagDownload::downloadError(QNetworkReply::NetworkError error)
 
 void MD5EtagDownload::downloadFinished()
 {
+	// the local file is fine as it is. keep it.
+	if (m_status != Job_Failed &&
+		m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304)
+	{
+		m_status = Job_Finished;
+		m_output_file->cancelWriting();
+		m_output_file.reset();
+		m_reply.reset();
+		emit succeeded(m_index_within_job);
+		return;
+	}
+
+	// check the data before it replaces anything
+	if (m_status != Job_Failed && !m_expected_sha1.isEmpty())
+	{
+		auto sha1 = QString::fromLatin1(m_sha1sum.result().toHex());
+		if (sha1.compare(m_expected_sha1, Qt::CaseInsensitive) != 0)
+		{
+			qCritical() << "SHA-1 mismatch for" << m_url.toString() << ": expected" << m_expected_sha1
+						<< "got" << sha1;
+			m_status = Job_Failed;
+		}
+	}
+
 	// if the download succeeded
 	if (m_status != Job_Failed)
 	{
+		if (!m_output_file->commit())
+		{
+			qCritical() << "Failed to commit changes to " << m_target_path;
+			m_output_file.reset();
+			m_reply.reset();
+			m_status = Job_Failed;
+			emit failed(m_index_within_job);
+			return;
+		}
 		// nothing went wrong...
 		m_status = Job_Finished;
-		m_output_file.close();
+		m_output_file.reset();
 
 		// FIXME: compare with the real written data md5sum
 		// this is just an ETag
@@ -129,8 +189,8 @@ void MD5EtagDownload::downloadFinished()
 	// else the download failed
 	else
 	{
-		m_output_file.close();
-		m_output_file.remove();
+		m_output_file->cancelWriting();
+		m_output_file.reset();
 		m_reply.reset();
 		emit failed(m_index_within_job);
 		return;
@@ -139,17 +199,17 @@ void MD5EtagDownload::downloadFinished()
 
 void MD5EtagDownload::downloadReadyRead()
 {
-	if (!m_output_file.isOpen())
+	if (m_status == Job_Failed)
 	{
-		if (!m_output_file.open(QIODevice::WriteOnly))
-		{
-			/*
-			* Can't open the file... the job failed
-			*/
-			m_reply->abort();
-			emit failed(m_index_within_job);
-			return;
-		}
+		return;
+	}
+	QByteArray ba = m_reply->readAll();
+	m_sha1sum.addData(ba);
+	if (m_output_file->write(ba) != ba.size())
+	{
+		qCritical() << "Failed writing into " + m_target_path;
+		// the failure is reported when the reply finishes
+		m_status = Job_Failed;
+		m_reply->abort();
 	}
-	m_output_file.write(m_reply->readAll());
 }
@@ -16,7 +16,10 @@
 #pragma once
 
 #include "NetAction.h"
-#include <QFile>
+#include <QSaveFile>
+#include <QCryptographicHash>
+#include <QFutureWatcher>
+#include "FileHashCache.h"
 
 typedef std::shared_ptr<class MD5EtagDownload> Md5EtagDownloadPtr;
 class MD5EtagDownload : public NetAction
@@ -25,12 +28,18 @@ class MD5EtagDownload : public NetAction
 public:
 	/// the expected md5 checksum. Only set from outside
 	QString m_expected_md5;
+	/// the expected sha1 checksum, if known. Downloaded data that doesn't match is thrown away.
+	QString m_expected_sha1;
 	/// the md5 checksum of a file that already exists.
 	QString m_local_md5;
 	/// if saving to file, use the one specified in this string
 	QString m_target_path;
 	/// this is the output file, if any
-	QFile m_output_file;
+	std::unique_ptr<QSaveFile> m_output_file;
+	/// the hash-as-you-download
+	QCryptographicHash m_sha1sum;
+	/// hashes the existing local file off the GUI thread
+	QFutureWatcher<FileHashes> m_local_hash;
 
 public:
 	explicit MD5EtagDownload(QUrl url, QString target_path);
@@ -45,8 +54,13 @@ slots:
 	virtual void downloadError(QNetworkReply::NetworkError error);
 	virtual void downloadFinished();
 	virtual void downloadReadyRead();
+	void localFileHashed();
+
+private:
+	void startDownload();
 
 public
 slots:
 	virtual void start();
+	virtual void abort();
 };
@@ -31,6 +31,16 @@ enum JobStatus
 	Job_Failed
 };
 
+/// How important a download is for getting the user where they want to be
+enum NetActionPriority
+{
+	/// nice to have, can wait for everything else
+	Priority_Low,
+	Priority_Normal,
+	/// the user is waiting on this one (game jars, libraries...)
+	Priority_High
+};
+
 typedef std::shared_ptr<class NetAction> NetActionPtr;
 class MULTIMC_LOGIC_EXPORT NetAction : public QObject
 {
@@ -54,6 +64,27 @@ public:
 	{
 		return m_failures;
 	}
+	NetActionPriority priority() const
+	{
+		return m_priority;
+	}
+	void setPriority(NetActionPriority priority)
+	{
+		m_priority = priority;
+	}
+	/// expected size of the download in bytes, 0 if not known
+	qint64 sizeHint() const
+	{
+		return m_size_hint;
+	}
+	void setSizeHint(qint64 size)
+	{
+		m_size_hint = size;
+		if (size > 0)
+		{
+			m_total_progress = size;
+		}
+	}
 
 public:
 	/// the network reply
@@ -74,6 +105,10 @@ public:
 	qint64 m_progress = 0;
 	qint64 m_total_progress = 1;
 
+	/// scheduling hints for the parent job
+	NetActionPriority m_priority = Priority_Normal;
+	qint64 m_size_hint = 0;
+
 	/// number of failures up to this point
 	int m_failures = 0;
 
@@ -93,4 +128,12 @@ slots:
 public
 slots:
 	virtual void start() = 0;
+	/// stop whatever is still going on. The owning job stops listening before it calls this.
+	virtual void abort()
+	{
+		if (m_reply)
+		{
+			m_reply->abort();
+		}
+	}
 };
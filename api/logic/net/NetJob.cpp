@@ -17,8 +17,20 @@
 #include "MD5EtagDownload.h"
 #include "ByteArrayDownload.h"
 #include "CacheDownload.h"
+#include "NetScheduler.h"
+#include "Env.h"
 
 #include <QDebug>
+#include <algorithm>
+
+NetJob::~NetJob()
+{
+	// anything we still have waiting in the scheduler is of no use to anyone now
+	if (auto scheduler = ENV.netScheduler())
+	{
+		scheduler->cancel(this);
+	}
+}
 
 void NetJob::partSucceeded(int index)
 {
@@ -57,9 +69,13 @@ void NetJob::partProgress(int index, qint64 bytesReceived, qint64 bytesTotal)
 	slot.current_progress = bytesReceived;
 	current_progress += slot.current_progress;
 
-	total_progress -= slot.total_progress;
-	slot.total_progress = bytesTotal;
-	total_progress += slot.total_progress;
+	// unknown totals keep the size hint we started with
+	if (bytesTotal > 0)
+	{
+		total_progress -= slot.total_progress;
+		slot.total_progress = bytesTotal;
+		total_progress += slot.total_progress;
+	}
 	setProgress(current_progress, total_progress);
 }
 
@@ -67,39 +83,57 @@ void NetJob::executeTask()
 {
 	qDebug() << m_job_name.toLocal8Bit() << " started.";
 	m_running = true;
-	for (int i = 0; i < downloads.size(); i++)
+	for (auto index: scheduleOrder(downloads))
 	{
-		m_todo.enqueue(i);
+		m_todo.enqueue(index);
 	}
 	// hack that delays early failures so they can be caught easier
 	QMetaObject::invokeMethod(this, "startMoreParts", Qt::QueuedConnection);
 }
 
+bool NetJob::abort()
+{
+	if (!m_running)
+	{
+		return false;
+	}
+	m_running = false;
+	// nothing that is still waiting for a connection gets one. the scheduler is gone after shutdown.
+	if (auto scheduler = ENV.netScheduler())
+	{
+		scheduler->cancel(this);
+	}
+	m_todo.clear();
+	for (auto index : m_doing)
+	{
+		auto part = downloads[index];
+		part->disconnect(this);
+		part->abort();
+	}
+	m_doing.clear();
+	qWarning() << m_job_name << "aborted.";
+	emitFailed(tr("Job '%1' aborted.").arg(m_job_name));
+	return true;
+}
+
 void NetJob::startMoreParts()
 {
-	// check for final conditions if there's nothing in the queue
-	if(!m_todo.size())
+	// an aborted job doesn't start anything and doesn't finish twice
+	if (!m_running)
 	{
-		if(!m_doing.size())
-		{
-			if(!m_failed.size())
-			{
-				qDebug() << m_job_name << "succeeded.";
-				emitSucceeded();
-			}
-			else
-			{
-				qCritical() << m_job_name << "failed.";
-				emitFailed(tr("Job '%1' failed to process:\n%2").arg(m_job_name).arg(getFailedFiles().join("\n")));
-			}
-		}
 		return;
 	}
-	// otherwise try to start more parts
-	while (m_doing.size() < 6)
+	// hand everything we have over to the global scheduler. It decides when things actually start.
+	auto scheduler = ENV.netScheduler();
+	// a retry or a late start after shutdown has nothing to run on
+	if (!scheduler)
+	{
+		qWarning() << m_job_name << "has no network scheduler, the environment was already destroyed.";
+		abort();
+		return;
+	}
+	while (m_todo.size())
 	{
-		if(!m_todo.size())
-			return;
 		int doThis = m_todo.dequeue();
 		m_doing.insert(doThis);
 		auto part = downloads[doThis];
@@ -108,7 +142,22 @@ void NetJob::startMoreParts()
 		connect(part.get(), SIGNAL(failed(int)), SLOT(partFailed(int)));
 		connect(part.get(), SIGNAL(netActionProgress(int, qint64, qint64)),
 				SLOT(partProgress(int, qint64, qint64)));
-		part->start();
+		scheduler->enqueue(this, part);
+	}
+	// check for final conditions if there's nothing queued or running
+	if(!m_doing.size())
+	{
+		m_running = false;
+		if(!m_failed.size())
+		{
+			qDebug() << m_job_name << "succeeded.";
+			emitSucceeded();
+		}
+		else
+		{
+			qCritical() << m_job_name << "failed.";
+			emitFailed(tr("Job '%1' failed to process:\n%2").arg(m_job_name).arg(getFailedFiles().join("\n")));
+		}
 	}
 }
 
@@ -123,3 +172,37 @@ QStringList NetJob::getFailedFiles()
 	failed.sort();
 	return failed;
 }
+
+QList<int> NetJob::scheduleOrder(const QList<NetActionPtr> &actions)
+{
+	// how many small files go between two large ones
+	static const int smallFilesBatch = 4;
+
+	QList<int> order;
+	for (int priority = Priority_High; priority >= Priority_Low; priority--)
+	{
+		QList<int> bucket;
+		for (int i = 0; i < actions.size(); i++)
+		{
+			if (actions[i]->priority() == priority)
+			{
+				bucket.append(i);
+			}
+		}
+		std::stable_sort(bucket.begin(), bucket.end(), [&](int a, int b)
+		{
+			return actions[a]->sizeHint() > actions[b]->sizeHint();
+		});
+		int front = 0;
+		int back = bucket.size() - 1;
+		while (front <= back)
+		{
+			order.append(bucket[front++]);
+			for (int i = 0; i < smallFilesBatch && front <= back; i++)
+			{
+				order.append(bucket[back--]);
+			}
+		}
+	}
+	return order;
+}
@@ -33,7 +33,7 @@ class MULTIMC_LOGIC_EXPORT NetJob : public Task
 	Q_OBJECT
 public:
 	explicit NetJob(QString job_name) : Task(), m_job_name(job_name) {}
-	virtual ~NetJob() {}
+	virtual ~NetJob();
 	bool addNetAction(NetActionPtr action)
 	{
 		action->m_index_within_job = downloads.size();
@@ -41,20 +41,17 @@ public:
 		part_info pi;
 		{
 			pi.current_progress = action->currentProgress();
-			pi.total_progress = action->totalProgress();
+			pi.total_progress = qMax<qint64>(1, action->totalProgress());
 			pi.failures = action->numberOfFailures();
 		}
 		parts_progress.append(pi);
 		total_progress += pi.total_progress;
-		// if this is already running, the action needs to be started right away!
+		// if this is already running, the action needs to be queued right away!
 		if (isRunning())
 		{
 			setProgress(current_progress, total_progress);
-			connect(action.get(), SIGNAL(succeeded(int)), SLOT(partSucceeded(int)));
-			connect(action.get(), SIGNAL(failed(int)), SLOT(partFailed(int)));
-			connect(action.get(), SIGNAL(netActionProgress(int, qint64, qint64)),
-					SLOT(partProgress(int, qint64, qint64)));
-			action->start();
+			m_todo.enqueue(action->m_index_within_job);
+			startMoreParts();
 		}
 		return true;
 	}
@@ -83,13 +80,20 @@ public:
 	}
 	QStringList getFailedFiles();
 
+	/*!
+	 * Order in which the actions should be started.
+	 * Higher priorities go first. Within a priority, the largest files are started early and
+	 * batches of small files are interleaved between them, so the big downloads aren't stuck
+	 * at the end of the queue and the small ones keep the remaining connections busy.
+	 */
+	static QList<int> scheduleOrder(const QList<NetActionPtr> &actions);
+
 private slots:
 	void startMoreParts();
 
 public slots:
 	virtual void executeTask();
-	// FIXME: implement
-	virtual bool abort() {return false;};
+	virtual bool abort();
 
 private slots:
 	void partProgress(int index, qint64 bytesReceived, qint64 bytesTotal);
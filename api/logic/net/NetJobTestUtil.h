@@ -0,0 +1,38 @@
+#pragma once
+
+#include "net/NetJob.h"
+#include "net/ByteArrayDownload.h"
+
+#include <random>
+
+class NetJobTestUtil
+{
+public:
+	static NetActionPtr makeAction(int index, qint64 size, NetActionPriority priority)
+	{
+		auto action = ByteArrayDownload::make(QUrl(QString("http://example.com/%1").arg(index)));
+		action->setSizeHint(size);
+		action->setPriority(priority);
+		return action;
+	}
+
+	/// 3000 small asset objects, followed by the game jar and a bunch of libraries.
+	static QList<NetActionPtr> syntheticIndex()
+	{
+		QList<NetActionPtr> actions;
+		std::mt19937 eng(1337);
+		std::uniform_int_distribution<qint64> assetSize(500, 20 * 1024);
+		std::uniform_int_distribution<qint64> librarySize(50 * 1024, 2 * 1024 * 1024);
+		int index = 0;
+		for (int i = 0; i < 3000; i++)
+		{
+			actions.append(makeAction(index++, assetSize(eng), Priority_Normal));
+		}
+		actions.append(makeAction(index++, 5 * 1024 * 1024, Priority_High));
+		for (int i = 0; i < 30; i++)
+		{
+			actions.append(makeAction(index++, librarySize(eng), Priority_High));
+		}
+		return actions;
+	}
+};
@@ -0,0 +1,24 @@
+#include <QTest>
+#include "TestUtil.h"
+
+#include "net/NetJob.h"
+#include "net/NetJobTestUtil.h"
+
+class NetJobBenchmark : public QObject, private NetJobTestUtil
+{
+	Q_OBJECT
+private
+slots:
+	void benchmark_scheduleOrder()
+	{
+		auto actions = syntheticIndex();
+		QBENCHMARK
+		{
+			NetJob::scheduleOrder(actions);
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN(NetJobBenchmark)
+
+#include "NetJob_benchmark.moc"
@@ -0,0 +1,172 @@
+#include <QTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include "TestUtil.h"
+
+#include "net/NetJob.h"
+#include "net/ByteArrayDownload.h"
+#include "net/MD5EtagDownload.h"
+#include "net/NetJobTestUtil.h"
+#include "Env.h"
+#include "FileSystem.h"
+
+#include <algorithm>
+
+namespace
+{
+// connections available to one job
+const int connections = 6;
+// per request overhead, in ms
+const double latency = 50.0;
+// bytes per ms, per connection
+const double bandwidth = 1024.0;
+
+struct SimulationResult
+{
+	/// when all the high priority files were done
+	double ready = 0;
+	/// when everything was done
+	double makespan = 0;
+};
+
+/// Simulate running the actions in the given order over a fixed number of connections.
+SimulationResult simulate(const QList<NetActionPtr> &actions, const QList<int> &order)
+{
+	SimulationResult result;
+	std::vector<double> freeAt(connections, 0.0);
+	for (auto index : order)
+	{
+		auto slot = std::min_element(freeAt.begin(), freeAt.end());
+		double finished = *slot + latency + actions[index]->sizeHint() / bandwidth;
+		*slot = finished;
+		if (actions[index]->priority() == Priority_High)
+		{
+			result.ready = std::max(result.ready, finished);
+		}
+		result.makespan = std::max(result.makespan, finished);
+	}
+	return result;
+}
+}
+
+class NetJobTest : public QObject, private NetJobTestUtil
+{
+	Q_OBJECT
+private
+slots:
+	void test_scheduleOrder_isPermutation()
+	{
+		auto actions = syntheticIndex();
+		auto order = NetJob::scheduleOrder(actions);
+		QCOMPARE(order.size(), actions.size());
+		auto sorted = order;
+		std::sort(sorted.begin(), sorted.end());
+		for (int i = 0; i < sorted.size(); i++)
+		{
+			QCOMPARE(sorted[i], i);
+		}
+	}
+
+	void test_scheduleOrder_priorityFirst()
+	{
+		auto actions = syntheticIndex();
+		auto order = NetJob::scheduleOrder(actions);
+		bool seenNormal = false;
+		for (auto index : order)
+		{
+			if (actions[index]->priority() == Priority_Normal)
+			{
+				seenNormal = true;
+			}
+			else
+			{
+				QVERIFY(!seenNormal);
+			}
+		}
+	}
+
+	void test_scheduleOrder_vsFifo()
+	{
+		auto actions = syntheticIndex();
+		QList<int> fifo;
+		for (int i = 0; i < actions.size(); i++)
+		{
+			fifo.append(i);
+		}
+		auto fifoResult = simulate(actions, fifo);
+		auto orderedResult = simulate(actions, NetJob::scheduleOrder(actions));
+		qDebug() << "FIFO: ready after" << fifoResult.ready << "ms, done after"
+				 << fifoResult.makespan << "ms";
+		qDebug() << "Scheduled: ready after" << orderedResult.ready << "ms, done after"
+				 << orderedResult.makespan << "ms";
+		QVERIFY(orderedResult.ready < fifoResult.ready);
+		QVERIFY(orderedResult.makespan <= fifoResult.makespan);
+	}
+
+	void test_abort()
+	{
+		NetJobPtr job(new NetJob("test"));
+		for (int i = 0; i < 3; i++)
+		{
+			job->addNetAction(makeAction(i, 1000, Priority_Normal));
+		}
+		QSignalSpy failed(job.get(), SIGNAL(failed(QString)));
+		QSignalSpy succeeded(job.get(), SIGNAL(succeeded()));
+		QVERIFY(!job->abort());
+
+		job->start();
+		QVERIFY(job->abort());
+		QCOMPARE(failed.size(), 1);
+
+		// the downloads were about to be handed to the scheduler, that must not happen anymore
+		QTest::qWait(50);
+		QCOMPARE(failed.size(), 1);
+		QCOMPARE(succeeded.size(), 0);
+		for (int i = 0; i < job->size(); i++)
+		{
+			QVERIFY(!job->at(i)->m_reply);
+		}
+		QVERIFY(!job->abort());
+	}
+
+	void test_abortWhileHashing()
+	{
+		// big enough that hashing it takes a while
+		QTemporaryDir dir;
+		auto path = FS::PathCombine(dir.path(), "local.jar");
+		FS::write(path, QByteArray(64 * 1024 * 1024, 'x'));
+		auto part = MD5EtagDownload::make(QUrl("http://example.com/local.jar"), path);
+		NetJobPtr job(new NetJob("test"));
+		job->addNetAction(part);
+		QSignalSpy failed(job.get(), SIGNAL(failed(QString)));
+
+		job->start();
+		QTRY_VERIFY(part->m_status == Job_InProgress);
+		QVERIFY(!part->m_local_hash.isFinished());
+		QVERIFY(job->abort());
+
+		// the download that would follow the hashing never starts
+		QTRY_VERIFY(part->m_local_hash.isFinished());
+		QTest::qWait(50);
+		QVERIFY(!part->m_reply);
+		QVERIFY(part->m_status == Job_Failed);
+		QCOMPARE(failed.size(), 1);
+	}
+
+	// must stay last, the environment can't be brought back after this
+	void test_afterShutdown()
+	{
+		NetJobPtr job(new NetJob("test"));
+		job->addNetAction(makeAction(0, 1000, Priority_Normal));
+		QSignalSpy failed(job.get(), SIGNAL(failed(QString)));
+		job->start();
+		ENV.destroy();
+		QTRY_COMPARE(failed.size(), 1);
+		QVERIFY(!job->abort());
+		QVERIFY(!job->at(0)->m_reply);
+	}
+};
+
+QTEST_GUILESS_MAIN(NetJobTest)
+
+#include "NetJob_test.moc"
@@ -0,0 +1,166 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NetScheduler.h"
+
+#include <QDebug>
+
+NetScheduler::NetScheduler(QObject *parent) : QObject(parent)
+{
+}
+
+void NetScheduler::setLimits(int maxConnections, int maxConnectionsPerHost)
+{
+	m_maxConnections = qMax(1, maxConnections);
+	m_maxConnectionsPerHost = qMax(1, maxConnectionsPerHost);
+	qDebug() << "Download limits set to" << m_maxConnections << "connections," << m_maxConnectionsPerHost
+			 << "per host";
+	requestSchedule();
+}
+
+void NetScheduler::enqueue(QObject *owner, NetActionPtr action)
+{
+	if (!m_queues.contains(owner))
+	{
+		m_owners.append(owner);
+		connect(owner, SIGNAL(destroyed(QObject *)), SLOT(ownerDestroyed(QObject *)),
+				Qt::UniqueConnection);
+	}
+	auto &queue = m_queues[owner];
+	queue.byHost[action->m_url.host()].enqueue(action);
+	queue.count++;
+	m_queued++;
+	requestSchedule();
+}
+
+void NetScheduler::cancel(QObject *owner)
+{
+	auto iter = m_queues.find(owner);
+	if (iter == m_queues.end())
+	{
+		return;
+	}
+	m_queued -= iter->count;
+	m_queues.erase(iter);
+	m_owners.removeAll(owner);
+	disconnect(owner, SIGNAL(destroyed(QObject *)), this, SLOT(ownerDestroyed(QObject *)));
+	emit queueChanged(m_queued, m_running.size());
+}
+
+void NetScheduler::ownerDestroyed(QObject *owner)
+{
+	cancel(owner);
+}
+
+void NetScheduler::requestSchedule()
+{
+	// coalesce all the requests made during one event loop iteration into one pass
+	if (m_schedulePending)
+	{
+		return;
+	}
+	m_schedulePending = true;
+	QMetaObject::invokeMethod(this, "schedule", Qt::QueuedConnection);
+}
+
+void NetScheduler::schedule()
+{
+	m_schedulePending = false;
+	m_graveyard.clear();
+	if (m_scheduling)
+	{
+		return;
+	}
+	m_scheduling = true;
+	while (m_running.size() < m_maxConnections)
+	{
+		auto next = takeNext();
+		if (!next)
+		{
+			break;
+		}
+		startAction(next);
+	}
+	m_scheduling = false;
+	emit queueChanged(m_queued, m_running.size());
+}
+
+NetActionPtr NetScheduler::takeNext()
+{
+	// try every owner once, starting with the one that waited the longest
+	for (int i = 0; i < m_owners.size(); i++)
+	{
+		QObject *owner = m_owners[i];
+		auto &queue = m_queues[owner];
+		for (auto iter = queue.byHost.begin(); iter != queue.byHost.end(); iter++)
+		{
+			if (m_hostSlots.value(iter.key(), 0) >= m_maxConnectionsPerHost)
+			{
+				continue;
+			}
+			auto action = iter->dequeue();
+			if (iter->isEmpty())
+			{
+				queue.byHost.erase(iter);
+			}
+			queue.count--;
+			m_queued--;
+			// the owner goes to the back of the line
+			m_owners.removeAt(i);
+			if (queue.count)
+			{
+				m_owners.append(owner);
+			}
+			else
+			{
+				m_queues.remove(owner);
+				disconnect(owner, SIGNAL(destroyed(QObject *)), this,
+						   SLOT(ownerDestroyed(QObject *)));
+			}
+			return action;
+		}
+	}
+	return nullptr;
+}
+
+void NetScheduler::startAction(NetActionPtr action)
+{
+	QString host = action->m_url.host();
+	m_running[action.get()] = {action, host};
+	m_hostSlots[host]++;
+	connect(action.get(), SIGNAL(succeeded(int)), SLOT(actionFinished()));
+	connect(action.get(), SIGNAL(failed(int)), SLOT(actionFinished()));
+	action->start();
+}
+
+void NetScheduler::actionFinished()
+{
+	auto action = qobject_cast<NetAction *>(sender());
+	auto iter = m_running.find(action);
+	if (iter == m_running.end())
+	{
+		return;
+	}
+	disconnect(action, 0, this, 0);
+	auto &hostSlots = m_hostSlots[iter->host];
+	hostSlots--;
+	if (hostSlots <= 0)
+	{
+		m_hostSlots.remove(iter->host);
+	}
+	m_graveyard.append(iter->action);
+	m_running.erase(iter);
+	requestSchedule();
+}
@@ -0,0 +1,115 @@
+/* Copyright 2013-2015 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QMap>
+#include <QQueue>
+#include <QList>
+#include <memory>
+
+#include "NetAction.h"
+
+#include "multimc_logic_export.h"
+
+/*!
+ * Process-wide download scheduler.
+ *
+ * All NetJobs hand their actions over to this. It starts them while keeping the total number
+ * of connections and the number of connections per host under the configured limits.
+ * Owners (usually NetJobs) are served round-robin, so one huge job can't starve the others.
+ */
+class MULTIMC_LOGIC_EXPORT NetScheduler : public QObject
+{
+	Q_OBJECT
+public:
+	explicit NetScheduler(QObject *parent = 0);
+	virtual ~NetScheduler() {};
+
+	/// change the connection limits. Already running actions are not affected.
+	void setLimits(int maxConnections, int maxConnectionsPerHost);
+	int maxConnections() const
+	{
+		return m_maxConnections;
+	}
+	int maxConnectionsPerHost() const
+	{
+		return m_maxConnectionsPerHost;
+	}
+
+	/// queue an action on behalf of an owner. The action will be started when a slot is free.
+	void enqueue(QObject *owner, NetActionPtr action);
+
+	/// drop all the queued (not yet started) actions of an owner
+	void cancel(QObject *owner);
+
+	/// number of actions waiting for a free slot
+	int queueDepth() const
+	{
+		return m_queued;
+	}
+
+	/// number of actions currently running
+	int activeSlots() const
+	{
+		return m_running.size();
+	}
+
+	/// number of actions currently running against a host
+	int activeSlots(const QString &host) const
+	{
+		return m_hostSlots.value(host, 0);
+	}
+
+signals:
+	void queueChanged(int queued, int active);
+
+private slots:
+	void schedule();
+	void actionFinished();
+	void ownerDestroyed(QObject *owner);
+
+private:
+	NetActionPtr takeNext();
+	void startAction(NetActionPtr action);
+	void requestSchedule();
+
+private:
+	struct OwnerQueue
+	{
+		/// pending actions, split by host, each in the order they were queued
+		QMap<QString, QQueue<NetActionPtr>> byHost;
+		int count = 0;
+	};
+	struct RunningAction
+	{
+		NetActionPtr action;
+		QString host;
+	};
+	/// owners with pending actions, in round-robin order
+	QList<QObject *> m_owners;
+	QHash<QObject *, OwnerQueue> m_queues;
+	QHash<NetAction *, RunningAction> m_running;
+	QHash<QString, int> m_hostSlots;
+	/// finished actions are kept alive until the next scheduling pass, they may still be emitting
+	QList<NetActionPtr> m_graveyard;
+	int m_queued = 0;
+	int m_maxConnections = 16;
+	int m_maxConnectionsPerHost = 6;
+	bool m_scheduling = false;
+	bool m_schedulePending = false;
+};
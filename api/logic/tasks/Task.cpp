@@ -37,6 +37,13 @@ void Task::setProgress(qint64 current, qint64 total)
 	emit progress(m_progress, m_progressTotal);
 }
 
+void Task::setProgressFromThread(qint64 currentBytes, qint64 totalBytes)
+{
+	// progress is kept as int, so count in KiB
+	QMetaObject::invokeMethod(this, "setProgress", Qt::QueuedConnection, Q_ARG(qint64, currentBytes / 1024),
+							  Q_ARG(qint64, qMax<qint64>(1, totalBytes / 1024)));
+}
+
 void Task::start()
 {
 	m_running = true;
@@ -76,6 +76,9 @@ slots:
 protected:
 	virtual void executeTask() = 0;
 
+	/// setProgress() for byte counts, safe to call from any thread
+	void setProgressFromThread(qint64 currentBytes, qint64 totalBytes);
+
 protected slots:
 	virtual void emitSucceeded();
 	virtual void emitFailed(QString reason);
@@ -3,6 +3,8 @@
 #include <QDomDocument>
 #include <QFile>
 #include <FileSystem.h>
+#include "Env.h"
+#include "FileHashCache.h"
 
 namespace GoUpdate
 {
@@ -149,11 +151,7 @@ bool processFileLists
 
 		if(!needs_upgrade)
 		{
-			QCryptographicHash hash(QCryptographicHash::Md5);
-			auto foo = entryFile.readAll();
-
-			hash.addData(foo);
-			fileMD5 = hash.result().toHex();
+			fileMD5 = ENV.fileHashes()->hash(realEntryPath).md5.toHex();
 			if ((fileMD5 != entry.md5))
 			{
 				qDebug() << "MD5Sum does not match!";
@@ -48,13 +48,17 @@
 
 #include <BaseInstance.h>
 #include <Env.h>
+#include <ContentStore.h>
 #include <InstanceList.h>
-#include <MMCZip.h>
+#include <ExtractZipTask.h>
 #include <icons/IconList.h>
 #include <java/JavaUtils.h>
 #include <java/JavaInstallList.h>
 #include <launch/LaunchTask.h>
 #include <minecraft/MinecraftVersionList.h>
+#include <minecraft/MinecraftProfile.h>
+#include <minecraft/StoreVerifyTask.h>
+#include <minecraft/onesix/OneSixInstance.h>
 #include <minecraft/legacy/LwjglVersionList.h>
 #include <SkinUtils.h>
 #include <net/URLConstants.h>
@@ -96,6 +100,7 @@ public:
 	QAction *actionViewInstanceFolder;
 	QAction *actionRefresh;
 	QAction *actionViewCentralModsFolder;
+	QAction *actionVerifyStore;
 	QAction *actionCheckUpdate;
 	QAction *actionSettings;
 	QAction *actionReportBug;
@@ -147,6 +152,9 @@ public:
 		actionViewCentralModsFolder = new QAction(MainWindow);
 		actionViewCentralModsFolder->setObjectName(QStringLiteral("actionViewCentralModsFolder"));
 		actionViewCentralModsFolder->setIcon(MMC->getThemedIcon("centralmods"));
+		actionVerifyStore = new QAction(MainWindow);
+		actionVerifyStore->setObjectName(QStringLiteral("actionVerifyStore"));
+		actionVerifyStore->setIcon(MMC->getThemedIcon("status-good"));
 		if(BuildConfig.UPDATER_ENABLED)
 		{
 			actionCheckUpdate = new QAction(MainWindow);
@@ -256,6 +264,7 @@ public:
 		mainToolBar->addAction(actionViewInstanceFolder);
 		mainToolBar->addAction(actionViewCentralModsFolder);
 		mainToolBar->addAction(actionRefresh);
+		mainToolBar->addAction(actionVerifyStore);
 		mainToolBar->addSeparator();
 		if(BuildConfig.UPDATER_ENABLED)
 		{
@@ -307,6 +316,9 @@ public:
 		actionViewCentralModsFolder->setText(QApplication::translate("MainWindow", "View Central Mods Folder", 0));
 		actionViewCentralModsFolder->setToolTip(QApplication::translate("MainWindow", "Open the central mods folder in a file browser.", 0));
 		actionViewCentralModsFolder->setStatusTip(QApplication::translate("MainWindow", "Open the central mods folder in a file browser.", 0));
+		actionVerifyStore->setText(QApplication::translate("MainWindow", "Verify Game Files", 0));
+		actionVerifyStore->setToolTip(QApplication::translate("MainWindow", "Check the shared assets and libraries and download broken files again.", 0));
+		actionVerifyStore->setStatusTip(QApplication::translate("MainWindow", "Check the shared assets and libraries and download broken files again.", 0));
 		if(BuildConfig.UPDATER_ENABLED)
 		{
 			actionCheckUpdate->setText(QApplication::translate("MainWindow", "Check for Updates", 0));
@@ -1062,7 +1074,9 @@ InstancePtr MainWindow::instanceFromZipPack(QString instName, QString instGroup,
 	QTemporaryDir extractTmpDir;
 	QDir extractDir(extractTmpDir.path());
 	qDebug() << "Attempting to create instance from" << archivePath;
-	if (MMCZip::extractDir(archivePath, extractDir.absolutePath()).isEmpty())
+	ExtractZipTask extractTask(archivePath, extractDir.absolutePath());
+	ProgressDialog extractDialog(this);
+	if (extractDialog.execWithTask(&extractTask) != QDialog::Accepted)
 	{
 		CustomMessageBox::selectable(this, tr("Error"), tr("Failed to extract modpack"), QMessageBox::Warning)->show();
 		return nullptr;
@@ -1078,6 +1092,10 @@ InstancePtr MainWindow::instanceFromZipPack(QString instName, QString instGroup,
 		CustomMessageBox::selectable(this, tr("Error"), tr("Unable to copy instance"))->show();
 		return nullptr;
 	}
+	if (auto store = ENV.contentStore())
+	{
+		store->addInstance(instDir);
+	}
 
 	auto error = MMC->instances()->loadInstance(newInstance, instDir);
 	QString errorMsg = tr("Failed to load instance %1: ").arg(instDirName);
@@ -1388,6 +1406,39 @@ void MainWindow::on_actionRefresh_triggered()
 	MMC->instances()->loadList();
 }
 
+void MainWindow::on_actionVerifyStore_triggered()
+{
+	// gather the libraries of all the instances
+	QList<LibraryPtr> libraries;
+	auto instances = MMC->instances();
+	for (int i = 0; i < instances->count(); i++)
+	{
+		auto onesix = std::dynamic_pointer_cast<OneSixInstance>(instances->at(i));
+		if (!onesix)
+			continue;
+		auto profile = onesix->getMinecraftProfile();
+		if (!profile)
+			continue;
+		if (profile->getLibraries().isEmpty())
+		{
+			onesix->reloadProfile();
+		}
+		libraries.append(profile->getLibraries());
+	}
+	StoreVerifyTask task(libraries);
+	ProgressDialog verifyDialog(this);
+	verifyDialog.execWithTask(&task);
+	if (task.successful())
+	{
+		CustomMessageBox::selectable(this, tr("Verification finished"), task.getStatus(),
+									 QMessageBox::Information)->show();
+	}
+	else
+	{
+		CustomMessageBox::selectable(this, tr("Error"), task.failReason(), QMessageBox::Warning)->show();
+	}
+}
+
 void MainWindow::on_actionViewCentralModsFolder_triggered()
 {
 	DesktopServices::openDirectory(MMC->settings()->get("CentralModsDir").toString(), true);
@@ -81,6 +81,8 @@ private slots:
 
 	void on_actionViewCentralModsFolder_triggered();
 
+	void on_actionVerifyStore_triggered();
+
 	void on_actionCheckUpdate_triggered();
 
 	void on_actionSettings_triggered();
@@ -31,6 +31,7 @@
 #include "net/HttpMetaCache.h"
 #include "net/URLConstants.h"
 #include "Env.h"
+#include "ContentStore.h"
 
 #include "java/JavaUtils.h"
 
@@ -231,6 +232,12 @@ MultiMC::MultiMC(int &argc, char **argv, bool test_mode) : QApplication(argc, ar
 	// init the http meta cache
 	ENV.initHttpMetaCache();
 
+	if (m_settings->get("UseContentStore").toBool())
+	{
+		ENV.initContentStore(QDir("store").absolutePath());
+		ENV.contentStore()->collectGarbageAsync();
+	}
+
 	// create the global network manager
 	ENV.m_qnam.reset(new QNetworkAccessManager(this));
 
@@ -244,6 +251,10 @@ MultiMC::MultiMC(int &argc, char **argv, bool test_mode) : QApplication(argc, ar
 		ENV.updateProxySettings(proxyTypeStr, addr, port, user, pass);
 	}
 
+	// init download limits
+	ENV.updateNetworkLimits(settings()->get("MaxConcurrentDownloads").toInt(),
+							settings()->get("MaxConcurrentDownloadsPerHost").toInt());
+
 	initSSL();
 
 	m_translationChecker->downloadTranslations();
@@ -446,6 +457,9 @@ void MultiMC::initGlobalSettings(bool test_mode)
 	m_settings->registerSetting({"LWJGLDir", "LwjglDir"}, "lwjgl");
 	m_settings->registerSetting("IconsDir", "icons");
 
+	// Share identical mods and resource packs between instances
+	m_settings->registerSetting("UseContentStore", false);
+
 	// Editors
 	m_settings->registerSetting("JsonEditor", QString());
 
@@ -475,6 +489,10 @@ void MultiMC::initGlobalSettings(bool test_mode)
 	m_settings->registerSetting({"ProxyUser", "ProxyUsername"}, "");
 	m_settings->registerSetting({"ProxyPass", "ProxyPassword"}, "");
 
+	// Download limits, shared by all running downloads
+	m_settings->registerSetting("MaxConcurrentDownloads", 16);
+	m_settings->registerSetting("MaxConcurrentDownloadsPerHost", 6);
+
 	// Memory
 	m_settings->registerSetting({"MinMemAlloc", "MinMemoryAlloc"}, 512);
 	m_settings->registerSetting({"MaxMemAlloc", "MaxMemoryAlloc"}, 1024);
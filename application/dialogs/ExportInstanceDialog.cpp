@@ -16,7 +16,7 @@
 #include "ExportInstanceDialog.h"
 #include "ui_ExportInstanceDialog.h"
 #include <BaseInstance.h>
-#include <MMCZip.h>
+#include <ExportZipTask.h>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <qfilesystemmodel.h>
@@ -28,6 +28,7 @@
 #include "MMCStrings.h"
 #include "SeparatorPrefixTree.h"
 #include "MultiMC.h"
+#include "ProgressDialog.h"
 #include <icons/IconList.h>
 #include <FileSystem.h>
 
@@ -405,9 +406,12 @@ bool ExportInstanceDialog::doExport()
 
 	SaveIcon(m_instance);
 
-	if (!MMCZip::compressDir(output, m_instance->instanceRoot(), name, &proxyModel->blockedPaths()))
+	ExportZipTask task(output, m_instance->instanceRoot(), name, proxyModel->blockedPaths());
+	ProgressDialog progress(this);
+	progress.execWithTask(&task);
+	if (!task.successful())
 	{
-		QMessageBox::warning(this, tr("Error"), tr("Unable to export instance"));
+		QMessageBox::warning(this, tr("Error"), tr("Unable to export instance: %1").arg(task.failReason()));
 		return false;
 	}
 	return true;
@@ -121,25 +121,54 @@ void OtherLogsPage::on_btnReload_clicked()
 				tr("The file (%1) is too big. You may want to open it in a viewer optimized "
 				   "for large files.").arg(file.fileName()));
 		};
-		if(file.size() > (1024ll * 1024ll * 12ll))
-		{
-			showTooBig();
-			return;
-		}
+		const qint64 limit = 1024ll * 1024ll * 12ll;
 		QString content;
 		if(file.fileName().endsWith(".gz"))
 		{
+			// the size is in the gzip trailer, no need to inflate anything to know it's too big
+			GZipReader reader(&file);
+			if(!reader.open(QIODevice::ReadOnly | QIODevice::Unbuffered))
+			{
+				ui->text->setPlainText(
+					tr("The file (%1) is not readable.").arg(file.fileName()));
+				return;
+			}
+			if(reader.uncompressedSize() > limit)
+			{
+				showTooBig();
+				return;
+			}
 			QByteArray temp;
-			if(!GZip::unzip(file.readAll(), temp))
+			temp.reserve(int(qMax(reader.uncompressedSize(), 0ll)) + 1);
+			while(temp.size() <= limit)
+			{
+				auto chunk = reader.read(64 * 1024);
+				if(chunk.isEmpty())
+				{
+					break;
+				}
+				temp.append(chunk);
+			}
+			if(reader.hasError())
 			{
 				ui->text->setPlainText(
 					tr("The file (%1) is not readable.").arg(file.fileName()));
 				return;
 			}
+			if(temp.size() > limit)
+			{
+				showTooBig();
+				return;
+			}
 			content = QString::fromUtf8(temp);
 		}
 		else
 		{
+			if(file.size() > limit)
+			{
+				showTooBig();
+				return;
+			}
 			content = QString::fromUtf8(file.readAll());
 		}
 		if (content.size() >= 50000000ll)
@@ -0,0 +1,441 @@
+/*
+ * Benchmark and regression check for the xz-embedded and pack200 decoders.
+ *
+ * Every fixture is a pack200 archive compressed with xz, like the Forge library downloads.
+ * Each one is decoded in stages, and the output is checked against fixtures/expected.txt:
+ *   xz             - xz-embedded in multi-call mode (XZ_DYNALLOC, 64 MiB dictionary limit)
+ *   pack200-serial - unpacking the pack200 data with the jar written on the calling thread
+ *   pack200        - unpacking with the jar entries compressed on all cores
+ *   pack.xz        - both, the way a Forge download gets installed
+ *
+ * For every stage, the throughput, the peak heap use and the number of allocations are reported.
+ * Memory is only tracked with glibc.
+ *
+ * Run like this:
+ *   decoder_benchmark [--quick] [--json results.json] [--fixtures dir] [more.pack.xz ...]
+ *
+ * --quick decodes everything just once, for checking the results.
+ * Additional files are measured, but not checked.
+ * The exit code is nonzero when anything failed to decode or didn't match the expectations.
+ */
+
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <zlib.h>
+
+#include "xz.h"
+#include "unpack200.h"
+
+namespace
+{
+std::atomic<int64_t> heapCurrent(0);
+std::atomic<int64_t> heapPeak(0);
+std::atomic<int64_t> allocationCount(0);
+
+void trackAllocation(int64_t size)
+{
+	allocationCount++;
+	int64_t current = (heapCurrent += size);
+	int64_t peak = heapPeak;
+	while (current > peak && !heapPeak.compare_exchange_weak(peak, current))
+	{
+	}
+}
+
+void trackFree(int64_t size)
+{
+	heapCurrent -= size;
+}
+}
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+
+// Everything, including xz-embedded, pack200, zlib and operator new, allocates through these.
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+
+void *malloc(size_t size)
+{
+	void *ptr = __libc_malloc(size);
+	if (ptr)
+		trackAllocation(malloc_usable_size(ptr));
+	return ptr;
+}
+
+void *calloc(size_t count, size_t size)
+{
+	void *ptr = __libc_calloc(count, size);
+	if (ptr)
+		trackAllocation(malloc_usable_size(ptr));
+	return ptr;
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	int64_t before = ptr ? malloc_usable_size(ptr) : 0;
+	void *result = __libc_realloc(ptr, size);
+	if (result)
+	{
+		trackFree(before);
+		trackAllocation(malloc_usable_size(result));
+	}
+	else if (size == 0)
+	{
+		trackFree(before);
+	}
+	return result;
+}
+
+void free(void *ptr)
+{
+	if (ptr)
+		trackFree(malloc_usable_size(ptr));
+	__libc_free(ptr);
+}
+}
+#define HAVE_ALLOCATION_STATS 1
+#else
+#define HAVE_ALLOCATION_STATS 0
+#endif
+
+namespace
+{
+// What the fixture has to decode to
+struct Expectation
+{
+	uint64_t packSize = 0;
+	uint32_t packCrc = 0;
+	uint32_t jarEntries = 0;
+	uint32_t jarCrc = 0;
+};
+
+struct Result
+{
+	std::string fixture;
+	std::string stage;
+	uint64_t inputBytes = 0;
+	uint64_t outputBytes = 0;
+	int iterations = 0;
+	double seconds = 0;
+	int64_t peakHeap = -1;
+	int64_t allocations = -1;
+	bool verified = false;
+};
+
+std::string readFile(const std::string &path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		throw std::runtime_error("can't read " + path);
+	std::stringstream buffer;
+	buffer << file.rdbuf();
+	return buffer.str();
+}
+
+std::map<std::string, Expectation> readExpectations(const std::string &path)
+{
+	std::map<std::string, Expectation> expectations;
+	std::istringstream in(readFile(path));
+	std::string line;
+	while (std::getline(in, line))
+	{
+		if (line.empty() || line[0] == '#')
+			continue;
+		std::istringstream fields(line);
+		std::string name;
+		Expectation expected;
+		fields >> name >> expected.packSize >> std::hex >> expected.packCrc >> std::dec >>
+			expected.jarEntries >> std::hex >> expected.jarCrc;
+		if (!fields)
+			throw std::runtime_error("bad line in " + path + ": " + line);
+		expectations[name] = expected;
+	}
+	return expectations;
+}
+
+uint32_t crc(const std::string &data)
+{
+	return crc32(crc32(0, Z_NULL, 0), (const Bytef *)data.data(), (uInt)data.size());
+}
+
+uint32_t le(const std::string &data, size_t offset, int bytes)
+{
+	if (offset + bytes > data.size())
+		throw std::runtime_error("jar is truncated");
+	uint32_t value = 0;
+	for (int i = bytes - 1; i >= 0; i--)
+		value = (value << 8) | (uint8_t)data[offset + i];
+	return value;
+}
+
+// CRC-32 over the names, sizes and CRC-32s in the central directory of the jar
+uint32_t jarDigest(const std::string &jar, uint32_t &entries)
+{
+	size_t end = jar.rfind(std::string("PK\x05\x06", 4));
+	if (end == std::string::npos)
+		throw std::runtime_error("jar has no central directory");
+	entries = le(jar, end + 10, 2);
+	size_t offset = le(jar, end + 16, 4);
+	uint32_t digest = crc32(0, Z_NULL, 0);
+	for (uint32_t i = 0; i < entries; i++)
+	{
+		if (le(jar, offset, 4) != 0x02014b50)
+			throw std::runtime_error("broken central directory");
+		uint32_t nameLength = le(jar, offset + 28, 2);
+		uint32_t extraLength = le(jar, offset + 30, 2);
+		uint32_t commentLength = le(jar, offset + 32, 2);
+		// name, then uncompressed size and crc as they are stored
+		digest = crc32(digest, (const Bytef *)jar.data() + offset + 46, nameLength);
+		digest = crc32(digest, (const Bytef *)jar.data() + offset + 24, 4);
+		digest = crc32(digest, (const Bytef *)jar.data() + offset + 16, 4);
+		offset += 46 + nameLength + extraLength + commentLength;
+	}
+	return digest;
+}
+
+// Decode a whole xz stream the way ForgeXzDownload does
+std::string decodeXz(const std::string &input)
+{
+	struct xz_dec *decoder = xz_dec_init(XZ_DYNALLOC, 1 << 26);
+	if (!decoder)
+		throw std::runtime_error("can't create the xz decoder");
+	std::string output;
+	std::vector<uint8_t> buffer(64 * 1024);
+	struct xz_buf b;
+	b.in = (const uint8_t *)input.data();
+	b.in_pos = 0;
+	b.in_size = input.size();
+	b.out = buffer.data();
+	b.out_size = buffer.size();
+	enum xz_ret ret;
+	do
+	{
+		b.out_pos = 0;
+		ret = xz_dec_run(decoder, &b);
+		output.append((const char *)buffer.data(), b.out_pos);
+	} while (ret == XZ_OK && (b.in_pos < b.in_size || b.out_pos == b.out_size));
+	xz_dec_end(decoder);
+	if (ret != XZ_STREAM_END)
+		throw std::runtime_error("xz decoding failed with code " + std::to_string(ret));
+	return output;
+}
+
+std::string unpack(const std::string &pack, int threads)
+{
+	std::string jar;
+	unpack_200_set_deflate_threads(threads);
+	unpack_200(pack.data(), pack.size(), jar);
+	return jar;
+}
+
+// Run the stage until enough time passed. Memory use is taken from the first run.
+template <typename Function>
+Result measure(const std::string &fixture, const std::string &stage, uint64_t inputBytes,
+			   bool quick, Function function, std::string &output)
+{
+	using clock = std::chrono::steady_clock;
+	Result result;
+	result.fixture = fixture;
+	result.stage = stage;
+	result.inputBytes = inputBytes;
+
+	int64_t baseline = heapCurrent;
+	heapPeak = baseline;
+	int64_t allocationsBefore = allocationCount;
+	auto start = clock::now();
+	output = function();
+	std::chrono::duration<double> elapsed = clock::now() - start;
+	if (HAVE_ALLOCATION_STATS)
+	{
+		result.peakHeap = heapPeak - baseline;
+		result.allocations = allocationCount - allocationsBefore;
+	}
+	result.iterations = 1;
+	while (!quick && (elapsed.count() < 1.0 || result.iterations < 3))
+	{
+		function();
+		result.iterations++;
+		elapsed = clock::now() - start;
+	}
+	result.seconds = elapsed.count();
+	result.outputBytes = output.size();
+	return result;
+}
+
+double megabytesPerSecond(uint64_t bytes, const Result &result)
+{
+	return bytes * (double)result.iterations / (1024.0 * 1024.0) / result.seconds;
+}
+
+void print(const Result &result)
+{
+	std::cout << std::left << std::setw(20) << result.fixture << std::setw(16) << result.stage
+			  << std::right << std::fixed << std::setprecision(1) << std::setw(8)
+			  << megabytesPerSecond(result.inputBytes, result) << " MB/s in" << std::setw(8)
+			  << megabytesPerSecond(result.outputBytes, result) << " MB/s out";
+	if (result.peakHeap >= 0)
+	{
+		std::cout << std::setw(10) << result.peakHeap / 1024 << " KiB peak" << std::setw(8)
+				  << result.allocations << " allocations";
+	}
+	std::cout << (result.verified ? "" : "  UNVERIFIED") << std::endl;
+}
+
+std::string jsonString(const std::string &value)
+{
+	std::string out = "\"";
+	for (char c : value)
+	{
+		if (c == '"' || c == '\\')
+			out += '\\';
+		out += c;
+	}
+	return out + "\"";
+}
+
+void writeJson(const std::string &path, const std::vector<Result> &results, bool ok)
+{
+	std::ofstream out(path);
+	out << "{\n";
+	out << "  \"cores\": " << std::thread::hardware_concurrency() << ",\n";
+	out << "  \"allocation_stats\": " << (HAVE_ALLOCATION_STATS ? "true" : "false") << ",\n";
+	out << "  \"ok\": " << (ok ? "true" : "false") << ",\n";
+	out << "  \"results\": [\n";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		auto &r = results[i];
+		out << "    {\"fixture\": " << jsonString(r.fixture) << ", \"stage\": " << jsonString(r.stage)
+			<< ", \"input_bytes\": " << r.inputBytes << ", \"output_bytes\": " << r.outputBytes
+			<< ", \"iterations\": " << r.iterations << ", \"seconds\": " << r.seconds
+			<< ", \"input_mb_per_s\": " << megabytesPerSecond(r.inputBytes, r)
+			<< ", \"output_mb_per_s\": " << megabytesPerSecond(r.outputBytes, r)
+			<< ", \"peak_heap_bytes\": " << r.peakHeap << ", \"allocations\": " << r.allocations
+			<< ", \"verified\": " << (r.verified ? "true" : "false") << "}"
+			<< (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	out << "  ]\n}\n";
+	if (!out)
+		throw std::runtime_error("can't write " + path);
+}
+
+// Measure all the stages of one fixture. Returns false if the output doesn't match.
+bool runFixture(const std::string &path, const std::string &name, const Expectation *expected,
+				bool quick, std::vector<Result> &results)
+{
+	std::string xz = readFile(path);
+	std::string pack, serialJar, jar, pipelineJar;
+
+	auto xzResult = measure(name, "xz", xz.size(), quick, [&]() { return decodeXz(xz); }, pack);
+	auto serialResult = measure(name, "pack200-serial", pack.size(), quick,
+								[&]() { return unpack(pack, 1); }, serialJar);
+	auto parallelResult =
+		measure(name, "pack200", pack.size(), quick, [&]() { return unpack(pack, 0); }, jar);
+	auto pipelineResult = measure(name, "pack.xz", xz.size(), quick,
+								  [&]() { return unpack(decodeXz(xz), 0); }, pipelineJar);
+
+	bool ok = true;
+	if (serialJar != jar || pipelineJar != jar)
+	{
+		std::cerr << name << ": the jars from the different stages are not the same" << std::endl;
+		ok = false;
+	}
+	if (expected)
+	{
+		uint32_t entries = 0;
+		uint32_t digest = jarDigest(jar, entries);
+		if (pack.size() != expected->packSize || crc(pack) != expected->packCrc)
+		{
+			std::cerr << name << ": xz output doesn't match, got " << pack.size() << " bytes, crc "
+					  << std::hex << crc(pack) << std::dec << std::endl;
+			ok = false;
+		}
+		if (entries != expected->jarEntries || digest != expected->jarCrc)
+		{
+			std::cerr << name << ": jar doesn't match, got " << entries << " entries, digest "
+					  << std::hex << digest << std::dec << std::endl;
+			ok = false;
+		}
+	}
+	for (auto result : {xzResult, serialResult, parallelResult, pipelineResult})
+	{
+		result.verified = ok && expected != nullptr;
+		print(result);
+		results.push_back(result);
+	}
+	return ok;
+}
+}
+
+int main(int argc, char **argv)
+{
+	bool quick = false;
+	std::string jsonPath;
+	std::string fixtureDir = FIXTURE_DIR;
+	std::vector<std::string> extraFiles;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--quick")
+			quick = true;
+		else if (arg == "--json" && i + 1 < argc)
+			jsonPath = argv[++i];
+		else if (arg == "--fixtures" && i + 1 < argc)
+			fixtureDir = argv[++i];
+		else
+			extraFiles.push_back(arg);
+	}
+
+	xz_crc32_init();
+	xz_crc64_init();
+
+	bool ok = true;
+	std::vector<Result> results;
+	try
+	{
+		auto expectations = readExpectations(fixtureDir + "/expected.txt");
+		for (auto &item : expectations)
+		{
+			ok &= runFixture(fixtureDir + "/" + item.first, item.first, &item.second, quick,
+							 results);
+		}
+		for (auto &file : extraFiles)
+		{
+			ok &= runFixture(file, file, nullptr, quick, results);
+		}
+	}
+	catch (std::runtime_error &e)
+	{
+		std::cerr << "Benchmark failed: " << e.what() << std::endl;
+		ok = false;
+	}
+
+	if (!jsonPath.empty())
+	{
+		try
+		{
+			writeJson(jsonPath, results, ok);
+		}
+		catch (std::runtime_error &e)
+		{
+			std::cerr << e.what() << std::endl;
+			ok = false;
+		}
+	}
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -25,6 +25,19 @@
 
 #pragma once
 #include <string>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Set how many threads compress the entries of the jar files being written
+ *
+ * The jar contents are the same no matter how many threads are used.
+ * Applies to all the following unpack_200 calls.
+ *
+ * @param threads 0 for one thread per core (the default), 1 to compress on the calling thread
+ */
+void unpack_200_set_deflate_threads(int threads);
 
 /**
  * @brief Unpack a PACK200 file
@@ -34,3 +47,64 @@
  * @throw std::runtime_error for any error encountered
  */
 void unpack_200(FILE * input_path, FILE * output_path);
+
+/**
+ * @brief Input callback for unpack_200
+ *
+ * Should fill buf with up to len bytes of input.
+ *
+ * @return number of bytes stored in buf, 0 at the end of the input, negative on error
+ */
+typedef int64_t (*unpack_200_read_fn)(void *context, void *buf, int64_t len);
+
+/**
+ * @brief Unpack a PACK200 stream supplied by a callback
+ *
+ * @param read The input callback
+ * @param context Passed to every call of the input callback
+ * @param output Handle the unpacked jar is written to. The function takes ownership of it.
+ * @throw std::runtime_error for any error encountered
+ */
+void unpack_200(unpack_200_read_fn read, void *context, FILE * output);
+
+/**
+ * @brief Output callback for unpack_200
+ *
+ * Should consume all len bytes in buf.
+ *
+ * @return number of bytes consumed. Anything other than len is treated as an error.
+ */
+typedef int64_t (*unpack_200_write_fn)(void *context, const void *buf, int64_t len);
+
+/**
+ * @brief Unpack a PACK200 stream supplied by a callback into an output callback
+ *
+ * @param read The input callback
+ * @param read_context Passed to every call of the input callback
+ * @param write The output callback
+ * @param write_context Passed to every call of the output callback
+ * @throw std::runtime_error for any error encountered
+ */
+void unpack_200(unpack_200_read_fn read, void *read_context, unpack_200_write_fn write,
+				void *write_context);
+
+/**
+ * @brief Unpack a PACK200 file held in memory into an output callback
+ *
+ * @param input The PACK200 data
+ * @param size Size of the PACK200 data in bytes
+ * @param write The output callback
+ * @param write_context Passed to every call of the output callback
+ * @throw std::runtime_error for any error encountered
+ */
+void unpack_200(const void *input, size_t size, unpack_200_write_fn write, void *write_context);
+
+/**
+ * @brief Unpack a PACK200 file held in memory into a memory buffer
+ *
+ * @param input The PACK200 data
+ * @param size Size of the PACK200 data in bytes
+ * @param output Receives the jar file. Anything already in it is replaced.
+ * @throw std::runtime_error for any error encountered
+ */
+void unpack_200(const void *input, size_t size, std::string &output);
@@ -3509,6 +3509,8 @@ void unpacker::reset()
 
 	// restore selected interface state:
 	infileptr = save_u.infileptr;
+	input_callback = save_u.input_callback;
+	input_context = save_u.input_context;
 	inbytes = save_u.inbytes;
 	jarout = save_u.jarout;
 	gzin = save_u.gzin;
@@ -159,6 +159,9 @@ struct unpacker
 
 	// if running Unix-style, here are the inputs and outputs
 	FILE *infileptr; // buffered
+	// if reading from a user supplied callback
+	int64_t (*input_callback)(void *context, void *buf, int64_t len);
+	void *input_context;
 	bytes inbytes;   // direct
 	gunzip *gzin;	// gunzip filter, if any
 	jar *jarout;	 // output JAR file
@@ -33,6 +33,9 @@
 #include <time.h>
 #include <stdint.h>
 
+#include <atomic>
+#include <thread>
+
 #include "constants.h"
 #include "utils.h"
 #include "defines.h"
@@ -42,6 +45,22 @@
 #include "unpack.h"
 #include "zip.h"
 
+// See unpack_200_set_deflate_threads
+static std::atomic<int> deflate_threads(0);
+
+void unpack_200_set_deflate_threads(int threads)
+{
+	deflate_threads = threads;
+}
+
+static int get_deflate_threads()
+{
+	int threads = deflate_threads;
+	if (threads <= 0)
+		threads = (int)std::thread::hardware_concurrency();
+	return threads > 0 ? threads : 1;
+}
+
 // Callback for fetching data, Unix style.
 static int64_t read_input_via_stdio(unpacker *u, void *buf, int64_t minlen, int64_t maxlen)
 {
@@ -71,6 +90,56 @@ static int64_t read_input_via_stdio(unpacker *u, void *buf, int64_t minlen, int6
 	return numread;
 }
 
+// Input held in memory
+struct memory_input
+{
+	const char *data;
+	size_t size;
+	size_t position;
+};
+
+// Callback for fetching data from a memory buffer.
+static int64_t read_memory_input(void *context, void *buf, int64_t len)
+{
+	memory_input *input = (memory_input *)context;
+	size_t left = input->size - input->position;
+	if ((uint64_t)len > left)
+		len = (int64_t)left;
+	memcpy(buf, input->data + input->position, (size_t)len);
+	input->position += (size_t)len;
+	return len;
+}
+
+// Callback for collecting the output in a string.
+static int64_t write_string_output(void *context, const void *buf, int64_t len)
+{
+	((std::string *)context)->append((const char *)buf, (size_t)len);
+	return len;
+}
+
+// Callback for fetching data from the user supplied input callback.
+static int64_t read_input_via_callback(unpacker *u, void *buf, int64_t minlen, int64_t maxlen)
+{
+	assert(u->input_callback != nullptr);
+	assert(minlen <= maxlen); // don't talk nonsense
+	int64_t numread = 0;
+	char *bufptr = (char *)buf;
+	while (numread < minlen)
+	{
+		int64_t nr = u->input_callback(u->input_context, bufptr, maxlen - numread);
+		if (nr < 0)
+		{
+			unpack_abort("error reading input");
+		}
+		if (nr == 0)
+			break;
+		numread += nr;
+		bufptr += nr;
+		assert(numread <= maxlen);
+	}
+	return numread;
+}
+
 enum
 {
 	EOF_MAGIC = 0,
@@ -94,20 +163,8 @@ static int read_magic(unpacker *u, char peek[], int peeklen)
 	return magic;
 }
 
-void unpack_200(FILE *input, FILE *output)
+static void unpack_200_segments(unpacker &u)
 {
-	unpacker u;
-	u.init(read_input_via_stdio);
-
-	// initialize jar output
-	// the output takes ownership of the file handle
-	jar jarout;
-	jarout.init(&u);
-	jarout.jarfp = output;
-
-	// the input doesn't
-	u.infileptr = input;
-
 	// read the magic!
 	char peek[4];
 	int magic;
@@ -157,6 +214,81 @@ void unpack_200(FILE *input, FILE *output)
 		u.start(peek, sizeof(peek));
 	}
 	u.finish();
+}
+
+// Runs the unpacker with the input already set up. The output goes either to the file or to the
+// callback.
+static void unpack_200_run(unpacker &u, FILE *output, unpack_200_write_fn write,
+						   void *write_context)
+{
+	// initialize jar output
+	// the output takes ownership of the file handle
+	jar jarout;
+	jarout.init(&u);
+	jarout.jarfp = output;
+	jarout.write_callback = write;
+	jarout.write_context = write_context;
+	jarout.deflate_threads = get_deflate_threads();
+
+	try
+	{
+		unpack_200_segments(u);
+	}
+	catch (...)
+	{
+		// don't leak the unpacker state. The file handle is left alone.
+		u.free();
+		throw;
+	}
 	u.free(); // tidy up malloc blocks
+}
+
+void unpack_200(FILE *input, FILE *output)
+{
+	unpacker u;
+	u.init(read_input_via_stdio);
+
+	u.infileptr = input;
+
+	unpack_200_run(u, output, nullptr, nullptr);
 	fclose(input);
 }
+
+void unpack_200(unpack_200_read_fn read, void *context, FILE *output)
+{
+	unpacker u;
+	u.init(read_input_via_callback);
+	u.input_callback = read;
+	u.input_context = context;
+
+	unpack_200_run(u, output, nullptr, nullptr);
+}
+
+void unpack_200(unpack_200_read_fn read, void *read_context, unpack_200_write_fn write,
+				void *write_context)
+{
+	if (write == nullptr)
+	{
+		unpack_abort("no output callback");
+	}
+	unpacker u;
+	u.init(read_input_via_callback);
+	u.input_callback = read;
+	u.input_context = read_context;
+
+	unpack_200_run(u, nullptr, write, write_context);
+}
+
+void unpack_200(const void *input, size_t size, unpack_200_write_fn write, void *write_context)
+{
+	memory_input in = {(const char *)input, size, 0};
+	unpack_200(read_memory_input, &in, write, write_context);
+}
+
+void unpack_200(const void *input, size_t size, std::string &output)
+{
+	output.clear();
+	// the jar is usually bigger than the pack, this saves a few reallocations
+	output.reserve(size * 2);
+	unpack_200(input, size, write_string_output, &output);
+}
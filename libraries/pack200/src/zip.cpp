@@ -35,6 +35,16 @@
 #include <stdlib.h>
 #include <assert.h>
 
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
 #ifndef _MSC_VER
 #include <strings.h>
 #endif
@@ -66,6 +76,122 @@ inline uint32_t jar::get_crc32(uint32_t c, uchar *ptr, uint32_t len)
 
 #define GET_INT_HI(a) SWAP_BYTES((a >> 16) & 0xFFFF);
 
+static bool deflate_into(bytes &head, bytes &tail, uchar *out, size_t outlen, size_t &clen);
+
+// A jar entry that is compressed in the background
+struct deflate_job
+{
+	std::string name;
+	int modtime;
+	bool deflate;
+	// private copy of the entry data, the unpacker reuses its buffers
+	std::vector<uchar> data;
+	std::vector<uchar> deflated;
+	uint32_t crc;
+	bool done;
+
+	void run()
+	{
+		crc = crc32(crc32(0, Z_NULL, 0), data.data(), (uInt)data.size());
+		if (!deflate)
+			return;
+		bytes head, tail;
+		head.set((byte *)data.data(), data.size());
+		tail.set(nullptr, 0);
+		size_t clen = 0;
+		try
+		{
+			// same buffer size as the serial path, so the results are the same
+			deflated.resize(data.size() + (data.size() / 2));
+			deflate = deflate_into(head, tail, deflated.data(), deflated.size(), clen);
+		}
+		catch (std::bad_alloc &)
+		{
+			deflate = false;
+		}
+		deflated.resize(deflate ? clen : 0);
+	}
+};
+
+// Worker threads compressing entries, and the entries in output order
+struct deflate_pool
+{
+	std::mutex lock;
+	// signalled when there is something in the queue, or when stopping
+	std::condition_variable work_ready;
+	// signalled when a job is done
+	std::condition_variable job_done;
+	// jobs nobody has started yet
+	std::deque<deflate_job *> queue;
+	// all the jobs that weren't written yet, in output order
+	std::deque<std::unique_ptr<deflate_job>> pending;
+	std::vector<std::thread> workers;
+	bool stopping = false;
+
+	explicit deflate_pool(int threads)
+	{
+		try
+		{
+			for (int i = 0; i < threads; i++)
+			{
+				workers.emplace_back(&deflate_pool::work, this);
+			}
+		}
+		catch (...)
+		{
+			stop();
+			throw;
+		}
+	}
+
+	~deflate_pool()
+	{
+		stop();
+	}
+
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> l(lock);
+			stopping = true;
+		}
+		work_ready.notify_all();
+		for (auto &worker : workers)
+		{
+			worker.join();
+		}
+		workers.clear();
+	}
+
+	void submit(deflate_job *job)
+	{
+		{
+			std::lock_guard<std::mutex> l(lock);
+			pending.emplace_back(job);
+			queue.push_back(job);
+		}
+		work_ready.notify_one();
+	}
+
+	void work()
+	{
+		std::unique_lock<std::mutex> l(lock);
+		for (;;)
+		{
+			work_ready.wait(l, [this]() { return stopping || !queue.empty(); });
+			if (stopping)
+				return;
+			deflate_job *job = queue.front();
+			queue.pop_front();
+			l.unlock();
+			job->run();
+			l.lock();
+			job->done = true;
+			job_done.notify_all();
+		}
+	}
+};
+
 void jar::init(unpacker *u_)
 {
 	BYTES_OF(*this).clear();
@@ -73,16 +199,33 @@ void jar::init(unpacker *u_)
 	u->jarout = this;
 }
 
+void jar::free()
+{
+	// stops the workers and drops anything that wasn't written
+	delete pool;
+	pool = nullptr;
+	central_directory.free();
+	deflated.free();
+}
+
 // Write data to the ZIP output stream.
 void jar::write_data(void *buff, int len)
 {
+	if (write_callback != nullptr)
+	{
+		if (len > 0 && write_callback(write_context, buff, len) != len)
+		{
+			unpack_abort("error writing output");
+		}
+		output_file_offset += len;
+		return;
+	}
 	while (len > 0)
 	{
 		int rc = (int)fwrite(buff, 1, len, jarfp);
 		if (rc <= 0)
 		{
-			fprintf(stderr, "Error: write on output file failed err=%d\n", errno);
-			exit(1); // Called only from the native standalone unpacker
+			unpack_abort("error writing output file");
 		}
 		output_file_offset += rc;
 		buff = ((char *)buff) + rc;
@@ -255,6 +398,16 @@ void jar::openJarFile(const char *fname)
 	}
 }
 
+// Write the headers and the (possibly compressed) data of an entry
+void jar::write_entry(const char *fname, bool store, int modtime, int len, int clen,
+					  uint32_t crc, bytes &part1, bytes &part2)
+{
+	add_to_jar_directory(fname, store, modtime, len, clen, crc);
+	write_jar_header(fname, store, modtime, len, clen, crc);
+	write_data(part1);
+	write_data(part2);
+}
+
 // Add a ZIP entry and copy the file data
 void jar::addJarEntry(const char *fname, bool deflate_hint, int modtime, bytes &head,
 					  bytes &tail)
@@ -262,14 +415,32 @@ void jar::addJarEntry(const char *fname, bool deflate_hint, int modtime, bytes &
 	int len = (int)(head.len + tail.len);
 	int clen = 0;
 
+	bool deflate = (deflate_hint && len > 0);
+
+	if (deflate_threads > 1 && pool == nullptr)
+	{
+		try
+		{
+			pool = new deflate_pool(deflate_threads);
+		}
+		catch (std::system_error &)
+		{
+			// no threads for us, do it the old way
+			deflate_threads = 0;
+		}
+	}
+	if (pool != nullptr)
+	{
+		add_jar_entry_async(fname, deflate, modtime, head, tail);
+		return;
+	}
+
 	uint32_t crc = get_crc32(0, Z_NULL, 0);
 	if (head.len != 0)
 		crc = get_crc32(crc, (uchar *)head.ptr, (uint32_t)head.len);
 	if (tail.len != 0)
 		crc = get_crc32(crc, (uchar *)tail.ptr, (uint32_t)tail.len);
 
-	bool deflate = (deflate_hint && len > 0);
-
 	if (deflate)
 	{
 		if (deflate_bytes(head, tail) == false)
@@ -278,17 +449,71 @@ void jar::addJarEntry(const char *fname, bool deflate_hint, int modtime, bytes &
 		}
 	}
 	clen = (int)((deflate) ? deflated.size() : len);
-	add_to_jar_directory(fname, !deflate, modtime, len, clen, crc);
-	write_jar_header(fname, !deflate, modtime, len, clen, crc);
-
 	if (deflate)
 	{
-		write_data(deflated.b);
+		bytes none;
+		none.set(nullptr, 0);
+		write_entry(fname, !deflate, modtime, len, clen, crc, deflated.b, none);
 	}
 	else
 	{
-		write_data(head);
-		write_data(tail);
+		write_entry(fname, !deflate, modtime, len, clen, crc, head, tail);
+	}
+}
+
+// Hand the entry to the workers. It gets written by write_finished_entries once it and
+// everything before it is compressed, so the jar looks exactly the same as when written serially.
+void jar::add_jar_entry_async(const char *fname, bool deflate, int modtime, bytes &head,
+							  bytes &tail)
+{
+	deflate_job *job = new deflate_job();
+	job->name = fname;
+	job->modtime = modtime;
+	job->deflate = deflate;
+	job->data.reserve(head.len + tail.len);
+	job->data.insert(job->data.end(), (uchar *)head.ptr, (uchar *)head.ptr + head.len);
+	job->data.insert(job->data.end(), (uchar *)tail.ptr, (uchar *)tail.ptr + tail.len);
+	job->crc = 0;
+	job->done = false;
+	pool->submit(job);
+
+	// keep a few entries per thread in flight, so the workers never run dry and
+	// memory use stays bounded
+	write_finished_entries(deflate_threads * 4);
+}
+
+// Write the finished entries at the front of the queue, waiting until no more than keep
+// entries are left.
+void jar::write_finished_entries(size_t keep)
+{
+	if (pool == nullptr)
+		return;
+	for (;;)
+	{
+		std::unique_ptr<deflate_job> job;
+		{
+			std::unique_lock<std::mutex> l(pool->lock);
+			if (pool->pending.empty())
+				return;
+			deflate_job *front = pool->pending.front().get();
+			if (!front->done)
+			{
+				if (pool->pending.size() <= keep)
+					return;
+				pool->job_done.wait(l, [front]() { return front->done; });
+			}
+			job = std::move(pool->pending.front());
+			pool->pending.pop_front();
+		}
+		int len = (int)job->data.size();
+		bytes part1, none;
+		none.set(nullptr, 0);
+		if (job->deflate)
+			part1.set((byte *)job->deflated.data(), job->deflated.size());
+		else
+			part1.set((byte *)job->data.data(), job->data.size());
+		write_entry(job->name.c_str(), !job->deflate, job->modtime, len, (int)part1.len,
+					job->crc, part1, none);
 	}
 }
 
@@ -303,7 +528,13 @@ void jar::addDirectoryToJarFile(const char *dir_name)
 // Write out the central directory and close the jar file.
 void jar::closeJarFile(bool central)
 {
-	if (jarfp)
+	write_finished_entries(0);
+	if (write_callback)
+	{
+		if (central)
+			write_central_directory();
+	}
+	else if (jarfp)
 	{
 		fflush(jarfp);
 		if (central)
@@ -357,6 +588,21 @@ uint32_t jar::get_dostime(int modtime)
    input data
 */
 bool jar::deflate_bytes(bytes &head, bytes &tail)
+{
+	int len = (int)(head.len + tail.len);
+	deflated.empty();
+	uchar *out = (uchar *)deflated.grow(len + (len / 2));
+	size_t clen = 0;
+	if (!deflate_into(head, tail, out, deflated.size(), clen))
+		return false;
+	deflated.b.len = clen;
+	return true;
+}
+
+// Compress head and tail into out, which is outlen bytes large. Fails when the result
+// doesn't fit or wouldn't be smaller than the input.
+// Doesn't touch any shared state, so it can run on any thread.
+static bool deflate_into(bytes &head, bytes &tail, uchar *out, size_t outlen, size_t &clen)
 {
 	int len = (int)(head.len + tail.len);
 
@@ -389,9 +635,8 @@ bool jar::deflate_bytes(bytes &head, bytes &tail)
 		return false;
 	}
 
-	deflated.empty();
-	zs.next_out = (uchar *)deflated.grow(len + (len / 2));
-	zs.avail_out = (int)deflated.size();
+	zs.next_out = out;
+	zs.avail_out = (int)outlen;
 
 	zs.next_in = (uchar *)head.ptr;
 	zs.avail_in = (int)head.len;
@@ -424,7 +669,7 @@ bool jar::deflate_bytes(bytes &head, bytes &tail)
 	{
 		if (len > (int)zs.total_out)
 		{
-			deflated.b.len = zs.total_out;
+			clen = zs.total_out;
 			deflateEnd(&zs);
 			return true;
 		}
@@ -28,11 +28,16 @@ typedef unsigned int uint32_t;
 typedef unsigned char uchar;
 
 struct unpacker;
+struct deflate_pool;
 
 struct jar
 {
 	// JAR file writer
 	FILE *jarfp;
+	// Alternative to jarfp, used when it is set: all output is passed to this callback.
+	// It returns the number of bytes it took, anything else than len is an error.
+	int64_t (*write_callback)(void *context, const void *buf, int64_t len);
+	void *write_context;
 	int default_modtime;
 
 	// Used by unix2dostime:
@@ -45,6 +50,11 @@ struct jar
 	uint32_t output_file_offset;
 	fillbytes deflated; // temporary buffer
 
+	// Number of threads compressing entries. 0 or 1 compresses on the calling thread.
+	int deflate_threads;
+	// Entries compressed in the background, waiting to be written in order. Created on demand.
+	deflate_pool *pool;
+
 	// pointer to outer unpacker, for error checks etc.
 	unpacker *u;
 
@@ -57,11 +67,7 @@ struct jar
 
 	void init(unpacker *u_);
 
-	void free()
-	{
-		central_directory.free();
-		deflated.free();
-	}
+	void free();
 
 	void reset()
 	{
@@ -80,6 +86,11 @@ struct jar
 	void write_jar_header(const char *fname, bool store, int modtime, int len, int clen,
 						  unsigned int crc);
 	void write_central_directory();
+	void write_entry(const char *fname, bool store, int modtime, int len, int clen,
+					 uint32_t crc, bytes &part1, bytes &part2);
+	void add_jar_entry_async(const char *fname, bool deflate, int modtime, bytes &head,
+							 bytes &tail);
+	void write_finished_entries(size_t keep);
 	uint32_t dostime(int y, int n, int d, int h, int m, int s);
 	uint32_t get_dostime(int modtime);
 
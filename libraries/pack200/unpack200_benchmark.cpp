@@ -0,0 +1,177 @@
+/*
+ * Measures how fast pack200 files get unpacked, with the jar entries compressed on one thread
+ * and on all cores.
+ *
+ * Run like this:
+ *   unpack200_benchmark [file.pack ...]
+ *
+ * Without any files, a pack with a few MB of text-like resources is generated and used.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "unpack200.h"
+
+namespace
+{
+// pack200 UNSIGNED5 coding: B=5, H=64, L=192
+void putUnsigned5(std::string &out, uint32_t value)
+{
+	for (int i = 0; i < 5; i++)
+	{
+		if (value < 192 || i == 4)
+		{
+			out.push_back((char)value);
+			return;
+		}
+		out.push_back((char)(192 + (value - 192) % 64));
+		value = (value - 192) / 64;
+	}
+}
+
+struct Resource
+{
+	std::string name;
+	std::string data;
+};
+
+// A single segment archive with only resource files, all with the deflate hint.
+// The first resource has to be smaller than 192 bytes, so its size doesn't look like a band
+// coding escape.
+std::string makePack(const std::vector<Resource> &resources)
+{
+	std::string out("\xCA\xFE\xD0\x0D", 4);
+	const uint32_t options = (1 << 4) | (1 << 5); // AO_HAVE_FILE_HEADERS | AO_DEFLATE_HINT
+	// minver, majver, options, archive size hi/lo (unknown), next count, modtime, file count
+	for (uint32_t value : {7u, 150u, options, 0u, 0u, 0u, 0u, (uint32_t)resources.size()})
+		putUnsigned5(out, value);
+	// constant pool: the file names plus the implicit empty string, nothing else
+	putUnsigned5(out, resources.size() + 1);
+	for (int i = 0; i < 7; i++)
+		putUnsigned5(out, 0);
+	// inner classes, class file version, classes
+	for (uint32_t value : {0u, 0u, 49u, 0u})
+		putUnsigned5(out, value);
+	// Utf8 prefixes (nothing shared), suffix lengths and characters
+	for (size_t i = 1; i < resources.size(); i++)
+		out.push_back(0);
+	for (auto &resource : resources)
+		putUnsigned5(out, resource.name.size());
+	for (auto &resource : resources)
+		out += resource.name;
+	// file names, sizes and contents
+	for (size_t i = 0; i < resources.size(); i++)
+		putUnsigned5(out, i + 1);
+	for (auto &resource : resources)
+		putUnsigned5(out, resource.data.size());
+	for (auto &resource : resources)
+		out += resource.data;
+	return out;
+}
+
+// Deterministic text that compresses about as well as class files do
+std::string makeSyntheticPack()
+{
+	static const char *words[] = {
+		"net",	 "minecraft", "forge",  "client", "render", "entity", "block", "world",
+		"item",	"tile",	  "event",  "model",  "texture", "java",   "lang",  "Object",
+		"String", "init",	  "update", "tick",   "<clinit>", "this",  "getX",  "setY"};
+	const size_t wordCount = sizeof(words) / sizeof(words[0]);
+	uint32_t seed = 200;
+	auto next = [&seed]() {
+		seed = seed * 1103515245 + 12345;
+		return (seed >> 16) & 0x7fff;
+	};
+	std::vector<Resource> resources;
+	resources.push_back({"META-INF/MANIFEST.MF", "Manifest-Version: 1.0\r\n\r\n"});
+	for (int i = 0; i < 400; i++)
+	{
+		Resource resource;
+		resource.name = "assets/synthetic/file" + std::to_string(i) + ".txt";
+		size_t size = 1024 + next() % (32 * 1024);
+		while (resource.data.size() < size)
+		{
+			resource.data += words[next() % wordCount];
+			resource.data += (next() % 8) ? ' ' : '\n';
+			if (next() % 4 == 0)
+				resource.data += std::to_string(next());
+		}
+		resources.push_back(resource);
+	}
+	return makePack(resources);
+}
+
+std::string readFile(const char *path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		throw std::runtime_error(std::string("can't read ") + path);
+	std::stringstream buffer;
+	buffer << file.rdbuf();
+	return buffer.str();
+}
+
+// Unpack until at least a second passed. Returns MB of pack input per second.
+double measure(const std::string &pack, int threads, std::string &jar)
+{
+	using clock = std::chrono::steady_clock;
+	unpack_200_set_deflate_threads(threads);
+	int iterations = 0;
+	auto start = clock::now();
+	std::chrono::duration<double> elapsed;
+	do
+	{
+		unpack_200(pack.data(), pack.size(), jar);
+		iterations++;
+		elapsed = clock::now() - start;
+	} while (elapsed.count() < 1.0 || iterations < 3);
+	return (double)pack.size() * iterations / (1024.0 * 1024.0) / elapsed.count();
+}
+
+void run(const std::string &name, const std::string &pack)
+{
+	int cores = (int)std::thread::hardware_concurrency();
+	std::string serialJar, parallelJar;
+	double serial = measure(pack, 1, serialJar);
+	double parallel = measure(pack, 0, parallelJar);
+	std::cout << name << ": " << pack.size() << " bytes packed, " << serialJar.size()
+			  << " bytes of jar" << std::endl;
+	std::cout << "  1 thread:   " << serial << " MB/s" << std::endl;
+	std::cout << "  " << cores << " cores:    " << parallel << " MB/s (" << parallel / serial
+			  << "x)" << std::endl;
+	if (serialJar != parallelJar)
+	{
+		throw std::runtime_error("the jars are different");
+	}
+}
+}
+
+int main(int argc, char **argv)
+{
+	try
+	{
+		if (argc < 2)
+		{
+			run("synthetic", makeSyntheticPack());
+		}
+		for (int i = 1; i < argc; i++)
+		{
+			run(argv[i], readFile(argv[i]));
+		}
+	}
+	catch (std::runtime_error &e)
+	{
+		std::cerr << "Benchmark failed: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
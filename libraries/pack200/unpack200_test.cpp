@@ -0,0 +1,190 @@
+#include <QTest>
+#include <QTemporaryFile>
+#include <QtEndian>
+#include <stdexcept>
+#include <zlib.h>
+#include "TestUtil.h"
+
+#include "unpack200.h"
+
+// resources.pack holds a few resource files and no classes.
+// resources.jar is what unpacking it into a file produces. Its entries are deflated, and the
+// compressed bytes depend on the zlib build, so only what's in the entries is compared.
+#define PACK_FILE QFINDTESTDATA("testdata/resources.pack")
+#define JAR_FILE QFINDTESTDATA("testdata/resources.jar")
+
+namespace
+{
+struct ChunkedInput
+{
+	QByteArray data;
+	int position;
+	int chunkSize;
+};
+
+int64_t readChunked(void *context, void *buf, int64_t len)
+{
+	auto input = (ChunkedInput *)context;
+	int64_t count = qMin<int64_t>(qMin<int64_t>(len, input->chunkSize), input->data.size() - input->position);
+	memcpy(buf, input->data.constData() + input->position, count);
+	input->position += count;
+	return count;
+}
+
+int64_t writeByteArray(void *context, const void *buf, int64_t len)
+{
+	((QByteArray *)context)->append((const char *)buf, len);
+	return len;
+}
+
+int64_t writeFailing(void *, const void *, int64_t)
+{
+	return -1;
+}
+
+struct JarEntry
+{
+	QByteArray name;
+	quint32 crc;
+	QByteArray data;
+};
+
+quint32 le(const QByteArray &data, int offset, int bytes)
+{
+	if (offset < 0 || offset + bytes > data.size())
+		throw std::runtime_error("jar is truncated");
+	auto at = reinterpret_cast<const uchar *>(data.constData()) + offset;
+	return bytes == 2 ? qFromLittleEndian<quint16>(at) : qFromLittleEndian<quint32>(at);
+}
+
+// the entries of a jar in central directory order, with their contents inflated
+QList<JarEntry> readJar(const QByteArray &jar)
+{
+	int end = jar.lastIndexOf(QByteArray("PK\x05\x06", 4));
+	if (end == -1)
+		throw std::runtime_error("jar has no central directory");
+	int count = le(jar, end + 10, 2);
+	int offset = le(jar, end + 16, 4);
+	QList<JarEntry> entries;
+	for (int i = 0; i < count; i++)
+	{
+		if (le(jar, offset, 4) != 0x02014b50)
+			throw std::runtime_error("broken central directory");
+		int method = le(jar, offset + 10, 2);
+		int compressedSize = le(jar, offset + 20, 4);
+		int size = le(jar, offset + 24, 4);
+		int nameLength = le(jar, offset + 28, 2);
+		int local = le(jar, offset + 42, 4);
+		JarEntry entry;
+		entry.crc = le(jar, offset + 16, 4);
+		entry.name = jar.mid(offset + 46, nameLength);
+		offset += 46 + nameLength + le(jar, offset + 30, 2) + le(jar, offset + 32, 2);
+
+		int dataStart = local + 30 + le(jar, local + 26, 2) + le(jar, local + 28, 2);
+		if (dataStart + compressedSize > jar.size())
+			throw std::runtime_error("jar is truncated");
+		if (method == 0)
+		{
+			entry.data = jar.mid(dataStart, size);
+		}
+		else if (method == 8)
+		{
+			entry.data.resize(size);
+			z_stream stream = {};
+			inflateInit2(&stream, -MAX_WBITS);
+			stream.next_in = (Bytef *)jar.constData() + dataStart;
+			stream.avail_in = compressedSize;
+			stream.next_out = (Bytef *)entry.data.data();
+			stream.avail_out = size;
+			int status = inflate(&stream, Z_FINISH);
+			inflateEnd(&stream);
+			if (status != Z_STREAM_END || stream.avail_out != 0)
+				throw std::runtime_error("broken deflate data");
+		}
+		else
+		{
+			throw std::runtime_error("unknown compression method");
+		}
+		entries.append(entry);
+	}
+	return entries;
+}
+
+// same entries with the same contents, no matter how they were compressed
+void compareJars(const QByteArray &actual, const QByteArray &expected)
+{
+	auto actualEntries = readJar(actual);
+	auto expectedEntries = readJar(expected);
+	QVERIFY(!expectedEntries.isEmpty());
+	QCOMPARE(actualEntries.size(), expectedEntries.size());
+	for (int i = 0; i < actualEntries.size(); i++)
+	{
+		auto &entry = actualEntries[i];
+		QCOMPARE(entry.name, expectedEntries[i].name);
+		QCOMPARE(entry.crc, expectedEntries[i].crc);
+		QCOMPARE(entry.data, expectedEntries[i].data);
+		auto data = reinterpret_cast<const Bytef *>(entry.data.constData());
+		QCOMPARE(quint32(crc32(crc32(0, Z_NULL, 0), data, entry.data.size())), entry.crc);
+	}
+}
+}
+
+class Unpack200Test : public QObject
+{
+	Q_OBJECT
+private
+slots:
+	void test_File()
+	{
+		QTemporaryFile output;
+		QVERIFY(output.open());
+		FILE *in = fopen(QFile::encodeName(PACK_FILE).constData(), "rb");
+		FILE *out = fopen(QFile::encodeName(output.fileName()).constData(), "wb");
+		QVERIFY(in && out);
+		unpack_200(in, out);
+		compareJars(output.readAll(), TestsInternal::readFile(JAR_FILE));
+	}
+
+	void test_MemoryToMemory()
+	{
+		auto pack = TestsInternal::readFile(PACK_FILE);
+		std::string jar = "leftovers";
+		unpack_200(pack.constData(), pack.size(), jar);
+		compareJars(QByteArray(jar.data(), jar.size()), TestsInternal::readFile(JAR_FILE));
+	}
+
+	void test_MemoryToCallback()
+	{
+		auto pack = TestsInternal::readFile(PACK_FILE);
+		QByteArray jar;
+		unpack_200(pack.constData(), pack.size(), writeByteArray, &jar);
+		compareJars(jar, TestsInternal::readFile(JAR_FILE));
+	}
+
+	void test_CallbackToCallback()
+	{
+		// the input dribbles in, a few bytes at a time
+		ChunkedInput input = {TestsInternal::readFile(PACK_FILE), 0, 7};
+		QByteArray jar;
+		unpack_200(readChunked, &input, writeByteArray, &jar);
+		compareJars(jar, TestsInternal::readFile(JAR_FILE));
+	}
+
+	void test_WriteError()
+	{
+		auto pack = TestsInternal::readFile(PACK_FILE);
+		QVERIFY_EXCEPTION_THROWN(unpack_200(pack.constData(), pack.size(), writeFailing, nullptr),
+								 std::runtime_error);
+	}
+
+	void test_Truncated()
+	{
+		auto pack = TestsInternal::readFile(PACK_FILE).left(100);
+		std::string jar;
+		QVERIFY_EXCEPTION_THROWN(unpack_200(pack.constData(), pack.size(), jar), std::runtime_error);
+	}
+};
+
+QTEST_GUILESS_MAIN(Unpack200Test)
+
+#include "unpack200_test.moc"